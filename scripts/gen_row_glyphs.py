@@ -0,0 +1,146 @@
+"""Generate src/row_glyphs.h, the pre-rasterized glyph tables used by the row renderer.
+
+Runs as a PlatformIO pre-build script (see extra_scripts in platformio.ini) and
+can also be run by hand: python scripts/gen_row_glyphs.py
+
+The glyphs come from the Adafruit GFX classic 5x7 font (glcdfont.c). When the
+library is installed under .pio/libdeps its font is read directly; otherwise
+the copy of the needed columns below is used. The header is only rewritten
+when its content changes, so unchanged builds are not invalidated.
+"""
+
+import glob
+import os
+import re
+
+# Characters the departure row can contain, in table order. Digits come first
+# so the renderer can index them as c - '0'.
+CHARS = "0123456789:+-!'in"
+
+# Columns of the characters above as they appear in Adafruit GFX glcdfont.c
+# (bit 0 = top row). Used when the library sources are not available.
+FALLBACK_COLUMNS = {
+    "0": (0x3E, 0x51, 0x49, 0x45, 0x3E),
+    "1": (0x00, 0x42, 0x7F, 0x40, 0x00),
+    "2": (0x72, 0x49, 0x49, 0x49, 0x46),
+    "3": (0x21, 0x41, 0x49, 0x4D, 0x33),
+    "4": (0x18, 0x14, 0x12, 0x7F, 0x10),
+    "5": (0x27, 0x45, 0x45, 0x45, 0x39),
+    "6": (0x3C, 0x4A, 0x49, 0x49, 0x31),
+    "7": (0x41, 0x21, 0x11, 0x09, 0x07),
+    "8": (0x36, 0x49, 0x49, 0x49, 0x36),
+    "9": (0x46, 0x49, 0x49, 0x29, 0x1E),
+    ":": (0x00, 0x00, 0x14, 0x00, 0x00),
+    "+": (0x08, 0x08, 0x3E, 0x08, 0x08),
+    "-": (0x08, 0x08, 0x08, 0x08, 0x08),
+    "!": (0x00, 0x00, 0x5F, 0x00, 0x00),
+    "'": (0x00, 0x08, 0x07, 0x03, 0x00),
+    "i": (0x00, 0x44, 0x7D, 0x40, 0x00),
+    "n": (0x7C, 0x08, 0x04, 0x04, 0x78),
+}
+
+
+def read_library_font(project_dir):
+    """Return the glcdfont.c byte table from an installed Adafruit GFX, or None."""
+    pattern = os.path.join(project_dir, ".pio", "libdeps", "*", "Adafruit GFX Library", "glcdfont.c")
+    for path in sorted(glob.glob(pattern)):
+        with open(path) as f:
+            source = f.read()
+        start = source.find("{", source.find("font[]"))
+        end = source.find("};", start)
+        if start < 0 or end < 0:
+            continue
+        body = re.sub(r"//[^\n]*|/\*.*?\*/", "", source[start + 1 : end], flags=re.S)
+        values = [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]{2}", body)]
+        if len(values) >= 256 * 5:
+            return values
+    return None
+
+
+def glyph_columns(font, ch):
+    if font is None:
+        return FALLBACK_COLUMNS[ch]
+    base = ord(ch) * 5
+    return tuple(font[base : base + 5])
+
+
+def double_bits(byte):
+    """Stretch 8 rows to 16: bit j becomes bits 2j and 2j+1."""
+    out = 0
+    for j in range(8):
+        if byte & (1 << j):
+            out |= 3 << (2 * j)
+    return out
+
+
+def scale2(columns):
+    """Return the two pages (top, bottom) of a glyph drawn at text size 2."""
+    wide = [c for c in columns for _ in range(2)]
+    tall = [double_bits(c) for c in wide]
+    return [c & 0xFF for c in tall], [c >> 8 for c in tall]
+
+
+def hex_row(values):
+    return ", ".join("0x%02X" % v for v in values)
+
+
+def render(font):
+    lines = [
+        "// Generated by scripts/gen_row_glyphs.py -- do not edit.",
+        "//",
+        "// Pre-rasterized glyphs for the departure row renderer, taken from the",
+        "// Adafruit GFX classic 5x7 font and laid out like the SSD1306 frame buffer:",
+        "// one byte per column per 8-row page, bit 0 = top row.",
+        "",
+        "#ifndef ROW_GLYPHS_H",
+        "#define ROW_GLYPHS_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define ROW_GLYPH_COUNT %d" % len(CHARS),
+        "",
+        "// Characters covered, in table order.",
+        'static const char kRowGlyphChars[] = "%s";' % CHARS,
+        "",
+        "// Text size 1: the font's own five columns, one page tall.",
+        "static const uint8_t kRowGlyphs1[ROW_GLYPH_COUNT][5] = {",
+    ]
+    for ch in CHARS:
+        lines.append("    {%s},  // '%s'" % (hex_row(glyph_columns(font, ch)), ch))
+    lines += [
+        "};",
+        "",
+        "// Text size 2: every column and row doubled, ten columns two pages tall.",
+        "static const uint8_t kRowGlyphs2[ROW_GLYPH_COUNT][2][10] = {",
+    ]
+    for ch in CHARS:
+        top, bottom = scale2(glyph_columns(font, ch))
+        lines.append("    {{%s},  // '%s'" % (hex_row(top), ch))
+        lines.append("     {%s}}," % hex_row(bottom))
+    lines += [
+        "};",
+        "",
+        "#endif  // ROW_GLYPHS_H",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def generate(project_dir):
+    output = os.path.join(project_dir, "src", "row_glyphs.h")
+    content = render(read_library_font(project_dir))
+    if os.path.exists(output):
+        with open(output) as f:
+            if f.read() == content:
+                return
+    with open(output, "w") as f:
+        f.write(content)
+    print("Generated %s" % os.path.relpath(output, project_dir))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO's SCons environment
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
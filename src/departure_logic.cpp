@@ -5,6 +5,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "json_skip.h"
+
+// Whether direction contains the first length characters of term.
+static bool containsTerm(const char* direction, const char* term, size_t length) {
+  for (; *direction != '\0'; direction++) {
+    if (strncmp(direction, term, length) == 0) return true;
+  }
+  return false;
+}
+
 bool matchesDirectionFilter(const char* direction, const char* filter) {
   // Empty or NULL filter matches everything
   if (filter == NULL || strlen(filter) == 0) {
@@ -15,50 +25,38 @@ bool matchesDirectionFilter(const char* direction, const char* filter) {
     return false;
   }
 
-  // Make a copy of filter since we'll modify it
-  size_t filterLen = strlen(filter);
-  char* filterCopy = (char*)malloc(filterLen + 1);
-  if (filterCopy == NULL) {
-    return false;
-  }
-  strcpy(filterCopy, filter);
-
   // Two keyword kinds, distinguished by a leading '!':
   //   "Alpha"   include: direction must contain this to match
   //   "!Alpha"  exclude: if direction contains this, it never matches
   // An exclude always wins. If the filter is made up only of excludes, the
   // default is to show everything that isn't excluded (e.g. "!Alpha").
+  // Keywords are matched in place as [start, end) ranges of the filter: this
+  // runs for every departure of every refresh, so it does not copy the filter.
   bool hasInclude = false;   // at least one positive keyword present
   bool hasExclude = false;   // at least one negative keyword present
   bool includeHit = false;   // direction matched some positive keyword
   bool excludeHit = false;   // direction matched some negative keyword
-  char* start = filterCopy;
+  const char* start = filter;
 
-  while (*start != '\0') {
+  for (;;) {
     // Find the next comma or end of string
-    char* comma = strchr(start, ',');
-    if (comma != NULL) {
-      *comma = '\0';
-    }
+    const char* comma = strchr(start, ',');
+    const char* end = (comma != NULL) ? comma : start + strlen(start);
 
-    // Trim leading whitespace
-    while (*start == ' ' || *start == '\t') {
+    // Trim leading and trailing whitespace
+    while (start < end && (*start == ' ' || *start == '\t')) {
       start++;
     }
-
-    // Trim trailing whitespace
-    char* end = start + strlen(start) - 1;
-    while (end > start && (*end == ' ' || *end == '\t')) {
-      *end = '\0';
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t')) {
       end--;
     }
 
     // A leading '!' marks an exclusion keyword; the rest is the term to match.
-    bool negate = (*start == '!');
-    char* term = negate ? start + 1 : start;
+    bool negate = (start < end && *start == '!');
+    const char* term = negate ? start + 1 : start;
 
-    if (strlen(term) > 0) {
-      bool contains = (strstr(direction, term) != NULL);
+    if (end > term) {
+      bool contains = containsTerm(direction, term, (size_t)(end - term));
       if (negate) {
         hasExclude = true;
         if (contains) excludeHit = true;
@@ -76,8 +74,6 @@ bool matchesDirectionFilter(const char* direction, const char* filter) {
     }
   }
 
-  free(filterCopy);
-
   // Any exclusion match rejects outright.
   if (excludeHit) {
     return false;
@@ -91,6 +87,20 @@ bool matchesDirectionFilter(const char* direction, const char* filter) {
   return hasExclude;
 }
 
+bool isDisplayableDeparture(const Departure* dep, const char* filter) {
+  if (dep == NULL || !dep->valid) return false;
+  if (!matchesDirectionFilter(dep->direction, filter)) return false;
+  return dep->countdown >= MIN_COUNTDOWN_MIN;
+}
+
+int countDisplayableDepartures(const Departure* departures, int count, const char* filter) {
+  int displayable = 0;
+  for (int i = 0; i < count; i++) {
+    if (isDisplayableDeparture(&departures[i], filter)) displayable++;
+  }
+  return displayable;
+}
+
 // Helper: read an int from a JSON value that may be a string ("5") or a number (5).
 static int readIntField(JsonVariantConst v) {
   if (v.isNull()) return 0;
@@ -120,75 +130,68 @@ static ParseError mapDeserError(DeserializationError error) {
   return (error == DeserializationError::NoMemory) ? PARSE_ERR_NO_MEMORY : PARSE_ERR_INVALID_JSON;
 }
 
-// Extract departures from an already-deserialized document into result.
-static void extractDepartures(const DynamicJsonDocument& doc, DeparturesResult& result, int maxResults) {
-  JsonArrayConst departures = doc["departureList"].as<JsonArrayConst>();
-  if (departures.isNull()) {
-    result.error = PARSE_ERR_NO_LIST;
-    return;
-  }
-
-  result.success = true;
-  result.error = PARSE_OK;
+// Fill one Departure from a departureList element.
+static void extractDeparture(JsonObjectConst dep, Departure* d) {
+  // Direction
+  const char* direction = dep["servingLine"]["direction"] | "";
+  strncpy(d->direction, direction, MAX_DIRECTION_LEN - 1);
+  d->direction[MAX_DIRECTION_LEN - 1] = '\0';
 
-  for (JsonObjectConst dep : departures) {
-    if (result.count >= maxResults) break;
-
-    Departure* d = &result.departures[result.count];
+  // Scheduled time
+  JsonVariantConst sched = dep["dateTime"];
+  d->schedHour = readIntField(sched["hour"]);
+  d->schedMinute = readIntField(sched["minute"]);
 
-    // Direction
-    const char* direction = dep["servingLine"]["direction"] | "";
-    strncpy(d->direction, direction, MAX_DIRECTION_LEN - 1);
-    d->direction[MAX_DIRECTION_LEN - 1] = '\0';
-
-    // Scheduled time
-    JsonVariantConst sched = dep["dateTime"];
-    d->schedHour = readIntField(sched["hour"]);
-    d->schedMinute = readIntField(sched["minute"]);
+  // Real time (falls back to scheduled when absent).
+  // Use an inner-field presence check because the JSON filter can leave an
+  // empty object when EFA omits realDateTime entirely.
+  d->realHour = d->schedHour;
+  d->realMinute = d->schedMinute;
+  if (dep["realDateTime"]["hour"].is<const char*>()) {
+    JsonVariantConst real = dep["realDateTime"];
+    d->realHour = readIntField(real["hour"]);
+    d->realMinute = readIntField(real["minute"]);
+  }
 
-    // Real time (falls back to scheduled when absent).
-    // Use an inner-field presence check because the JSON filter can leave an
-    // empty object when EFA omits realDateTime entirely.
-    d->realHour = d->schedHour;
-    d->realMinute = d->schedMinute;
-    if (dep["realDateTime"]["hour"].is<const char*>()) {
-      JsonVariantConst real = dep["realDateTime"];
-      d->realHour = readIntField(real["hour"]);
-      d->realMinute = readIntField(real["minute"]);
-    }
+  // Delay in minutes with midnight wrap clamp
+  int delayMin = (d->realHour * 60 + d->realMinute) - (d->schedHour * 60 + d->schedMinute);
+  if (delayMin < -720) delayMin += 1440;
+  if (delayMin > 720) delayMin -= 1440;
+  d->delayMin = delayMin;
 
-    // Delay in minutes with midnight wrap clamp
-    int delayMin = (d->realHour * 60 + d->realMinute) - (d->schedHour * 60 + d->schedMinute);
-    if (delayMin < -720) delayMin += 1440;
-    if (delayMin > 720) delayMin -= 1440;
-    d->delayMin = delayMin;
+  // Countdown
+  d->countdown = readIntField(dep["countdown"]);
 
-    // Countdown
-    d->countdown = readIntField(dep["countdown"]);
+  // Mark valid if we at least have a servingLine present (dateTime may
+  // legitimately be all zeros for malformed entries; treat a missing
+  // dateTime as invalid).
+  d->valid = !sched.isNull();
+}
 
-    // Mark valid if we at least have a servingLine present (dateTime may
-    // legitimately be all zeros for malformed entries; treat a missing
-    // dateTime as invalid).
-    d->valid = !sched.isNull();
+// Extract up to maxResults departures from an already-deserialized document.
+static ParseError extractDepartures(const DynamicJsonDocument& doc, Departure* out, int maxResults, int* count) {
+  JsonArrayConst departures = doc["departureList"].as<JsonArrayConst>();
+  if (departures.isNull()) {
+    return PARSE_ERR_NO_LIST;
+  }
 
-    result.count++;
+  for (JsonObjectConst dep : departures) {
+    if (*count >= maxResults) break;
+    extractDeparture(dep, &out[*count]);
+    (*count)++;
   }
+  return PARSE_OK;
 }
 
 // A full 15-entry filtered response uses ~9.9 KB of pool (each entry carries
 // full dateTime + realDateTime objects). 16 KB leaves headroom for busy stops.
 static const size_t kDocCapacity = 16384;
 
-DeparturesResult parseDeparturesJson(const char* json, int maxResults) {
-  DeparturesResult result = {{}, 0, false, PARSE_OK};
+ParseError parseDeparturesJsonInto(const char* json, Departure* out, int maxResults, int* count) {
+  *count = 0;
 
   if (json == NULL) {
-    result.error = PARSE_ERR_NULL_INPUT;
-    return result;
-  }
-
-  if (maxResults > MAX_DEPARTURES) {
-    maxResults = MAX_DEPARTURES;
+    return PARSE_ERR_NULL_INPUT;
   }
 
   StaticJsonDocument<512> filter;
@@ -197,21 +200,768 @@ DeparturesResult parseDeparturesJson(const char* json, int maxResults) {
   DynamicJsonDocument doc(kDocCapacity);
   DeserializationError error = deserializeJson(doc, json, DeserializationOption::Filter(filter));
   if (error) {
-    result.error = mapDeserError(error);
-    return result;
+    return mapDeserError(error);
   }
 
-  extractDepartures(doc, result, maxResults);
-  return result;
+  return extractDepartures(doc, out, maxResults, count);
 }
 
+// Per-element pool for the incremental parser. One filtered departureList
+// entry (countdown, two hour/minute pairs, three servingLine strings) needs
+// roughly 400 B; the rest is headroom for long direction names. Unlike
+// kDocCapacity this does not grow with the number of entries in the list.
+static const size_t kElementCapacity = 1024;
+
+// Byte source over a NUL-terminated buffer, or the first length bytes of one
+// that is not terminated.
+class CStringSource {
+ public:
+  explicit CStringSource(const char* json) : _p(json), _end(json + strlen(json)) {}
+  CStringSource(const char* data, size_t length) : _p(data), _end(data + length) {}
+  int read() { return (_p < _end) ? (unsigned char)*_p++ : -1; }
+
+  size_t peekSpan(const uint8_t** data) {
+    *data = (const uint8_t*)_p;
+    return (size_t)(_end - _p);
+  }
+  void consume(size_t n) { _p += n; }
+
+ private:
+  const char* _p;
+  const char* _end;
+};
+
 #ifdef ARDUINO
-DeparturesResult parseDeparturesJsonStream(Stream& stream, int maxResults) {
-  DeparturesResult result = {{}, 0, false, PARSE_OK};
+// Byte source over an Arduino Stream. Reads go through readBytes() so the
+// stream timeout applies: a slow socket is waited on, a stalled one ends input.
+class StreamSource {
+ public:
+  explicit StreamSource(Stream& stream) : _stream(stream) {}
+  int read() {
+    char c;
+    return (_stream.readBytes(&c, 1) == 1) ? (unsigned char)c : -1;
+  }
 
-  if (maxResults > MAX_DEPARTURES) {
-    maxResults = MAX_DEPARTURES;
+  // A Stream cannot hand out its buffer, so skipping stays bytewise.
+  size_t peekSpan(const uint8_t** data) {
+    (void)data;
+    return 0;
+  }
+  void consume(size_t n) { (void)n; }
+
+ private:
+  Stream& _stream;
+};
+#endif  // ARDUINO
+
+// Adds one byte of look-ahead to a source, which the scanner below needs to
+// find where each value starts. Also satisfies ArduinoJson's custom reader
+// interface (read/readBytes), so list elements deserialize straight from it.
+template <typename TSource>
+class PeekReader {
+ public:
+  explicit PeekReader(TSource& source) : _source(source), _peeked(kNone), _ended(false) {}
+
+  int peek() {
+    if (_peeked == kNone) {
+      // Once the source has ended it is not asked again: for a stream that
+      // would mean waiting out another timeout.
+      _peeked = _ended ? -1 : _source.read();
+      _ended = (_peeked < 0);
+    }
+    return _peeked;
+  }
+
+  /** True once the source has reported the end of input. */
+  bool ended() const { return _ended; }
+
+  int read() {
+    int c = peek();
+    _peeked = kNone;
+    return c;
+  }
+
+  size_t readBytes(char* buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+      int c = read();
+      if (c < 0) break;
+      buffer[n++] = (char)c;
+    }
+    return n;
+  }
+
+  // Bulk access for the skipper. A pending look-ahead byte is handed out on
+  // its own first, since it has already left the source.
+  size_t peekSpan(const uint8_t** data) {
+    if (_peeked >= 0) {
+      _peekedByte = (uint8_t)_peeked;
+      *data = &_peekedByte;
+      return 1;
+    }
+    return _ended ? 0 : _source.peekSpan(data);
+  }
+
+  void consume(size_t n) {
+    if (n == 0) return;
+    if (_peeked >= 0) {
+      _peeked = kNone;
+    } else {
+      _source.consume(n);
+    }
+  }
+
+ private:
+  static const int kNone = -2;
+  TSource& _source;
+  int _peeked;
+  uint8_t _peekedByte;
+  bool _ended;
+};
+
+static bool isJsonSpace(int c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+template <typename TReader>
+static void skipSpaces(TReader& reader) {
+  while (isJsonSpace(reader.peek())) reader.read();
+}
+
+// Consume a string whose opening quote is next. When match is non-NULL,
+// *matched reports whether the contents equal it; a string containing escapes
+// never matches (EFA keys have none).
+template <typename TReader>
+static bool skipString(TReader& reader, const char* match, bool* matched) {
+  reader.read();
+  bool same = (match != NULL);
+  for (;;) {
+    int c = reader.read();
+    if (c < 0) return false;
+    if (c == '"') break;
+    if (c == '\\') {
+      if (reader.read() < 0) return false;
+      same = false;
+      continue;
+    }
+    if (same && (unsigned char)*match == c) {
+      match++;
+    } else {
+      same = false;
+    }
+  }
+  if (matched != NULL) *matched = same && *match == '\0';
+  return true;
+}
+
+// Consume one value without storing it. Only bracket depth and string state
+// are tracked, so this is cheap but does not validate what it skips. Objects,
+// arrays and strings go through JsonSkipper a span at a time where the source
+// offers spans, and a byte at a time where it does not.
+template <typename TReader>
+static bool skipValue(TReader& reader) {
+  int c = reader.peek();
+  if (c != '"' && c != '{' && c != '[') {
+    // Scalar: runs up to the next delimiter, which is left for the caller.
+    bool any = false;
+    while ((c = reader.peek()) >= 0 && c != ',' && c != '}' && c != ']' && !isJsonSpace(c)) {
+      reader.read();
+      any = true;
+    }
+    return any;
+  }
+
+  JsonSkipper skipper;
+  while (!skipper.done()) {
+    const uint8_t* span;
+    size_t n = reader.peekSpan(&span);
+    if (n > 0) {
+      reader.consume(skipper.scan(span, n));
+    } else {
+      c = reader.read();
+      if (c < 0) return false;
+      uint8_t byte = (uint8_t)c;
+      skipper.scan(&byte, 1);
+    }
+  }
+  return true;
+}
+
+// Position the reader just past departureList's opening '['. Every other
+// top-level member is skipped without being deserialized.
+template <typename TReader>
+static ParseError seekDepartureList(TReader& reader) {
+  skipSpaces(reader);
+  if (reader.read() != '{') return PARSE_ERR_INVALID_JSON;
+  skipSpaces(reader);
+  if (reader.peek() == '}') return PARSE_ERR_NO_LIST;
+
+  for (;;) {
+    skipSpaces(reader);
+    if (reader.peek() != '"') return PARSE_ERR_INVALID_JSON;
+    bool isList = false;
+    if (!skipString(reader, "departureList", &isList)) return PARSE_ERR_INVALID_JSON;
+    skipSpaces(reader);
+    if (reader.read() != ':') return PARSE_ERR_INVALID_JSON;
+    skipSpaces(reader);
+
+    if (isList) {
+      int c = reader.peek();
+      if (c == '[') {
+        reader.read();
+        return PARSE_OK;
+      }
+      // Present but not an array (e.g. null): same outcome as a missing key.
+      return (c < 0) ? PARSE_ERR_INVALID_JSON : PARSE_ERR_NO_LIST;
+    }
+
+    if (!skipValue(reader)) return PARSE_ERR_INVALID_JSON;
+    skipSpaces(reader);
+    int c = reader.read();
+    if (c == '}') return PARSE_ERR_NO_LIST;
+    if (c != ',') return PARSE_ERR_INVALID_JSON;
+  }
+}
+
+// Field filter applied to a single departureList element. Narrower than
+// buildDepartureFilter: only hour/minute of the two timestamps are kept.
+static void buildElementFilter(JsonDocument& filter) {
+  filter["countdown"] = true;
+  filter["dateTime"]["hour"] = true;
+  filter["dateTime"]["minute"] = true;
+  filter["realDateTime"]["hour"] = true;
+  filter["realDateTime"]["minute"] = true;
+  filter["servingLine"]["direction"] = true;
+  filter["servingLine"]["number"] = true;
+  filter["servingLine"]["realtime"] = true;
+}
+
+// The element filter never changes, so it is built once and shared by every
+// parse rather than rebuilt per element (always-on refresh parses for as long
+// as the board runs).
+struct ElementFilter {
+  StaticJsonDocument<256> doc;
+  ElementFilter() { buildElementFilter(doc); }
+};
+
+static const JsonDocument& elementFilter() {
+  static const ElementFilter filter;
+  return filter.doc;
+}
+
+bool ElementTrimmer::trim(const uint8_t* data, size_t length, char* out, size_t capacity, size_t* outLength) {
+  size_t used = 0;
+  while (used < length) {
+    const uint8_t* emit = NULL;
+    size_t emitLength = 0;
+    used += step(data + used, length - used, &emit, &emitLength);
+    if (emitLength > capacity - *outLength) return false;
+    memcpy(out + *outLength, emit, emitLength);
+    *outLength += emitLength;
+  }
+  return true;
+}
+
+// One transition. Returns the bytes consumed, which may be 0 when only the
+// state changed; *emit points at what to keep (the input itself, or the
+// placeholder standing in for a dropped value).
+size_t ElementTrimmer::step(const uint8_t* data, size_t length, const uint8_t** emit, size_t* emitLength) {
+  static const uint8_t kPlaceholder = '0';
+  int c = data[0];
+  *emit = data;
+  *emitLength = 1;
+  switch (_state) {
+    case kStart:
+      if (c == '{') {
+        _depth = 1;
+        _state = kBeforeKey;
+      } else {
+        _state = kPass;
+      }
+      return 1;
+
+    case kBeforeKey:
+      if (c == '"') {
+        _state = kKey;
+        _keyLength = 0;
+        _keyEscaped = false;
+        _keyUnknown = false;
+      } else if (c == '}') {
+        objectClosed();
+      } else if (!isJsonSpace(c)) {
+        _state = kPass;
+      }
+      return 1;
+
+    case kKey:
+      if (_keyEscaped) {
+        _keyEscaped = false;
+      } else if (c == '\\') {
+        _keyEscaped = true;
+        _keyUnknown = true;
+      } else if (c == '"') {
+        keyClosed();
+      } else if (_keyLength < kMaxKey) {
+        _key[_keyLength++] = (char)c;
+      } else {
+        _keyUnknown = true;
+      }
+      return 1;
+
+    case kBeforeColon:
+      if (c == ':') {
+        _state = kBeforeValue;
+      } else if (!isJsonSpace(c)) {
+        _state = kPass;
+      }
+      return 1;
+
+    case kBeforeValue: {
+      if (isJsonSpace(c)) return 1;
+      *emitLength = 0;
+      if (c == ',' || c == '}' || c == ']') {
+        _state = kPass;  // no value at all: leave it to the deserializer
+        return 0;
+      }
+      if (_action == kDescend && c == '{') {
+        memcpy(_parent, _key, sizeof(_parent));
+        _depth = 2;
+        _state = kBeforeKey;
+        *emitLength = 1;
+        return 1;
+      }
+      // Scalars are short and always copied: dropping one would also drop
+      // whatever makes it malformed, which the deserializer has to see.
+      if (c != '"' && c != '{' && c != '[') {
+        _state = kCopyScalar;
+        return 0;
+      }
+      _skipper.reset();
+      if (_action != kDrop) {
+        _state = kCopyValue;
+        return 0;
+      }
+      size_t n = _skipper.scan(data, length);
+      _state = _skipper.done() ? kAfterValue : kDropValue;
+      *emit = &kPlaceholder;
+      *emitLength = 1;
+      return n;
+    }
+
+    case kDropValue:
+    case kCopyValue: {
+      size_t n = _skipper.scan(data, length);
+      *emitLength = (_state == kCopyValue) ? n : 0;
+      if (_skipper.done()) _state = kAfterValue;
+      return n;
+    }
+
+    case kCopyScalar:
+      if (c == ',' || c == '}' || c == ']' || isJsonSpace(c)) {
+        _state = kAfterValue;
+        *emitLength = 0;
+        return 0;
+      }
+      return 1;
+
+    case kAfterValue:
+      if (c == ',') {
+        _state = kBeforeKey;
+      } else if (c == '}') {
+        objectClosed();
+      } else if (!isJsonSpace(c)) {
+        _state = kPass;
+      }
+      return 1;
+
+    case kPass:
+      break;
+  }
+  *emitLength = length;
+  return length;
+}
+
+// Look the key up in the element filter, under the enclosing member at depth 2.
+void ElementTrimmer::keyClosed() {
+  _state = kBeforeColon;
+  if (_keyUnknown) {
+    _action = kKeep;
+    return;
   }
+  _key[_keyLength] = '\0';
+  const JsonDocument& filter = elementFilter();
+  JsonVariantConst wanted = (_depth == 1) ? filter[_key] : filter[_parent][_key];
+  if (wanted.isNull()) {
+    _action = kDrop;
+  } else if (_depth == 1 && wanted.is<JsonObjectConst>()) {
+    _action = kDescend;
+  } else {
+    _action = kKeep;
+  }
+}
+
+void ElementTrimmer::objectClosed() {
+  _depth--;
+  _state = (_depth > 0) ? kAfterValue : kPass;
+}
+
+// ArduinoJson reader over an element that passes it through ElementTrimmer,
+// so the pull parser drops the same members as the push parser and the two
+// agree on everything inside them.
+template <typename TReader>
+class TrimmingReader {
+ public:
+  explicit TrimmingReader(TReader& reader) : _reader(reader) {}
+
+  void reset() { _trimmer.reset(); }
+
+  int read() {
+    for (;;) {
+      int c = _reader.read();
+      if (c < 0) return -1;
+      uint8_t byte = (uint8_t)c;
+      char kept;
+      size_t length = 0;
+      _trimmer.trim(&byte, 1, &kept, 1, &length);
+      if (length > 0) return (unsigned char)kept;
+    }
+  }
+
+  size_t readBytes(char* buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+      int c = read();
+      if (c < 0) break;
+      buffer[n++] = (char)c;
+    }
+    return n;
+  }
+
+ private:
+  TReader& _reader;
+  ElementTrimmer _trimmer;
+};
+
+// Walk departureList one element at a time: each element is deserialized into
+// the same small pool, extracted, and discarded before the next is read.
+// Elements past maxResults are skipped without touching the pool. Running out
+// of input anywhere inside the list is PARSE_PARTIAL: the entries counted so
+// far were each deserialized from a complete element.
+template <typename TReader>
+static ParseError parseDepartureList(TReader& reader, Departure* out, int maxResults, int* count) {
+  ParseError err = seekDepartureList(reader);
+  if (err != PARSE_OK) return err;
+
+  const JsonDocument& filter = elementFilter();
+  StaticJsonDocument<kElementCapacity> element;
+  TrimmingReader<TReader> trimmed(reader);
+
+  skipSpaces(reader);
+  if (reader.peek() == ']') {
+    reader.read();
+    return PARSE_OK;
+  }
+
+  for (;;) {
+    skipSpaces(reader);
+    if (*count < maxResults) {
+      trimmed.reset();
+      DeserializationError error = deserializeJson(element, trimmed, DeserializationOption::Filter(filter));
+      if (error) return reader.ended() ? PARSE_PARTIAL : mapDeserError(error);
+      extractDeparture(element.as<JsonObjectConst>(), &out[*count]);
+      (*count)++;
+    } else if (!skipValue(reader)) {
+      return reader.ended() ? PARSE_PARTIAL : PARSE_ERR_INVALID_JSON;
+    }
+
+    skipSpaces(reader);
+    int c = reader.read();
+    if (c == ']') return PARSE_OK;
+    if (c < 0) return PARSE_PARTIAL;
+    if (c != ',') return PARSE_ERR_INVALID_JSON;
+  }
+}
+
+ParseError parseDeparturesJsonIncrementalInto(const char* json, Departure* out, int maxResults, int* count) {
+  *count = 0;
+
+  if (json == NULL) {
+    return PARSE_ERR_NULL_INPUT;
+  }
+
+  CStringSource source(json);
+  PeekReader<CStringSource> reader(source);
+  return parseDepartureList(reader, out, maxResults, count);
+}
+
+ParseError parseDeparturesJsonIncrementalInto(DepartureSource& source, Departure* out, int maxResults, int* count) {
+  *count = 0;
+
+  PeekReader<DepartureSource> reader(source);
+  return parseDepartureList(reader, out, maxResults, count);
+}
+
+// The same departure in two responses: countdown and real time move on, the
+// direction and planned time do not.
+static bool isSameDeparture(const Departure& a, const Departure& b) {
+  return strcmp(a.direction, b.direction) == 0 && a.schedHour == b.schedHour && a.schedMinute == b.schedMinute;
+}
+
+static const char kListKey[] = "departureList";
+static const int kListKeyLength = (int)sizeof(kListKey) - 1;
+
+void DeparturePushParser::reset(int keep) {
+  _state = kBeforeObject;
+  _error = PARSE_OK;
+  _count = keep;
+  _skip = keep;
+  _index = 0;
+  _first = true;
+  _isList = false;
+  _keyEscaped = false;
+  _keyMatched = 0;
+  _keep = false;
+  _elementLength = 0;
+  _elementPeak = 0;
+  _poolPeak = 0;
+  _skipper.reset();
+}
+
+void DeparturePushParser::fail(ParseError error) {
+  _state = kFailed;
+  _error = error;
+}
+
+size_t DeparturePushParser::feed(const uint8_t* data, size_t length) {
+  size_t used = 0;
+  while (used < length && !finished()) used += step(data + used, length - used);
+  return used;
+}
+
+void DeparturePushParser::finish() {
+  if (finished()) return;
+  // Same rule as the pull parser: running out inside the list keeps what was
+  // complete, running out before it is malformed input.
+  if ((_state == kElement || _state == kElementScalar) && _keep) {
+    // The pull parser deserializes a cut-off element as far as it goes, so an
+    // error before the end of the input is reported as that error, and a
+    // scalar that happens to be complete still counts.
+    CStringSource source(_element, _elementLength);
+    PeekReader<CStringSource> reader(source);
+    StaticJsonDocument<kElementCapacity> element;
+    DeserializationError error = deserializeJson(element, reader, DeserializationOption::Filter(elementFilter()));
+    if (error && !reader.ended()) return fail(mapDeserError(error));
+    if (!error) elementComplete();
+    if (finished()) return;
+  }
+  fail(inList() ? PARSE_PARTIAL : PARSE_ERR_INVALID_JSON);
+}
+
+// One transition of the scanner. Returns the bytes consumed, which may be 0
+// when only the state changed (the byte is then looked at again).
+size_t DeparturePushParser::step(const uint8_t* data, size_t length) {
+  int c = data[0];
+  switch (_state) {
+    case kBeforeObject:
+      if (isJsonSpace(c)) return 1;
+      if (c == '{') {
+        _state = kBeforeKey;
+        _first = true;
+      } else {
+        fail(PARSE_ERR_INVALID_JSON);
+      }
+      return 1;
+
+    case kBeforeKey:
+      if (isJsonSpace(c)) return 1;
+      if (c == '"') {
+        _state = kKey;
+        _keyMatched = 0;
+        _keyEscaped = false;
+      } else {
+        fail((c == '}' && _first) ? PARSE_ERR_NO_LIST : PARSE_ERR_INVALID_JSON);
+      }
+      return 1;
+
+    case kKey:
+      // A key containing escapes never matches (EFA keys have none).
+      if (_keyEscaped) {
+        _keyEscaped = false;
+      } else if (c == '\\') {
+        _keyEscaped = true;
+        _keyMatched = -1;
+      } else if (c == '"') {
+        _isList = (_keyMatched == kListKeyLength);
+        _state = kBeforeColon;
+      } else if (_keyMatched >= 0) {
+        _keyMatched = (_keyMatched < kListKeyLength && kListKey[_keyMatched] == c) ? _keyMatched + 1 : -1;
+      }
+      return 1;
+
+    case kBeforeColon:
+      if (isJsonSpace(c)) return 1;
+      if (c == ':') {
+        _state = kBeforeValue;
+      } else {
+        fail(PARSE_ERR_INVALID_JSON);
+      }
+      return 1;
+
+    case kBeforeValue:
+      if (isJsonSpace(c)) return 1;
+      if (_isList) {
+        // Present but not an array (e.g. null): same outcome as a missing key.
+        if (c == '[') {
+          _state = kBeforeElement;
+          _first = true;
+        } else {
+          fail(PARSE_ERR_NO_LIST);
+        }
+        return 1;
+      }
+      if (c == '"' || c == '{' || c == '[') {
+        _skipper.reset();
+        _state = kSkipValue;
+        return 0;
+      }
+      if (c == ',' || c == '}' || c == ']') {
+        fail(PARSE_ERR_INVALID_JSON);
+        return 1;
+      }
+      _state = kSkipScalar;
+      return 1;
+
+    case kSkipScalar:
+      if (c == ',' || c == '}' || c == ']' || isJsonSpace(c)) {
+        _state = kAfterValue;
+        return 0;
+      }
+      return 1;
+
+    case kSkipValue: {
+      size_t n = _skipper.scan(data, length);
+      if (_skipper.done()) _state = kAfterValue;
+      return n;
+    }
+
+    case kAfterValue:
+      if (isJsonSpace(c)) return 1;
+      if (c == ',') {
+        _state = kBeforeKey;
+        _first = false;
+      } else {
+        fail((c == '}') ? PARSE_ERR_NO_LIST : PARSE_ERR_INVALID_JSON);
+      }
+      return 1;
+
+    case kBeforeElement:
+      if (isJsonSpace(c)) return 1;
+      if (c == ']' || c == ',') {
+        // "[]" is an empty list; "[1, ]" and "[,1]" are malformed.
+        if (c == ']' && _first) {
+          listClosed();
+        } else {
+          fail(PARSE_ERR_INVALID_JSON);
+        }
+        return 1;
+      }
+      _keep = (_index < _skip || _count < _maxResults);
+      _index++;
+      _elementLength = 0;
+      _trimmer.reset();
+      if (c == '"' || c == '{' || c == '[') {
+        _skipper.reset();
+        _state = kElement;
+      } else {
+        _state = kElementScalar;
+      }
+      return 0;
+
+    case kElement: {
+      size_t n = _skipper.scan(data, length);
+      if (keepElement(data, n) && _skipper.done()) elementComplete();
+      return n;
+    }
+
+    case kElementScalar:
+      if (c == ',' || c == '}' || c == ']' || isJsonSpace(c)) {
+        elementComplete();
+        return 0;
+      }
+      keepElement(data, 1);
+      return 1;
+
+    case kAfterElement:
+      if (isJsonSpace(c)) return 1;
+      if (c == ',') {
+        _state = kBeforeElement;
+        _first = false;
+      } else if (c == ']') {
+        listClosed();
+      } else {
+        fail(PARSE_ERR_INVALID_JSON);
+      }
+      return 1;
+
+    case kDone:
+    case kFailed:
+      break;
+  }
+  return length;
+}
+
+// Append bytes of the current element to the buffer if it is being kept,
+// without the members the filter drops.
+bool DeparturePushParser::keepElement(const uint8_t* data, size_t length) {
+  if (!_keep) return true;
+  if (!_trimmer.trim(data, length, _element, _elementCapacity, &_elementLength)) {
+    fail(PARSE_ERR_NO_MEMORY);
+    return false;
+  }
+  return true;
+}
+
+void DeparturePushParser::elementComplete() {
+  _state = kAfterElement;
+  if (!_keep) return;
+  if (_elementLength > _elementPeak) _elementPeak = _elementLength;
+
+  // Through a const pointer, so ArduinoJson copies the strings into the pool
+  // as the pull parser does, instead of leaving them in _element (zero-copy).
+  // Both parsers then hit NO_MEMORY on the same elements, and poolPeak() is
+  // what a reader-fed deserialize needs.
+  StaticJsonDocument<kElementCapacity> element;
+  DeserializationError error = deserializeJson(element, (const char*)_element, _elementLength,
+                                               DeserializationOption::Filter(elementFilter()));
+  if (element.memoryUsage() > _poolPeak) _poolPeak = element.memoryUsage();
+  if (error) return fail(mapDeserError(error));
+
+  int index = _index - 1;
+  if (index >= _skip) {
+    extractDeparture(element.as<JsonObjectConst>(), &_out[_count]);
+    _count++;
+  } else {
+    // An entry the earlier response gave too. Unless the board changed in
+    // between, it is the same departure: refresh it without reporting it.
+    Departure repeated;
+    extractDeparture(element.as<JsonObjectConst>(), &repeated);
+    bool same = isSameDeparture(repeated, _out[index]);
+    _out[index] = repeated;
+    if (same) return;
+    // A departure left the top or a new one came in: the kept entries no
+    // longer line up, so extract the list afresh from here.
+    _skip = index;
+    _count = index + 1;
+  }
+  if (_onDeparture != NULL) _onDeparture(_onDepartureContext, &_out[_count - 1], _count - 1);
+}
+
+void DeparturePushParser::listClosed() {
+  _state = kDone;
+  if (_index < _skip) _count = _index;  // fewer entries than the earlier response
+}
+
+#ifdef ARDUINO
+ParseError parseDeparturesJsonStreamInto(Stream& stream, Departure* out, int maxResults, int* count) {
+  *count = 0;
 
   StaticJsonDocument<512> filter;
   buildDepartureFilter(filter);
@@ -222,11 +972,62 @@ DeparturesResult parseDeparturesJsonStream(Stream& stream, int maxResults) {
   DynamicJsonDocument doc(kDocCapacity);
   DeserializationError error = deserializeJson(doc, stream, DeserializationOption::Filter(filter));
   if (error) {
-    result.error = mapDeserError(error);
-    return result;
+    return mapDeserError(error);
   }
 
-  extractDepartures(doc, result, maxResults);
+  return extractDepartures(doc, out, maxResults, count);
+}
+
+ParseError parseDeparturesJsonStreamIncrementalInto(Stream& stream, Departure* out, int maxResults, int* count) {
+  *count = 0;
+
+  StreamSource source(stream);
+  PeekReader<StreamSource> reader(source);
+  return parseDepartureList(reader, out, maxResults, count);
+}
+#endif  // ARDUINO
+
+// C ABI: thin wrappers returning a fixed MAX_DEPARTURES result by value.
+
+static void setOutcome(DeparturesResult& result, ParseError error) {
+  result.error = error;
+  result.success = (error == PARSE_OK);
+}
+
+DeparturesResult parseDeparturesJson(const char* json, int maxResults) {
+  DeparturesResult result = {{}, 0, false, PARSE_OK};
+  if (maxResults > MAX_DEPARTURES) {
+    maxResults = MAX_DEPARTURES;
+  }
+  setOutcome(result, parseDeparturesJsonInto(json, result.departures, maxResults, &result.count));
+  return result;
+}
+
+DeparturesResult parseDeparturesJsonIncremental(const char* json, int maxResults) {
+  DeparturesResult result = {{}, 0, false, PARSE_OK};
+  if (maxResults > MAX_DEPARTURES) {
+    maxResults = MAX_DEPARTURES;
+  }
+  setOutcome(result, parseDeparturesJsonIncrementalInto(json, result.departures, maxResults, &result.count));
+  return result;
+}
+
+#ifdef ARDUINO
+DeparturesResult parseDeparturesJsonStream(Stream& stream, int maxResults) {
+  DeparturesResult result = {{}, 0, false, PARSE_OK};
+  if (maxResults > MAX_DEPARTURES) {
+    maxResults = MAX_DEPARTURES;
+  }
+  setOutcome(result, parseDeparturesJsonStreamInto(stream, result.departures, maxResults, &result.count));
+  return result;
+}
+
+DeparturesResult parseDeparturesJsonStreamIncremental(Stream& stream, int maxResults) {
+  DeparturesResult result = {{}, 0, false, PARSE_OK};
+  if (maxResults > MAX_DEPARTURES) {
+    maxResults = MAX_DEPARTURES;
+  }
+  setOutcome(result, parseDeparturesJsonStreamIncrementalInto(stream, result.departures, maxResults, &result.count));
   return result;
 }
 #endif  // ARDUINO
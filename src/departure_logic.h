@@ -2,6 +2,7 @@
 #define DEPARTURE_LOGIC_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define MAX_DEPARTURES 10
@@ -25,6 +26,8 @@ typedef struct {
   bool valid;
 } Departure;
 
+#define MIN_COUNTDOWN_MIN 2  // departures leaving sooner cannot be reached; not shown
+
 /**
  * Why a parse attempt failed. PARSE_OK means success.
  *
@@ -32,6 +35,11 @@ typedef struct {
  * recoverable by retrying: the response was well-formed but too large for the
  * document pool, so every retry of the same payload fails identically. The
  * firmware uses this to skip retries and surface a different message.
+ *
+ * PARSE_PARTIAL is reported by the incremental parsers when the input ends
+ * inside departureList (socket closed or stalled mid-body). It is not success,
+ * but count holds every departure that was received complete, and those
+ * entries are as good as from a full parse.
  */
 typedef enum {
   PARSE_OK = 0,
@@ -39,6 +47,7 @@ typedef enum {
   PARSE_ERR_NO_MEMORY,     // valid JSON, but exceeded the document pool
   PARSE_ERR_INVALID_JSON,  // malformed / truncated JSON
   PARSE_ERR_NO_LIST,       // parsed OK but "departureList" was missing
+  PARSE_PARTIAL,           // input ended inside departureList; count entries are complete
 } ParseError;
 
 /**
@@ -65,6 +74,26 @@ typedef struct {
  */
 bool matchesDirectionFilter(const char* direction, const char* filter);
 
+/**
+ * Check if a departure belongs on the display: it parsed as valid, its direction
+ * passes the filter, and it leaves in at least MIN_COUNTDOWN_MIN minutes.
+ *
+ * @param dep The departure to check
+ * @param filter Direction filter, as for matchesDirectionFilter
+ * @return true if the departure should be shown
+ */
+bool isDisplayableDeparture(const Departure* dep, const char* filter);
+
+/**
+ * Count the displayable departures among departures[0..count).
+ *
+ * @param departures Parsed departures
+ * @param count Number of entries in departures
+ * @param filter Direction filter, as for matchesDirectionFilter
+ * @return Number of entries for which isDisplayableDeparture is true
+ */
+int countDisplayableDepartures(const Departure* departures, int count, const char* filter);
+
 /**
  * Parse departures from VAG EFA JSON response.
  *
@@ -86,9 +115,32 @@ bool matchesDirectionFilter(const char* direction, const char* filter);
  */
 DeparturesResult parseDeparturesJson(const char* json, int maxResults);
 
+/**
+ * Parse departures one departureList element at a time.
+ *
+ * Same input and result as parseDeparturesJson, but the top-level members
+ * before departureList are skipped by a word-at-a-time scanner (JsonSkipper)
+ * without being tokenized, and each list element is deserialized into one
+ * fixed ~1 KB pool that is reused for the next element.
+ * Peak memory is therefore that of a single departure regardless of how many
+ * entries the response carries; only a single oversized element can yield
+ * PARSE_ERR_NO_MEMORY. Elements past maxResults are skipped, not deserialized.
+ *
+ * On failure, count still reports the entries extracted before the error. If
+ * the input simply ends inside departureList the error is PARSE_PARTIAL and
+ * every counted entry was received complete.
+ *
+ * @param json The JSON string from the API
+ * @param maxResults Maximum number of departures to parse
+ * @return DeparturesResult with parsed departures
+ */
+DeparturesResult parseDeparturesJsonIncremental(const char* json, int maxResults);
+
 #ifdef __cplusplus
 }
 
+#include "json_skip.h"
+
 #ifdef ARDUINO
 #include <Stream.h>
 /**
@@ -105,6 +157,311 @@ DeparturesResult parseDeparturesJson(const char* json, int maxResults);
  * @return DeparturesResult with parsed departures
  */
 DeparturesResult parseDeparturesJsonStream(Stream& stream, int maxResults);
+
+/**
+ * Element-at-a-time variant of parseDeparturesJsonStream; see
+ * parseDeparturesJsonIncremental. Reads through the stream's timeout, so a
+ * socket that stalls mid-body ends the input, yielding PARSE_PARTIAL with the
+ * departures received so far, instead of hanging.
+ *
+ * @param stream Source stream positioned at the start of the JSON body
+ * @param maxResults Maximum number of departures to parse
+ * @return DeparturesResult with parsed departures
+ */
+DeparturesResult parseDeparturesJsonStreamIncremental(Stream& stream, int maxResults);
+#endif  // ARDUINO
+
+/**
+ * Departures result with a capacity fixed per call site.
+ *
+ * The C ABI above returns a MAX_DEPARTURES-sized DeparturesResult by value and
+ * silently clamps larger requests. C++ callers instead size the result to what
+ * they actually request and let the parse functions below fill it in place,
+ * typically in static storage rather than on the task stack.
+ */
+template <int N>
+struct DeparturesResultN {
+  static_assert(N > 0, "DeparturesResultN needs room for at least one departure");
+  static const int kCapacity = N;
+
+  Departure departures[N];
+  int count;
+  bool success;
+  ParseError error;  // PARSE_OK on success; reason otherwise
+};
+
+/**
+ * Byte source for the incremental parser when the input is neither a C string
+ * nor an Arduino Stream (e.g. a buffer filled by some other transport).
+ */
+class DepartureSource {
+ public:
+  virtual ~DepartureSource() {}
+
+  /** Next byte of input (0-255), or -1 once the input has ended. */
+  virtual int read() = 0;
+
+  /**
+   * Optional bulk access for skipping unwanted values: point *data at the
+   * next bytes of input, contiguous and not yet read. Return 0 when not
+   * supported or at the end of input; the parser then falls back to read().
+   */
+  virtual size_t peekSpan(const uint8_t** data) {
+    (void)data;
+    return 0;
+  }
+
+  /** Mark the first n bytes of the last peekSpan() as read. */
+  virtual void consume(size_t n) { (void)n; }
+};
+
+/**
+ * Called by DeparturePushParser for each departure as soon as its list
+ * element has closed, with its index in departureList (out[index] holds it).
+ */
+typedef void (*DepartureFn)(void* context, const Departure* departure, int index);
+
+/**
+ * Drops the members of a departureList element that the element filter would
+ * discard, as the element streams through, so they take up no buffer space.
+ * A dropped string, object or array becomes 0 and its key stays, so the
+ * output deserializes to the same filtered document; scalars are short and
+ * always kept. Two object levels are trimmed (the element and
+ * e.g. servingLine); anything else, and whatever it cannot classify (keys with
+ * escapes, malformed input), passes through for the deserializer to judge.
+ * Like JsonSkipper it does not validate the values it drops.
+ */
+class ElementTrimmer {
+ public:
+  ElementTrimmer() { reset(); }
+
+  /** Expect the first byte of a new element. */
+  void reset() {
+    _state = kStart;
+    _depth = 0;
+  }
+
+  /**
+   * Consume the next bytes of the element, appending what is kept to
+   * out[*outLength..capacity). Each input byte yields at most one output byte.
+   *
+   * @return false once out is full: the element does not fit even trimmed
+   */
+  bool trim(const uint8_t* data, size_t length, char* out, size_t capacity, size_t* outLength);
+
+ private:
+  enum State {
+    kStart,
+    kBeforeKey,
+    kKey,
+    kBeforeColon,
+    kBeforeValue,
+    kDropValue,
+    kCopyValue,
+    kCopyScalar,
+    kAfterValue,
+    kPass,
+  };
+
+  enum Action { kDrop, kKeep, kDescend };
+
+  static const size_t kMaxKey = 23;  // longer keys are kept unclassified
+
+  size_t step(const uint8_t* data, size_t length, const uint8_t** emit, size_t* emitLength);
+  void keyClosed();
+  void objectClosed();
+
+  State _state;
+  int _depth;           // object levels open, 1 inside the element
+  Action _action;       // for the value of the key just read
+  bool _keyEscaped;     // previous key byte was a backslash
+  bool _keyUnknown;     // the key had an escape or was longer than kMaxKey
+  size_t _keyLength;
+  char _key[kMaxKey + 1];
+  char _parent[kMaxKey + 1];  // key of the object at depth 2
+  JsonSkipper _skipper;
+};
+
+/**
+ * Push-mode counterpart of the incremental parser, for callers that receive
+ * the body in pieces and must not block waiting for the next one (the
+ * single-loop fetch cycle).
+ *
+ * feed() takes whatever bytes have arrived. Top-level members other than
+ * departureList are skipped with a JsonSkipper; each list element is copied
+ * into the caller's buffer through an ElementTrimmer (members the filter
+ * drops are not copied) until its closing byte, then deserialized and
+ * extracted like in parseDeparturesJsonIncremental. Elements past maxResults
+ * are skipped without copying. Outcomes match the pull parser's, including
+ * PARSE_PARTIAL when finish() is called inside departureList.
+ *
+ * With onDeparture() set, each departure is also handed out the moment its
+ * element closes, while the rest of the body may still be in flight.
+ */
+class DeparturePushParser {
+ public:
+  /**
+   * @param out Receives up to maxResults departures
+   * @param elementBuffer Holds one trimmed list element; an element whose kept
+   *        members do not fit fails with PARSE_ERR_NO_MEMORY
+   */
+  DeparturePushParser(Departure* out, int maxResults, char* elementBuffer, size_t elementCapacity)
+      : _out(out),
+        _maxResults(maxResults),
+        _element(elementBuffer),
+        _elementCapacity(elementCapacity),
+        _onDeparture(NULL),
+        _onDepartureContext(NULL) {
+    reset();
+  }
+
+  /**
+   * Call fn for every departure extracted from now on, in list order. Kept
+   * across reset(); entries repeated after reset(keep) are not reported again.
+   * fn runs inside feed() and must not feed this parser.
+   */
+  void onDeparture(DepartureFn fn, void* context) {
+    _onDeparture = fn;
+    _onDepartureContext = context;
+  }
+
+  /**
+   * Forget everything and expect the start of a new body.
+   *
+   * @param keep Departures out[0..keep) from an earlier response for the same
+   *        list stay, and count() starts at keep. The first keep elements of
+   *        the new body are checked against them (direction and planned time)
+   *        and only refresh them in place. From the first that differs (the
+   *        board dropped or inserted a departure in between) the list is
+   *        extracted and reported afresh; a list that ends before keep
+   *        elements cuts count() to its length.
+   */
+  void reset(int keep = 0);
+
+  /**
+   * Consume the next bytes of the body.
+   *
+   * @return Bytes consumed; less than length only once finished()
+   */
+  size_t feed(const uint8_t* data, size_t length);
+
+  /** The input has ended; settles the outcome if the parse was still running. */
+  void finish();
+
+  /** departureList was closed, or the parse failed; later bytes are not needed. */
+  bool finished() const { return _state == kDone || _state == kFailed; }
+
+  /** PARSE_OK while running and after success. */
+  ParseError error() const { return _error; }
+
+  /** Departures extracted so far. */
+  int count() const { return _count; }
+
+  /** Largest trimmed element copied into the element buffer since reset(), in bytes. */
+  size_t elementPeak() const { return _elementPeak; }
+
+  /** Largest document pool use of one deserialized element since reset(), in bytes. */
+  size_t poolPeak() const { return _poolPeak; }
+
+ private:
+  enum State {
+    kBeforeObject,
+    kBeforeKey,
+    kKey,
+    kBeforeColon,
+    kBeforeValue,
+    kSkipScalar,
+    kSkipValue,
+    kAfterValue,
+    kBeforeElement,
+    kElement,
+    kElementScalar,
+    kAfterElement,
+    kDone,
+    kFailed,
+  };
+
+  void fail(ParseError error);
+  bool inList() const { return _state >= kBeforeElement && _state <= kAfterElement; }
+  size_t step(const uint8_t* data, size_t length);
+  bool keepElement(const uint8_t* data, size_t length);
+  void elementComplete();
+  void listClosed();
+
+  Departure* _out;
+  int _maxResults;
+  char* _element;
+  size_t _elementCapacity;
+  DepartureFn _onDeparture;
+  void* _onDepartureContext;
+
+  State _state;
+  ParseError _error;
+  int _count;
+  int _skip;          // leading elements only checked (kept from an earlier body)
+  int _index;         // elements started so far
+  bool _first;        // no member/element seen yet in the current container
+  bool _isList;       // the key just read is "departureList"
+  bool _keyEscaped;   // previous key byte was a backslash
+  int _keyMatched;    // bytes of "departureList" matched so far, -1 on mismatch
+  bool _keep;         // the current element is copied and extracted
+  size_t _elementLength;
+  size_t _elementPeak;
+  size_t _poolPeak;
+  JsonSkipper _skipper;
+  ElementTrimmer _trimmer;
+};
+
+/**
+ * Out-parameter parse cores shared by the C ABI and the templated overloads.
+ *
+ * Each fills out[0..maxResults) and returns the outcome; *count receives the
+ * number of entries written (also on failure, for the entries before it).
+ */
+ParseError parseDeparturesJsonInto(const char* json, Departure* out, int maxResults, int* count);
+ParseError parseDeparturesJsonIncrementalInto(const char* json, Departure* out, int maxResults, int* count);
+ParseError parseDeparturesJsonIncrementalInto(DepartureSource& source, Departure* out, int maxResults, int* count);
+#ifdef ARDUINO
+ParseError parseDeparturesJsonStreamInto(Stream& stream, Departure* out, int maxResults, int* count);
+ParseError parseDeparturesJsonStreamIncrementalInto(Stream& stream, Departure* out, int maxResults, int* count);
+#endif  // ARDUINO
+
+template <int N>
+inline void setParseOutcome(DeparturesResultN<N>& result, ParseError error) {
+  result.error = error;
+  result.success = (error == PARSE_OK);
+}
+
+/** Parse up to N departures into a caller-owned result. */
+template <int N>
+inline void parseDeparturesJson(const char* json, DeparturesResultN<N>& result) {
+  setParseOutcome(result, parseDeparturesJsonInto(json, result.departures, N, &result.count));
+}
+
+/** Element-at-a-time parse of up to N departures into a caller-owned result. */
+template <int N>
+inline void parseDeparturesJsonIncremental(const char* json, DeparturesResultN<N>& result) {
+  setParseOutcome(result, parseDeparturesJsonIncrementalInto(json, result.departures, N, &result.count));
+}
+
+/** Element-at-a-time parse of up to N departures from a DepartureSource. */
+template <int N>
+inline void parseDeparturesJsonIncremental(DepartureSource& source, DeparturesResultN<N>& result) {
+  setParseOutcome(result, parseDeparturesJsonIncrementalInto(source, result.departures, N, &result.count));
+}
+
+#ifdef ARDUINO
+/** Streaming parse of up to N departures into a caller-owned result. */
+template <int N>
+inline void parseDeparturesJsonStream(Stream& stream, DeparturesResultN<N>& result) {
+  setParseOutcome(result, parseDeparturesJsonStreamInto(stream, result.departures, N, &result.count));
+}
+
+/** Streaming element-at-a-time parse of up to N departures into a caller-owned result. */
+template <int N>
+inline void parseDeparturesJsonStreamIncremental(Stream& stream, DeparturesResultN<N>& result) {
+  setParseOutcome(result, parseDeparturesJsonStreamIncrementalInto(stream, result.departures, N, &result.count));
+}
 #endif  // ARDUINO
 #endif  // __cplusplus
 
@@ -0,0 +1,43 @@
+#include "efa_config.h"
+
+#include <string.h>
+
+// Append text at *pos if it fits (leaving room for the NUL); false otherwise.
+static bool append(char* buffer, size_t capacity, size_t* pos, const char* text) {
+  size_t length = strlen(text);
+  if (*pos + length >= capacity) return false;
+  memcpy(buffer + *pos, text, length);
+  *pos += length;
+  return true;
+}
+
+static bool appendInt(char* buffer, size_t capacity, size_t* pos, int value) {
+  char digits[12];
+  char* p = digits + sizeof(digits);
+  unsigned int magnitude = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+  *--p = '\0';
+  do {
+    *--p = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) *--p = '-';
+  return append(buffer, capacity, pos, p);
+}
+
+size_t buildEfaRequest(char* buffer, size_t capacity, const char* stationId, int limit, bool keepAlive) {
+  size_t pos = 0;
+  bool ok = buffer != NULL && capacity > 0 && stationId != NULL &&
+            append(buffer, capacity, &pos, "GET " EFA_DM_PATH EFA_DM_QUERY_HEAD) &&
+            append(buffer, capacity, &pos, stationId) && append(buffer, capacity, &pos, EFA_DM_QUERY_MID) &&
+            appendInt(buffer, capacity, &pos, limit) &&
+            append(buffer, capacity, &pos,
+                   EFA_DM_QUERY_TAIL " HTTP/1.1\r\n"
+                                     "Host: " EFA_HOST "\r\n") &&
+            append(buffer, capacity, &pos, keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+  if (!ok) {
+    if (buffer != NULL && capacity > 0) buffer[0] = '\0';
+    return 0;
+  }
+  buffer[pos] = '\0';
+  return pos;
+}
@@ -0,0 +1,169 @@
+#ifndef EFA_CONFIG_H
+#define EFA_CONFIG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "departure_logic.h"
+
+// EFA departure-monitor endpoint. The query is split around the two values
+// that vary (stop ID and limit) so the compile-time URL literal and the
+// runtime request builder are assembled from the same fragments.
+#define EFA_HOST "efa.vagfr.de"
+#define EFA_PORT 80
+#define EFA_DM_PATH "/vagfr3/XSLT_DM_REQUEST"
+#define EFA_DM_QUERY_HEAD "?outputFormat=JSON&language=de&stateless=1&type_dm=stop&name_dm="
+#define EFA_DM_QUERY_MID "&mode=direct&useRealtime=1&limit="
+#define EFA_DM_QUERY_TAIL "&depType=stopEvents"
+
+// Largest limit= we accept. Each departureList entry adds ~1 KB of body.
+#define EFA_MAX_REQUEST_LIMIT 100
+
+#define EFA_STRINGIFY_(x) #x
+#define EFA_STRINGIFY(x) EFA_STRINGIFY_(x)
+
+/**
+ * Full request URL as a single string literal, assembled by the preprocessor.
+ *
+ * @param stationId String literal stop ID, e.g. "6906508"
+ * @param limit Integer literal (or macro expanding to one), e.g. 15
+ */
+#define EFA_DM_URL(stationId, limit) \
+  "http://" EFA_HOST EFA_DM_PATH EFA_DM_QUERY_HEAD stationId EFA_DM_QUERY_MID EFA_STRINGIFY(limit) EFA_DM_QUERY_TAIL
+
+#ifdef __cplusplus
+
+// Compile-time validators for the settings in secrets.h. Written as C++11
+// single-expression constexpr functions so they can drive static_assert; they
+// work on string literals and on constexpr char arrays alike.
+
+constexpr size_t configLength(const char* s) { return (*s == '\0') ? 0 : 1 + configLength(s + 1); }
+
+constexpr bool configAllDigits(const char* s) {
+  return (*s == '\0') ? true : (*s >= '0' && *s <= '9' && configAllDigits(s + 1));
+}
+
+constexpr bool configAllHexDigits(const char* s) {
+  return (*s == '\0') ? true
+                      : (((*s >= '0' && *s <= '9') || (*s >= 'a' && *s <= 'f') || (*s >= 'A' && *s <= 'F')) &&
+                         configAllHexDigits(s + 1));
+}
+
+constexpr bool configEquals(const char* a, const char* b) {
+  return (*a != *b) ? false : (*a == '\0') ? true : configEquals(a + 1, b + 1);
+}
+
+/**
+ * The values secrets.h.example and the README ship with. They would pass the
+ * length checks, so they are rejected by name rather than left to fail at
+ * run time as "WiFi did not connect".
+ */
+constexpr bool configIsPlaceholder(const char* s) {
+  return configEquals(s, "YOUR_WIFI_SSID") || configEquals(s, "your-network") ||
+         configEquals(s, "YOUR_WIFI_PASSWORD") || configEquals(s, "your-password") ||
+         configEquals(s, "YOUR_DIRECTION");
+}
+
+/** EFA stop IDs are short numeric strings; anything else is a placeholder or typo. */
+constexpr bool isValidStationId(const char* id) {
+  return id[0] != '\0' && configLength(id) <= 10 && configAllDigits(id);
+}
+
+/** 802.11 SSIDs are 1-32 bytes; the example placeholder is not an SSID. */
+constexpr bool isValidWifiSsid(const char* ssid) {
+  return ssid[0] != '\0' && configLength(ssid) <= 32 && !configIsPlaceholder(ssid);
+}
+
+/**
+ * Empty for an open network, a WPA2 passphrase of 8-63 characters, or the
+ * raw 256-bit PSK as 64 hex digits; not the example placeholder.
+ */
+constexpr bool isValidWifiPassword(const char* password) {
+  return password[0] == '\0' ||
+         (configLength(password) >= 8 && configLength(password) <= 63 && !configIsPlaceholder(password)) ||
+         (configLength(password) == 64 && configAllHexDigits(password));
+}
+
+constexpr bool isValidRequestLimit(int limit) { return limit >= 1 && limit <= EFA_MAX_REQUEST_LIMIT; }
+
+constexpr bool configIsBlank(char c) { return c == ' ' || c == '\t'; }
+
+// End of the keyword starting at i: the next ',' or the terminator.
+constexpr size_t configKeywordEnd(const char* s, size_t i) {
+  return (s[i] == '\0' || s[i] == ',') ? i : configKeywordEnd(s, i + 1);
+}
+
+constexpr size_t configTrimStart(const char* s, size_t begin, size_t end) {
+  return (begin < end && configIsBlank(s[begin])) ? configTrimStart(s, begin + 1, end) : begin;
+}
+
+constexpr size_t configTrimEnd(const char* s, size_t begin, size_t end) {
+  return (end > begin && configIsBlank(s[end - 1])) ? configTrimEnd(s, begin, end - 1) : end;
+}
+
+// A match term must be non-empty and short enough to fit in a parsed
+// direction, which is truncated to MAX_DIRECTION_LEN - 1 characters.
+constexpr int configTermStatus(size_t length) {
+  return (length == 0 || length > (size_t)(MAX_DIRECTION_LEN - 1)) ? -1 : 1;
+}
+
+// Classify the trimmed keyword s[begin, end): 0 empty (ignored, as after a
+// trailing comma), 1 usable, -1 invalid (bare '!' or an unmatchable term).
+constexpr int configKeywordStatus(const char* s, size_t begin, size_t end) {
+  return (begin == end) ? 0 : configTermStatus((s[begin] == '!') ? end - begin - 1 : end - begin);
+}
+
+constexpr int configTrimmedKeywordStatus(const char* s, size_t start, size_t end) {
+  return configKeywordStatus(s, configTrimStart(s, start, end), configTrimEnd(s, configTrimStart(s, start, end), end));
+}
+
+constexpr bool configFilterValidFrom(const char* s, size_t start, bool usable);
+
+constexpr bool configFilterValidAt(const char* s, size_t end, int status, bool usable) {
+  return (status < 0) ? false
+                      : (s[end] == '\0') ? (usable || status > 0)
+                                         : configFilterValidFrom(s, end + 1, usable || status > 0);
+}
+
+constexpr bool configFilterValidFrom(const char* s, size_t start, bool usable) {
+  return configFilterValidAt(s, configKeywordEnd(s, start),
+                             configTrimmedKeywordStatus(s, start, configKeywordEnd(s, start)), usable);
+}
+
+/**
+ * Check DIRECTION_FILTER syntax as matchesDirectionFilter will read it.
+ *
+ * Empty is valid (show everything). Otherwise at least one keyword must be
+ * usable, since a filter of only separators/whitespace hides every departure,
+ * and no keyword may be a bare '!' or longer than a direction can be. The
+ * example placeholder is rejected too: it is valid syntax that matches nothing.
+ */
+constexpr bool isValidDirectionFilter(const char* filter) {
+  return filter[0] == '\0' || (!configIsPlaceholder(filter) && configFilterValidFrom(filter, 0, false));
+}
+
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * Write the EFA departure-monitor HTTP GET request into a caller buffer.
+ *
+ * Produces the request line (same path and query as EFA_DM_URL) plus the Host
+ * and Connection headers and the terminating blank line. Nothing is allocated;
+ * the output is NUL-terminated.
+ *
+ * @param buffer Destination
+ * @param capacity Size of buffer in bytes
+ * @param stationId Numeric stop ID
+ * @param limit Value for limit=
+ * @param keepAlive Ask the server to keep the connection open for the next
+ *        request ("Connection: keep-alive") instead of closing it
+ * @return Request length excluding the NUL, or 0 if it did not fit
+ */
+size_t buildEfaRequest(char* buffer, size_t capacity, const char* stationId, int limit, bool keepAlive);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // EFA_CONFIG_H
@@ -0,0 +1,322 @@
+#include "fetch_cycle.h"
+
+FetchCycle::FetchCycle(FetchPlatform& platform, HttpTransport& transport, const FetchRequest& request,
+                       ResultSlots result)
+    : _platform(platform),
+      _client(transport),
+      _request(request),
+      _result(result),
+      _parser(result.departures, result.capacity, _elementBuffer, sizeof(_elementBuffer)),
+      _state(kIdle),
+      _outcome(FETCH_OK),
+      _httpCode(0),
+      _attempt(0),
+      _limit(request.limit),
+      _secondFetch(false),
+      _firstCount(0),
+      _headersSeen(false),
+      _wifiWasUp(false),
+      _drainedBytes(0),
+      _nowUs(0),
+      _startUs(0),
+      _finishedUs(0),
+      _deadlineUs(0),
+      _nextFrameUs(0),
+      _frame(0),
+      _requestStartUs(0),
+      _bodyStartUs(0),
+      _parseUs(0),
+      _platformUs(0) {
+  _parser.onDeparture(forwardDeparture, this);
+}
+
+static uint32_t elapsedMs(uint64_t fromUs, uint64_t toUs) { return (uint32_t)((toUs - fromUs) / 1000); }
+
+void FetchCycle::start(int limit) {
+  _nowUs = _platform.nowUs();
+  _attempt = 0;
+  _limit = (limit < _result.capacity) ? limit : _result.capacity;
+  _secondFetch = false;
+  _firstCount = 0;
+  _httpCode = 0;
+  _outcome = FETCH_OK;
+  _frame = 0;
+  _nextFrameUs = _nowUs;  // first frame on the first step
+  _requestStartUs = _nowUs;
+  _startUs = _nowUs;
+
+  _wifiWasUp = _platform.wifiConnected();
+  if (!_wifiWasUp) {
+    _platform.enterPhase(PHASE_WIFI_CONNECT);
+    _platform.wifiBegin();
+  }
+  _deadlineUs = _nowUs + kWifiTimeoutMs * 1000ULL;
+  _state = kWifiConnect;
+}
+
+uint32_t FetchCycle::step() {
+  _nowUs = _platform.nowUs();
+  bool busy = false;
+
+  switch (_state) {
+    case kWifiConnect:
+      if (_platform.wifiConnected()) {
+        if (!_wifiWasUp) _platform.recordLatency(LATENCY_WIFI_CONNECT, elapsedMs(_requestStartUs, _nowUs));
+        startAttempt();
+        busy = true;
+      } else if (_nowUs >= _deadlineUs) {
+        finish(FETCH_ERR_WIFI);
+      }
+      break;
+
+    case kReceive:
+      busy = receive();
+      break;
+
+    case kDrain:
+      busy = drain();
+      break;
+
+    case kRetryWait:
+      if (_nowUs >= _deadlineUs) {
+        startAttempt();
+        busy = true;
+      }
+      break;
+
+    case kIdle:
+    case kFinished:
+      break;
+  }
+
+  if (_state == kIdle || _state == kFinished) return 0;
+  uint32_t idleMs = animate();
+  if (busy) return 0;
+
+  uint32_t untilDeadline = idleUntil(_deadlineUs);
+  if (untilDeadline < idleMs) idleMs = untilDeadline;
+  // WiFi and the socket have no wake-up signal here, so they are polled.
+  if (_state != kRetryWait && idleMs > kPollMs) idleMs = kPollMs;
+  return idleMs;
+}
+
+// Draw a spinner frame if one is due; returns the time until the next one.
+uint32_t FetchCycle::animate() {
+  if (_nowUs >= _nextFrameUs) {
+    _platform.drawSpinner(_frame++);
+    // Keep the cadence, but after a long step skip frames instead of
+    // drawing the missed ones back to back.
+    _nextFrameUs += kFrameMs * 1000ULL;
+    if (_nextFrameUs <= _nowUs) _nextFrameUs = _nowUs + kFrameMs * 1000ULL;
+  }
+  return idleUntil(_nextFrameUs);
+}
+
+// Whole milliseconds until deadlineUs, rounded up so an idle of that length
+// never wakes the caller before it.
+uint32_t FetchCycle::idleUntil(uint64_t deadlineUs) const {
+  if (_nowUs >= deadlineUs) return 0;
+  return (uint32_t)((deadlineUs - _nowUs + 999) / 1000);
+}
+
+void FetchCycle::startAttempt() {
+  _attempt++;
+  _headersSeen = false;
+  _drainedBytes = 0;
+  _httpCode = 0;
+  _parseUs = 0;
+  _parser.reset(_firstCount);
+  _platform.enterPhase(PHASE_HTTP_WAIT);
+  _requestStartUs = _nowUs;
+
+  // Connecting is the one call that may block (DNS and the TCP handshake,
+  // bounded by the transport's own timeout).
+  bool sent = _client.get(_request.host, _request.port, _request.stationId, _limit, _request.keepAlive);
+  _nowUs = _platform.nowUs();
+  if (!sent) {
+    attemptFailed(_client.resultCode(), kRetryDelayMs);
+    return;
+  }
+  _state = kReceive;
+  _deadlineUs = _nowUs + kIdleTimeoutMs * 1000ULL;
+}
+
+// Read and parse what the transport has until it runs dry or the next
+// spinner frame is due; at least one read per step. Returns whether anything
+// happened that warrants stepping again right away.
+bool FetchCycle::receive() {
+  for (int i = 0;; i++) {
+    if (i > 0 && _nowUs >= _nextFrameUs) return true;
+    int n = _client.receive(_readBuffer, sizeof(_readBuffer));
+    if (!_headersSeen && _client.response().headersDone()) {
+      headersReceived();
+      if (_state != kReceive) return true;
+    }
+
+    if (n > 0) {
+      uint64_t parseStartUs = _platform.nowUs();
+      _platformUs = 0;
+      _parser.feed(_readBuffer, (size_t)n);
+      _nowUs = _platform.nowUs();
+      _parseUs += _nowUs - parseStartUs - _platformUs;
+      _deadlineUs = _nowUs + kIdleTimeoutMs * 1000ULL;
+      if (_parser.finished()) {
+        // departureList is closed (or broken): the rest of the body is not
+        // needed, except to keep the connection for the next cycle.
+        if (_request.keepAlive && _parser.error() == PARSE_OK && _client.response().keepAlive()) {
+          _state = kDrain;
+        } else {
+          bodyEnded();
+        }
+        return true;
+      }
+      continue;
+    }
+
+    if (n < 0) {
+      if (_headersSeen) {
+        bodyEnded();
+      } else {
+        int code = _client.resultCode();
+        // A kept connection the server closed while idle is not a network
+        // problem: retry on a fresh one right away.
+        attemptFailed((code < 0) ? code : -HTTP_ERR_CLOSED_EARLY, _client.reused() ? 0 : kRetryDelayMs);
+      }
+      return true;
+    }
+
+    // Nothing buffered right now.
+    if (_nowUs >= _deadlineUs) {
+      if (_headersSeen) {
+        bodyEnded();  // a stalled body ends like a closed one; the parser decides
+      } else {
+        attemptFailed(-HTTP_ERR_TIMEOUT, kRetryDelayMs);
+      }
+      return true;
+    }
+    return i > 0;
+  }
+}
+
+// Hand a departure to the platform as soon as the parser has it, and keep
+// the time the platform spends on it (drawing a row) out of parse time.
+void FetchCycle::forwardDeparture(void* context, const Departure* departure, int index) {
+  FetchCycle* cycle = (FetchCycle*)context;
+  uint64_t startUs = cycle->_platform.nowUs();
+  cycle->_platform.departureParsed(departure, index);
+  cycle->_platformUs += cycle->_platform.nowUs() - startUs;
+}
+
+// Read and discard the rest of the body after departureList (normally just
+// the closing brace) so the connection can carry the next request. A long
+// tail is not worth it: past kMaxDrainBytes the connection is dropped.
+bool FetchCycle::drain() {
+  for (int i = 0;; i++) {
+    if (i > 0 && _nowUs >= _nextFrameUs) return true;
+    int n = _client.receive(_readBuffer, sizeof(_readBuffer));
+    if (n > 0) {
+      _drainedBytes += (size_t)n;
+      _nowUs = _platform.nowUs();
+      _deadlineUs = _nowUs + kIdleTimeoutMs * 1000ULL;
+      if (_drainedBytes > kMaxDrainBytes) break;
+      continue;
+    }
+    if (n == 0 && _nowUs < _deadlineUs) return i > 0;
+    break;
+  }
+  bodyEnded();
+  return true;
+}
+
+void FetchCycle::headersReceived() {
+  _headersSeen = true;
+  _httpCode = _client.response().statusCode();
+  if (_httpCode != 200) {
+    // Server errors are retried straight away, as with the old HTTPClient loop.
+    attemptFailed(_httpCode, 0);
+    return;
+  }
+  _nowUs = _platform.nowUs();
+  _platform.recordLatency(LATENCY_FIRST_BYTE, elapsedMs(_requestStartUs, _nowUs));
+  _platform.enterPhase(PHASE_RECEIVE);
+  _bodyStartUs = _nowUs;
+}
+
+void FetchCycle::bodyEnded() {
+  if (!_client.reusable()) _client.close();
+  _parser.finish();
+  _platform.recordLatency(LATENCY_BODY_TRANSFER, elapsedMs(_bodyStartUs, _nowUs));
+  _platform.recordLatency(LATENCY_PARSE, (uint32_t)(_parseUs / 1000));
+
+  // A body cut off mid-list still carries every departure received before
+  // the cut. When the displayed rows are already there a retry would fetch
+  // the whole body again for nothing; on the last attempt any displayable
+  // row beats an error screen.
+  ParseError error = _parser.error();
+  int displayable = countDisplayableDepartures(_result.departures, _parser.count(), _request.directionFilter);
+  bool partialUsable = (error == PARSE_PARTIAL) &&
+                       (displayable >= _request.displayRows || (_attempt >= kMaxAttempts && displayable > 0));
+
+  if (error == PARSE_OK && startSecondFetch(displayable)) return;
+
+  if (error == PARSE_OK || partialUsable || _secondFetch) {
+    // A second request that fails still leaves the first response's rows.
+    finish(FETCH_OK);
+  } else if (error == PARSE_ERR_NO_MEMORY) {
+    // Deterministic for this payload: retrying cannot help.
+    finish(FETCH_ERR_TOO_LARGE);
+  } else {
+    attemptFailed(_httpCode, kRetryDelayMs);
+  }
+}
+
+// The list came back full but did not fill the display: more entries exist,
+// and the platform may ask for them once. The second response normally
+// repeats the first entries; the parser checks that they still line up (the
+// board may have moved on in between) and only reports the ones that are new.
+bool FetchCycle::startSecondFetch(int displayable) {
+  if (_secondFetch || _parser.count() < _limit || displayable >= _request.displayRows) return false;
+  int limit = _platform.secondLimit(_limit, displayable);
+  if (limit > _result.capacity) limit = _result.capacity;
+  if (limit <= _limit) return false;
+
+  _secondFetch = true;
+  _firstCount = _parser.count();
+  _limit = limit;
+  startAttempt();
+  return true;
+}
+
+void FetchCycle::attemptFailed(int httpCode, uint32_t retryDelayMs) {
+  _client.close();
+  if (_secondFetch) {
+    // Not retried: the first response is on hand.
+    finish(FETCH_OK);
+    return;
+  }
+  _httpCode = httpCode;
+  if (_attempt >= kMaxAttempts) {
+    if (httpCode < 0) {
+      finish(FETCH_ERR_NETWORK);
+    } else if (httpCode != 200) {
+      finish(FETCH_ERR_SERVER);
+    } else {
+      finish(FETCH_ERR_PARSE);
+    }
+    return;
+  }
+  _state = kRetryWait;
+  _deadlineUs = _nowUs + retryDelayMs * 1000ULL;
+}
+
+void FetchCycle::finish(FetchOutcome outcome) {
+  _state = kFinished;
+  _finishedUs = _nowUs;
+  _outcome = outcome;
+  *_result.count = (outcome == FETCH_OK) ? _parser.count() : 0;
+  *_result.success = (outcome == FETCH_OK);
+  *_result.error = _parser.error();
+  if (outcome == FETCH_OK) _platform.enterPhase(PHASE_RENDER);
+  _platform.showResult(outcome, _httpCode, _result.departures, *_result.count);
+  if (outcome == FETCH_OK) _platform.recordLatency(LATENCY_TOTAL, (uint32_t)(_platform.nowUs() / 1000));
+}
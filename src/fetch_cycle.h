@@ -0,0 +1,217 @@
+#ifndef FETCH_CYCLE_H
+#define FETCH_CYCLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "departure_logic.h"
+#include "http_client.h"
+#include "latency_histogram.h"
+#include "power_governor.h"
+
+/**
+ * The whole wake-cycle fetch (WiFi connect, request, receive and parse, then
+ * the result screen) as a non-blocking state machine.
+ *
+ * setup() calls step() in a loop; every call does a bounded amount of work,
+ * draws a spinner frame when one is due and returns how long the caller may
+ * idle before the next call. Receiving is bounded by time rather than bytes:
+ * a step reads and parses for as long as the socket has data and the next
+ * spinner frame is not yet due, so the socket is drained at network speed
+ * and only the frame (a few ms every kFrameMs) interrupts it. There is no second task and no display mutex:
+ * the spinner, the socket and the parser all run on the loop task, between
+ * each other. Deadlines (WiFi, idle receive, retry back-off) are absolute
+ * times checked on every step, and the idle hint never runs past one, so they
+ * fire on time rather than on the next multiple of a poll interval.
+ *
+ * Everything board-specific goes through FetchPlatform and HttpTransport, so
+ * the host tests drive the machine with a fake clock and scripted I/O.
+ */
+
+/** How a fetch cycle ended. */
+typedef enum {
+  FETCH_OK = 0,         // departures parsed (possibly from a usable partial body)
+  FETCH_ERR_WIFI,       // WiFi did not connect before its deadline
+  FETCH_ERR_NETWORK,    // last attempt failed below HTTP; httpCode is -HttpError
+  FETCH_ERR_SERVER,     // last attempt got a status other than 200
+  FETCH_ERR_PARSE,      // last attempt's body could not be parsed
+  FETCH_ERR_TOO_LARGE,  // a departure's kept members did not fit the element buffer; not retried
+} FetchOutcome;
+
+/** Board services the fetch cycle needs; fakes implement it on the host. */
+class FetchPlatform {
+ public:
+  virtual ~FetchPlatform() {}
+
+  /** Monotonic time since boot. */
+  virtual uint64_t nowUs() = 0;
+
+  virtual void wifiBegin() = 0;
+  virtual bool wifiConnected() = 0;
+
+  /** A new phase starts; the firmware applies its power policy here. */
+  virtual void enterPhase(BootPhase phase) = 0;
+
+  /** Draw spinner frame number frame (counts up from 0). */
+  virtual void drawSpinner(int frame) = 0;
+
+  virtual void recordLatency(LatencyMetric metric, uint32_t ms) = 0;
+
+  /**
+   * A departure was parsed: departures[0..index] are final while the rest of
+   * the body is still arriving, so rows can go up before the last byte. Each
+   * attempt reports from the start of its list again. A second request
+   * reports from its first entry that is not a repeat of the first
+   * response's, which is before the end of that response when the board
+   * changed in between. showResult() follows with the outcome. Time spent
+   * here does not count as parse time.
+   */
+  virtual void departureParsed(const Departure* /*departure*/, int /*index*/) {}
+
+  /**
+   * A full list of limit entries had only displayable < displayRows usable
+   * ones. Return a larger limit for one more request, or 0 to show what there
+   * is. The default never asks again.
+   */
+  virtual int secondLimit(int /*limit*/, int /*displayable*/) { return 0; }
+
+  /**
+   * Show the outcome: the departures on FETCH_OK, an error screen otherwise.
+   * httpCode is the last status code or -HttpError.
+   */
+  virtual void showResult(FetchOutcome outcome, int httpCode, const Departure* departures, int count) = 0;
+};
+
+/** What to fetch and how to judge the result. */
+typedef struct {
+  const char* host;
+  uint16_t port;
+  const char* stationId;
+  int limit;                    // departures requested by the first request, unless start() is given one
+  const char* directionFilter;  // for deciding whether a partial body suffices
+  int displayRows;              // displayable departures that make a partial body usable
+  bool keepAlive;               // keep the connection for the next cycle (always-on refresh)
+} FetchRequest;
+
+class FetchCycle {
+ public:
+  static const uint32_t kWifiTimeoutMs = 10000;
+  static const uint32_t kIdleTimeoutMs = 15000;  // no bytes for this long ends an attempt
+  static const uint32_t kRetryDelayMs = 2000;    // after network and parse failures
+  static const uint32_t kFrameMs = 100;          // spinner frame period
+  static const uint32_t kPollMs = 10;            // longest idle while waiting on WiFi or the socket
+  static const int kMaxAttempts = 3;
+  static const size_t kReadChunk = 1024;         // bytes read from the transport per call
+  static const size_t kElementBufferSize = 4096; // kept members of one departureList element
+  static const size_t kMaxDrainBytes = 4096;     // body after departureList read to keep the connection
+
+  /**
+   * @param result Receives up to N departures, which also caps every request's
+   *        limit; must outlive the cycle. Once finished, count holds the
+   *        departures shown (0 unless FETCH_OK), success whether the outcome
+   *        is FETCH_OK, and error how the last body parsed (PARSE_OK if none
+   *        was received).
+   */
+  template <int N>
+  FetchCycle(FetchPlatform& platform, HttpTransport& transport, const FetchRequest& request,
+             DeparturesResultN<N>& result)
+      : FetchCycle(platform, transport, request,
+                   ResultSlots{result.departures, N, &result.count, &result.success, &result.error}) {}
+
+  /**
+   * Begin a cycle: enters PHASE_WIFI_CONNECT and starts the WiFi connect.
+   * A cycle that finds WiFi still up (always-on refresh) goes straight to the
+   * request, over the previous cycle's connection when it was kept.
+   */
+  void start() { start(_request.limit); }
+
+  /** As start(), asking the first request for limit departures instead of request.limit. */
+  void start(int limit);
+
+  /**
+   * Advance as far as possible without blocking.
+   *
+   * @return Milliseconds the caller may idle before calling again (0 = call
+   *         again right away); never past the next deadline or spinner frame
+   */
+  uint32_t step();
+
+  /** The result has been shown; nothing is left to do. */
+  bool finished() const { return _state == kFinished; }
+
+  FetchOutcome outcome() const { return _outcome; }
+  int httpCode() const { return _httpCode; }
+  int attempts() const { return _attempt; }
+  int limit() const { return _limit; }
+  bool reusedConnection() const { return _client.reused(); }
+  /** start() until the result was shown. */
+  uint32_t durationMs() const { return (uint32_t)((_finishedUs - _startUs) / 1000); }
+  bool secondFetch() const { return _secondFetch; }
+  int count() const { return _parser.count(); }
+  ParseError parseError() const { return _parser.error(); }
+
+ private:
+  // DeparturesResultN<N> without N, so that only the constructor is a template.
+  struct ResultSlots {
+    Departure* departures;
+    int capacity;
+    int* count;
+    bool* success;
+    ParseError* error;
+  };
+
+  FetchCycle(FetchPlatform& platform, HttpTransport& transport, const FetchRequest& request, ResultSlots result);
+
+  enum State {
+    kIdle,
+    kWifiConnect,
+    kReceive,
+    kDrain,
+    kRetryWait,
+    kFinished,
+  };
+
+  uint32_t animate();
+  void startAttempt();
+  bool receive();
+  bool drain();
+  void headersReceived();
+  void bodyEnded();
+  bool startSecondFetch(int displayable);
+  void attemptFailed(int httpCode, uint32_t retryDelayMs);
+  void finish(FetchOutcome outcome);
+  uint32_t idleUntil(uint64_t deadlineUs) const;
+  static void forwardDeparture(void* context, const Departure* departure, int index);
+
+  FetchPlatform& _platform;
+  HttpGetClient _client;
+  FetchRequest _request;
+  ResultSlots _result;
+  DeparturePushParser _parser;
+
+  State _state;
+  FetchOutcome _outcome;
+  int _httpCode;
+  int _attempt;
+  int _limit;         // of the request in flight
+  bool _secondFetch;  // the request in flight is the one extra, larger request
+  int _firstCount;    // departures kept from the first response during it
+  bool _headersSeen;
+  bool _wifiWasUp;       // WiFi was connected at start(); no connect to time
+  size_t _drainedBytes;  // body discarded after departureList this attempt
+  uint64_t _nowUs;
+  uint64_t _startUs;
+  uint64_t _finishedUs;
+  uint64_t _deadlineUs;  // WiFi, idle receive or retry deadline, by state
+  uint64_t _nextFrameUs;
+  int _frame;
+  uint64_t _requestStartUs;
+  uint64_t _bodyStartUs;
+  uint64_t _parseUs;  // time spent in the parser this attempt
+  uint64_t _platformUs;  // of that, time in departureParsed() during the current feed
+
+  uint8_t _readBuffer[kReadChunk];
+  char _elementBuffer[kElementBufferSize];
+};
+
+#endif  // FETCH_CYCLE_H
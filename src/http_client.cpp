@@ -0,0 +1,309 @@
+#include "http_client.h"
+
+#include <string.h>
+
+#include "efa_config.h"
+
+static char lowerAscii(char c) { return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c; }
+
+static bool equalsIgnoreCase(const char* s, size_t length, const char* lower) {
+  for (size_t i = 0; i < length; i++) {
+    if (lower[i] == '\0' || lowerAscii(s[i]) != lower[i]) return false;
+  }
+  return lower[length] == '\0';
+}
+
+static bool containsIgnoreCase(const char* s, size_t length, const char* lower) {
+  size_t needle = strlen(lower);
+  for (size_t i = 0; i + needle <= length; i++) {
+    if (equalsIgnoreCase(s + i, needle, lower)) return true;
+  }
+  return false;
+}
+
+static int hexValue(uint8_t c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static bool isBlank(char c) { return c == ' ' || c == '\t'; }
+
+void HttpResponseDecoder::reset() {
+  _state = kStatusLine;
+  _error = HTTP_ERR_NONE;
+  _status = 0;
+  _contentLength = -1;
+  _chunked = false;
+  _keepAlive = false;
+  _http11 = false;
+  _headersDone = false;
+  _remaining = 0;
+  _bodyBytes = 0;
+  _chunkDigits = 0;
+  _lineLength = 0;
+}
+
+void HttpResponseDecoder::fail(HttpError error) {
+  _state = kFailed;
+  _error = error;
+}
+
+void HttpResponseDecoder::endOfInput() {
+  if (_state == kBodyUntilClose) {
+    _state = kDone;
+  } else if (_state != kDone && _state != kFailed) {
+    fail(HTTP_ERR_CLOSED_EARLY);
+  }
+}
+
+size_t HttpResponseDecoder::decode(uint8_t* data, size_t length) {
+  // Body bytes are compacted towards the front: out never passes in, so the
+  // move is in place and only happens after framing bytes were dropped.
+  size_t in = 0;
+  size_t out = 0;
+  while (in < length) {
+    switch (_state) {
+      case kStatusLine:
+      case kHeaderLine:
+      case kTrailerLine: {
+        uint8_t c = data[in++];
+        if (c == '\n') {
+          lineComplete();
+        } else {
+          if (_lineLength < kMaxLine - 1) _line[_lineLength] = (char)c;
+          _lineLength++;
+        }
+        break;
+      }
+
+      case kBodyIdentity:
+      case kBodyUntilClose:
+      case kChunkData: {
+        size_t n = length - in;
+        if (_state != kBodyUntilClose && n > _remaining) n = _remaining;
+        if (out != in) memmove(data + out, data + in, n);
+        in += n;
+        out += n;
+        _bodyBytes += n;
+        if (_state != kBodyUntilClose) {
+          _remaining -= n;
+          if (_remaining == 0) _state = (_state == kChunkData) ? kChunkDataEnd : kDone;
+        }
+        break;
+      }
+
+      case kChunkSize:
+        chunkSizeByte(data[in++]);
+        break;
+
+      case kChunkExtension:
+        if (data[in++] == '\n') chunkSizeLineComplete();
+        break;
+
+      case kChunkDataEnd: {
+        uint8_t c = data[in++];
+        if (c == '\n') {
+          _state = kChunkSize;
+          _chunkDigits = 0;
+        } else if (c != '\r') {
+          fail(HTTP_ERR_BAD_CHUNK);
+        }
+        break;
+      }
+
+      case kDone:
+      case kFailed:
+        // Anything after the response (or after garbage) is not ours.
+        return out;
+    }
+  }
+  return out;
+}
+
+void HttpResponseDecoder::lineComplete() {
+  size_t length = (_lineLength < kMaxLine - 1) ? _lineLength : kMaxLine - 1;
+  if (length > 0 && _line[length - 1] == '\r') length--;
+  _line[length] = '\0';
+  _lineLength = 0;
+
+  switch (_state) {
+    case kStatusLine:
+      if (length > 0) handleStatusLine(length);  // tolerate stray CRLF before the status line
+      break;
+    case kHeaderLine:
+      if (length == 0) {
+        startBody();
+      } else {
+        handleHeaderLine(length);
+      }
+      break;
+    case kTrailerLine:
+      if (length == 0) _state = kDone;  // trailer fields are ignored
+      break;
+    default:
+      break;
+  }
+}
+
+void HttpResponseDecoder::handleStatusLine(size_t length) {
+  // "HTTP/1.x NNN[ reason]"
+  static const char kPrefix[] = "HTTP/1.";
+  const size_t prefixLength = sizeof(kPrefix) - 1;
+  if (length < prefixLength + 5 || strncmp(_line, kPrefix, prefixLength) != 0) return fail(HTTP_ERR_BAD_STATUS);
+  const char* p = _line + prefixLength;
+  if (p[0] < '0' || p[0] > '9' || p[1] != ' ') return fail(HTTP_ERR_BAD_STATUS);
+  _http11 = (p[0] >= '1');
+  p += 2;
+  int status = 0;
+  for (int i = 0; i < 3; i++) {
+    if (p[i] < '0' || p[i] > '9') return fail(HTTP_ERR_BAD_STATUS);
+    status = status * 10 + (p[i] - '0');
+  }
+  if (p[3] != '\0' && p[3] != ' ') return fail(HTTP_ERR_BAD_STATUS);
+
+  _status = status;
+  _keepAlive = _http11;
+  _contentLength = -1;
+  _chunked = false;
+  _state = kHeaderLine;
+}
+
+void HttpResponseDecoder::handleHeaderLine(size_t length) {
+  const char* colon = (const char*)memchr(_line, ':', length);
+  if (colon == NULL) return;  // not a field; ignore rather than fail the response
+
+  size_t nameLength = (size_t)(colon - _line);
+  while (nameLength > 0 && isBlank(_line[nameLength - 1])) nameLength--;
+  const char* value = colon + 1;
+  const char* end = _line + length;
+  while (value < end && isBlank(*value)) value++;
+  while (end > value && isBlank(end[-1])) end--;
+  size_t valueLength = (size_t)(end - value);
+
+  if (equalsIgnoreCase(_line, nameLength, "content-length")) {
+    if (valueLength == 0 || valueLength > 9) return fail(HTTP_ERR_BAD_HEADER);
+    long parsed = 0;
+    for (size_t i = 0; i < valueLength; i++) {
+      if (value[i] < '0' || value[i] > '9') return fail(HTTP_ERR_BAD_HEADER);
+      parsed = parsed * 10 + (value[i] - '0');
+    }
+    _contentLength = parsed;
+  } else if (equalsIgnoreCase(_line, nameLength, "transfer-encoding")) {
+    _chunked = containsIgnoreCase(value, valueLength, "chunked");
+  } else if (equalsIgnoreCase(_line, nameLength, "connection")) {
+    if (containsIgnoreCase(value, valueLength, "close")) _keepAlive = false;
+    if (containsIgnoreCase(value, valueLength, "keep-alive")) _keepAlive = true;
+  }
+}
+
+void HttpResponseDecoder::startBody() {
+  if (_status >= 100 && _status < 200) {
+    // Interim response (e.g. 100 Continue): the real one follows.
+    _state = kStatusLine;
+    return;
+  }
+
+  _headersDone = true;
+  if (_status == 204 || _status == 304) {
+    _state = kDone;
+  } else if (_chunked) {
+    _state = kChunkSize;
+    _chunkDigits = 0;
+    _remaining = 0;
+  } else if (_contentLength >= 0) {
+    _remaining = (size_t)_contentLength;
+    _state = (_remaining > 0) ? kBodyIdentity : kDone;
+  } else {
+    // Delimited by the server closing the connection.
+    _keepAlive = false;
+    _state = kBodyUntilClose;
+  }
+}
+
+void HttpResponseDecoder::chunkSizeByte(uint8_t c) {
+  int digit = hexValue(c);
+  if (digit >= 0) {
+    // Seven hex digits allow chunks up to 256 MB; more is certainly garbage.
+    if (_chunkDigits == 0) _remaining = 0;
+    if (++_chunkDigits > 7) return fail(HTTP_ERR_BAD_CHUNK);
+    _remaining = _remaining * 16 + (size_t)digit;
+  } else if (c == ';' || isBlank((char)c)) {
+    if (_chunkDigits == 0) return fail(HTTP_ERR_BAD_CHUNK);
+    _state = kChunkExtension;
+  } else if (c == '\n') {
+    chunkSizeLineComplete();
+  } else if (c != '\r') {
+    fail(HTTP_ERR_BAD_CHUNK);
+  }
+}
+
+void HttpResponseDecoder::chunkSizeLineComplete() {
+  if (_chunkDigits == 0) return fail(HTTP_ERR_BAD_CHUNK);
+  if (_remaining == 0) {
+    _state = kTrailerLine;  // last chunk; trailers end with an empty line
+    _lineLength = 0;
+  } else {
+    _state = kChunkData;
+  }
+}
+
+bool HttpGetClient::get(const char* host, uint16_t port, const char* stationId, int limit, bool keepAlive) {
+  _reused = keepAlive && reusable();
+  if (!_reused) close();
+  _response.reset();
+  _error = HTTP_ERR_NONE;
+
+  size_t length = buildEfaRequest(_request, sizeof(_request), stationId, limit, keepAlive);
+  if (length == 0) {
+    _error = HTTP_ERR_REQUEST_TOO_LONG;
+    close();
+    return false;
+  }
+  if (_reused) {
+    if (_transport.write((const uint8_t*)_request, length)) return true;
+    // The server timed out the idle connection: start over on a new one.
+    close();
+    _reused = false;
+  }
+  if (!_transport.connect(host, port)) {
+    _error = HTTP_ERR_CONNECT;
+    return false;
+  }
+  _open = true;
+  if (!_transport.write((const uint8_t*)_request, length)) {
+    _error = HTTP_ERR_SEND;
+    close();
+    return false;
+  }
+  return true;
+}
+
+int HttpGetClient::receive(uint8_t* buffer, size_t capacity) {
+  if (!_open || capacity == 0) return -1;
+  for (;;) {
+    if (_response.done() || _response.failed()) return -1;
+    int n = _transport.read(buffer, capacity);
+    if (n < 0) {
+      _response.endOfInput();
+      return -1;
+    }
+    if (n == 0) return 0;
+    size_t body = _response.decode(buffer, (size_t)n);
+    if (body > 0) return (int)body;
+    // Only framing (headers, chunk sizes) in this read: try the next one
+    // rather than report "nothing yet" and make the caller wait.
+  }
+}
+
+void HttpGetClient::close() {
+  if (_open) _transport.close();
+  _open = false;
+}
+
+int HttpGetClient::resultCode() const {
+  HttpError err = error();
+  if (err != HTTP_ERR_NONE && !_response.headersDone()) return -(int)err;
+  return _response.headersDone() ? _response.statusCode() : 0;
+}
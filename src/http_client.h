@@ -0,0 +1,204 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Minimal HTTP/1.1 GET client for the EFA request.
+ *
+ * Everything lives in fixed buffers: the request is written by buildEfaRequest
+ * into a member array, and the response status line and headers are decoded a
+ * line at a time through a small line buffer. Socket reads go straight into
+ * the caller's buffer (the fetch cycle's read chunk) and the framing is
+ * stripped in place, so body bytes are never copied between buffers.
+ */
+
+/** Why a request failed; HTTP_ERR_NONE while all is well. */
+typedef enum {
+  HTTP_ERR_NONE = 0,
+  HTTP_ERR_CONNECT,           // transport could not connect
+  HTTP_ERR_SEND,              // request could not be written
+  HTTP_ERR_REQUEST_TOO_LONG,  // request did not fit kRequestCapacity
+  HTTP_ERR_BAD_STATUS,        // status line is not "HTTP/1.x NNN ..."
+  HTTP_ERR_BAD_HEADER,        // unparseable Content-Length
+  HTTP_ERR_BAD_CHUNK,         // malformed chunked framing
+  HTTP_ERR_CLOSED_EARLY,      // input ended before the headers or body were complete
+  HTTP_ERR_TIMEOUT,           // no response within the caller's idle timeout
+} HttpError;
+
+/**
+ * Incremental HTTP/1.1 response decoder.
+ *
+ * Feed it the raw bytes of a response in pieces of any size. It tracks the
+ * status line, Content-Length, Transfer-Encoding: chunked and Connection, and
+ * moves body bytes to the front of each piece, dropping status, header and
+ * chunk framing bytes. Interim 1xx responses are skipped.
+ */
+class HttpResponseDecoder {
+ public:
+  HttpResponseDecoder() { reset(); }
+
+  /** Forget everything and expect a new status line. */
+  void reset();
+
+  /**
+   * Decode data[0..length) in place.
+   *
+   * @return Number of body bytes now at data[0..n)
+   */
+  size_t decode(uint8_t* data, size_t length);
+
+  /**
+   * The connection ended. Completes a body delimited by close; anything else
+   * still in progress fails with HTTP_ERR_CLOSED_EARLY.
+   */
+  void endOfInput();
+
+  /** Status line and headers of the final (non-1xx) response have been read. */
+  bool headersDone() const { return _headersDone; }
+
+  /** The whole body has been read (for a body delimited by close: after endOfInput()). */
+  bool done() const { return _state == kDone; }
+
+  /** The response is malformed; see error(). */
+  bool failed() const { return _state == kFailed; }
+
+  HttpError error() const { return _error; }
+
+  /** Status code, or 0 before the status line has been read. */
+  int statusCode() const { return _status; }
+
+  /** Content-Length, or -1 if absent (chunked or delimited by close). */
+  long contentLength() const { return _contentLength; }
+
+  bool chunked() const { return _chunked; }
+
+  /** Whether the server will keep the connection open after this response. */
+  bool keepAlive() const { return _keepAlive; }
+
+  /** Body bytes emitted so far (after chunk decoding). */
+  size_t bodyBytes() const { return _bodyBytes; }
+
+ private:
+  enum State {
+    kStatusLine,
+    kHeaderLine,
+    kBodyIdentity,
+    kBodyUntilClose,
+    kChunkSize,
+    kChunkExtension,
+    kChunkData,
+    kChunkDataEnd,
+    kTrailerLine,
+    kDone,
+    kFailed,
+  };
+
+  static const size_t kMaxLine = 128;
+
+  void fail(HttpError error);
+  void lineComplete();
+  void handleStatusLine(size_t length);
+  void handleHeaderLine(size_t length);
+  void startBody();
+  void chunkSizeByte(uint8_t c);
+  void chunkSizeLineComplete();
+
+  State _state;
+  HttpError _error;
+  int _status;
+  long _contentLength;
+  bool _chunked;
+  bool _keepAlive;
+  bool _http11;
+  bool _headersDone;
+  size_t _remaining;  // body or chunk bytes still to come
+  size_t _bodyBytes;
+  int _chunkDigits;
+  char _line[kMaxLine];
+  size_t _lineLength;  // may exceed kMaxLine - 1; the excess is dropped
+};
+
+/**
+ * Byte stream the client talks through: a WiFiClient on the ESP32, a POSIX
+ * socket on the host.
+ */
+class HttpTransport {
+ public:
+  virtual ~HttpTransport() {}
+
+  virtual bool connect(const char* host, uint16_t port) = 0;
+
+  /** Write all of data; false if the connection failed. */
+  virtual bool write(const uint8_t* data, size_t length) = 0;
+
+  /** Bytes read (> 0), 0 if nothing is available yet, -1 once closed or timed out. */
+  virtual int read(uint8_t* buffer, size_t capacity) = 0;
+
+  virtual void close() = 0;
+};
+
+/**
+ * One EFA departure-monitor GET over a transport.
+ *
+ * Usage: get(), then call receive() until it returns -1, checking
+ * response().headersDone() for the status; then close(), or keep the
+ * connection for the next get() while reusable(). receive() never blocks, so
+ * FetchCycle calls it from its step(). The object holds no heap memory and is
+ * reused for every attempt.
+ */
+class HttpGetClient {
+ public:
+  static const size_t kRequestCapacity = 320;
+
+  explicit HttpGetClient(HttpTransport& transport)
+      : _transport(transport), _error(HTTP_ERR_NONE), _open(false), _reused(false) {}
+
+  /**
+   * Connect and send the request for stationId/limit. The Host header is
+   * always EFA_HOST; host and port only choose where to connect.
+   *
+   * With keepAlive the request asks the server to keep the connection open,
+   * and a connection left reusable() by the previous response is used again
+   * instead of connecting. If the server has dropped it in the meantime and
+   * the write fails, a new connection is made.
+   *
+   * @return false on failure (see error())
+   */
+  bool get(const char* host, uint16_t port, const char* stationId, int limit, bool keepAlive = false);
+
+  /**
+   * Read from the transport into buffer and decode in place.
+   *
+   * @return Body bytes at buffer[0..n) (> 0), 0 if none yet, or -1 once the
+   *         body is complete, the connection ended, or the response failed
+   */
+  int receive(uint8_t* buffer, size_t capacity);
+
+  /** Close the connection, also mid-body (e.g. once the parser has enough). */
+  void close();
+
+  /** The response was read to its end and the server keeps the connection open. */
+  bool reusable() const { return _open && _response.done() && _response.keepAlive(); }
+
+  /** The last get() went out on the previous response's connection. */
+  bool reused() const { return _reused; }
+
+  /** Status code once the headers are in, otherwise -HttpError (or 0 while pending). */
+  int resultCode() const;
+
+  HttpError error() const { return (_error != HTTP_ERR_NONE) ? _error : _response.error(); }
+
+  const HttpResponseDecoder& response() const { return _response; }
+
+ private:
+  HttpTransport& _transport;
+  HttpResponseDecoder _response;
+  HttpError _error;
+  bool _open;
+  bool _reused;
+  char _request[kRequestCapacity];
+};
+
+#endif  // HTTP_CLIENT_H
@@ -0,0 +1,93 @@
+#include "json_skip.h"
+
+#include <string.h>
+
+// One register's worth of bytes: 4 on the ESP32, 8 on a 64-bit host.
+typedef size_t SwarWord;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "json_skip assumes little-endian word loads"
+#endif
+
+static const SwarWord kOnes = (SwarWord)~(SwarWord)0 / 0xFF;  // 0x0101...01
+static const SwarWord kHighs = kOnes * 0x80;                  // 0x8080...80
+
+static inline SwarWord loadWord(const uint8_t* p) {
+  SwarWord w;
+  memcpy(&w, p, sizeof(w));  // unaligned-safe; compiles to a plain load
+  return w;
+}
+
+// High bit set in every byte of w that equals b. Borrows can also flag bytes
+// above a true match, so only the lowest flagged byte is exact; callers only
+// ever use that one.
+static inline SwarWord matchByte(SwarWord w, uint8_t b) {
+  SwarWord x = w ^ (kOnes * b);
+  return (x - kOnes) & ~x & kHighs;
+}
+
+// Bytes that can change the state inside a string.
+static inline SwarWord stringStops(SwarWord w) { return matchByte(w, '"') | matchByte(w, '\\'); }
+
+// Bytes that can change the state outside a string. Setting bit 5 folds
+// '[' (0x5B) onto '{' (0x7B) and ']' (0x5D) onto '}' (0x7D), and no other byte
+// lands on either, so two compares cover all four brackets.
+static inline SwarWord structureStops(SwarWord w) {
+  SwarWord folded = w | (kOnes * 0x20);
+  return matchByte(w, '"') | matchByte(folded, '{') | matchByte(folded, '}');
+}
+
+// Index of the lowest flagged byte in a non-zero mask.
+static inline size_t firstFlagged(SwarWord mask) {
+  if (sizeof(SwarWord) == sizeof(unsigned long long)) return (size_t)__builtin_ctzll(mask) / 8;
+  return (size_t)__builtin_ctz((unsigned int)mask) / 8;
+}
+
+void JsonSkipper::step(uint8_t c) {
+  if (_inString) {
+    if (_escaped) {
+      _escaped = false;
+    } else if (c == '\\') {
+      _escaped = true;
+    } else if (c == '"') {
+      _inString = false;
+      if (_depth == 0) _done = true;  // the value was a bare string
+    }
+  } else if (c == '"') {
+    _inString = true;
+  } else if (c == '{' || c == '[') {
+    _depth++;
+  } else if (c == '}' || c == ']') {
+    if (--_depth <= 0) {
+      _depth = 0;
+      _done = true;
+    }
+  }
+}
+
+size_t JsonSkipper::scan(const uint8_t* data, size_t length) {
+  size_t i = 0;
+  while (i < length && !_done) {
+    // The byte after a backslash is taken as is, whatever it is.
+    if (!_escaped) {
+      while (i + sizeof(SwarWord) <= length) {
+        SwarWord w = loadWord(data + i);
+        SwarWord stops = _inString ? stringStops(w) : structureStops(w);
+        if (stops != 0) {
+          i += firstFlagged(stops);
+          break;
+        }
+        i += sizeof(SwarWord);
+      }
+      if (i >= length) break;
+    }
+    step(data[i++]);
+  }
+  return i;
+}
+
+size_t JsonSkipper::scanBytewise(const uint8_t* data, size_t length) {
+  size_t i = 0;
+  while (i < length && !_done) step(data[i++]);
+  return i;
+}
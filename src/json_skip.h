@@ -0,0 +1,61 @@
+#ifndef JSON_SKIP_H
+#define JSON_SKIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Fast skipper for JSON values the parser does not want.
+ *
+ * Tracks only bracket depth and string state (including a backslash escape
+ * that straddles two spans), so it does not validate what it skips. Between
+ * the bytes that can change that state it moves a machine word at a time
+ * (SWAR): inside a string only '"' and '\' matter, outside one only '"' and
+ * the four brackets, and a word holding none of them is passed over with a
+ * few ALU operations instead of one branch per byte.
+ *
+ * Feed a value that starts with '{', '[' or '"' through scan() in spans of any
+ * size until done(); scalars have no closing byte and are not handled here.
+ */
+class JsonSkipper {
+ public:
+  JsonSkipper() { reset(); }
+
+  /** Start skipping a new value. */
+  void reset() {
+    _depth = 0;
+    _inString = false;
+    _escaped = false;
+    _done = false;
+  }
+
+  /**
+   * Consume data[0..length) up to the end of the value.
+   *
+   * @return Bytes consumed: up to and including the value's closing byte once
+   *         done(), otherwise all of length
+   */
+  size_t scan(const uint8_t* data, size_t length);
+
+  /** Same result as scan(), one byte at a time; the reference for tests and benchmarks. */
+  size_t scanBytewise(const uint8_t* data, size_t length);
+
+  /** The value's closing byte has been consumed. */
+  bool done() const { return _done; }
+
+  /** Nesting depth at the current position (0 before the value and once done). */
+  int depth() const { return _depth; }
+
+  /** The current position is inside a string. */
+  bool inString() const { return _inString; }
+
+ private:
+  void step(uint8_t c);
+
+  int _depth;
+  bool _inString;
+  bool _escaped;  // previous byte was a backslash inside a string
+  bool _done;
+};
+
+#endif  // JSON_SKIP_H
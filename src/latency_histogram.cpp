@@ -0,0 +1,193 @@
+#include "latency_histogram.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const kMetricNames[LATENCY_METRIC_COUNT] = {
+    "wifi-connect", "first-byte", "body-transfer", "parse", "total",
+};
+
+void latencyInit(LatencyHistograms* hist) {
+  memset(hist, 0, sizeof(*hist));
+  hist->magic = LATENCY_MAGIC;
+  hist->version = LATENCY_VERSION;
+}
+
+bool latencyIsValid(const LatencyHistograms* hist) {
+  return hist->magic == LATENCY_MAGIC && hist->version == LATENCY_VERSION;
+}
+
+int latencyBucketFor(uint32_t ms) {
+  if (ms < 2) return (int)ms;
+  int octave = 31;
+  while (!(ms & (1u << octave))) octave--;
+  int half = (ms >> (octave - 1)) & 1;
+  int bucket = 2 * octave + half;
+  return (bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS - 1;
+}
+
+uint32_t latencyBucketLowerMs(int bucket) {
+  if (bucket < 2) return (bucket < 0) ? 0 : (uint32_t)bucket;
+  if (bucket >= LATENCY_BUCKETS) bucket = LATENCY_BUCKETS - 1;
+  int octave = bucket / 2;
+  return (1u << octave) + (uint32_t)(bucket % 2) * (1u << (octave - 1));
+}
+
+uint32_t latencyBucketUpperMs(int bucket) {
+  if (bucket >= LATENCY_BUCKETS - 1) return UINT32_MAX;
+  return latencyBucketLowerMs(bucket + 1) - 1;
+}
+
+static bool isValidMetric(LatencyMetric metric) { return (int)metric >= 0 && (int)metric < LATENCY_METRIC_COUNT; }
+
+void latencyRecord(LatencyHistograms* hist, LatencyMetric metric, uint32_t ms) {
+  if (!isValidMetric(metric)) return;
+  uint32_t* count = &hist->counts[metric][latencyBucketFor(ms)];
+  if (*count < UINT32_MAX) (*count)++;
+}
+
+uint32_t latencySampleCount(const LatencyHistograms* hist, LatencyMetric metric) {
+  if (!isValidMetric(metric)) return 0;
+  uint32_t total = 0;
+  for (int b = 0; b < LATENCY_BUCKETS; b++) total += hist->counts[metric][b];
+  return total;
+}
+
+uint32_t latencyPercentileMs(const LatencyHistograms* hist, LatencyMetric metric, int percent) {
+  uint32_t total = latencySampleCount(hist, metric);
+  if (total == 0) return 0;
+  if (percent < 0) percent = 0;
+  if (percent > 100) percent = 100;
+
+  // Rank of the sample (1-based, nearest-rank method).
+  uint64_t rank = ((uint64_t)total * (uint32_t)percent + 99) / 100;
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (int b = 0; b < LATENCY_BUCKETS; b++) {
+    seen += hist->counts[metric][b];
+    if (seen >= rank) return latencyBucketUpperMs(b);
+  }
+  return latencyBucketUpperMs(LATENCY_BUCKETS - 1);
+}
+
+static uint32_t addSaturating(uint32_t a, uint32_t b) { return (a > UINT32_MAX - b) ? UINT32_MAX : a + b; }
+
+void latencyMerge(LatencyHistograms* into, const LatencyHistograms* from) {
+  into->boots = addSaturating(into->boots, from->boots);
+  for (int m = 0; m < LATENCY_METRIC_COUNT; m++) {
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      into->counts[m][b] = addSaturating(into->counts[m][b], from->counts[m][b]);
+    }
+  }
+}
+
+const char* latencyMetricName(LatencyMetric metric) { return isValidMetric(metric) ? kMetricNames[metric] : "?"; }
+
+// printf into buffer at *used. On overflow nothing is counted and false is
+// returned, so a dump is either complete or rejected as a whole.
+static bool appendf(char* buffer, size_t capacity, size_t* used, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buffer + *used, capacity - *used, format, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= capacity - *used) return false;
+  *used += (size_t)n;
+  return true;
+}
+
+size_t latencyFormatDump(const LatencyHistograms* hist, const char* unitId, char* buffer, size_t capacity) {
+  if (buffer == NULL || capacity == 0) return 0;
+  size_t used = 0;
+
+  bool fits = appendf(buffer, capacity, &used, "LATENCY v%d unit=%s boots=%lu\n", LATENCY_VERSION,
+                      unitId ? unitId : "-", (unsigned long)hist->boots);
+  for (int m = 0; m < LATENCY_METRIC_COUNT && fits; m++) {
+    fits = appendf(buffer, capacity, &used, "%s", kMetricNames[m]);
+    for (int b = 0; b < LATENCY_BUCKETS && fits; b++) {
+      if (hist->counts[m][b]) fits = appendf(buffer, capacity, &used, " %d:%lu", b, (unsigned long)hist->counts[m][b]);
+    }
+    if (fits) fits = appendf(buffer, capacity, &used, "\n");
+  }
+  if (fits) fits = appendf(buffer, capacity, &used, "END\n");
+
+  if (!fits) {
+    buffer[0] = '\0';
+    return 0;
+  }
+  return used;
+}
+
+static int metricForName(const char* name, size_t length) {
+  for (int m = 0; m < LATENCY_METRIC_COUNT; m++) {
+    if (strlen(kMetricNames[m]) == length && strncmp(kMetricNames[m], name, length) == 0) return m;
+  }
+  return -1;
+}
+
+// Parse "b:c b:c ..." up to the end of the line into counts.
+static bool parseBucketList(const char* p, const char* lineEnd, uint32_t* counts) {
+  while (p < lineEnd) {
+    while (p < lineEnd && *p == ' ') p++;
+    if (p >= lineEnd || *p == '\r') break;
+    char* end;
+    long bucket = strtol(p, &end, 10);
+    if (end == p || *end != ':' || bucket < 0 || bucket >= LATENCY_BUCKETS) return false;
+    p = end + 1;
+    unsigned long count = strtoul(p, &end, 10);
+    if (end == p) return false;
+    counts[bucket] = (uint32_t)count;
+    p = end;
+  }
+  return true;
+}
+
+// Copy the value of "unit=" in the header line [header, lineEnd).
+static void copyUnitId(const char* header, const char* lineEnd, char* unitId) {
+  const char* unit = strstr(header, "unit=");
+  size_t length = 0;
+  if (unit != NULL && unit < lineEnd) {
+    unit += 5;
+    length = strcspn(unit, " \r\n");
+    if (length > LATENCY_UNIT_ID_SIZE - 1) length = LATENCY_UNIT_ID_SIZE - 1;
+  }
+  if (length == 0) {
+    unit = "-";
+    length = 1;
+  }
+  memcpy(unitId, unit, length);
+  unitId[length] = '\0';
+}
+
+const char* latencyParseDump(const char* text, LatencyHistograms* hist, char* unitId) {
+  static const char kHeader[] = "LATENCY v";
+  const char* p = text;
+
+  while ((p = strstr(p, kHeader)) != NULL) {
+    latencyInit(hist);
+    const char* cursor = p + strlen(kHeader);
+    p = cursor;  // where to resume if this dump turns out to be broken
+
+    char* end;
+    if (strtol(cursor, &end, 10) != LATENCY_VERSION) continue;
+    const char* boots = strstr(end, "boots=");
+    const char* lineEnd = strchr(end, '\n');
+    if (lineEnd == NULL) return NULL;
+    if (boots != NULL && boots < lineEnd) hist->boots = (uint32_t)strtoul(boots + 6, NULL, 10);
+    if (unitId != NULL) copyUnitId(end, lineEnd, unitId);
+
+    bool ok = true;
+    for (cursor = lineEnd + 1; ok;) {
+      lineEnd = strchr(cursor, '\n');
+      if (lineEnd == NULL) lineEnd = cursor + strlen(cursor);
+      size_t nameLength = strcspn(cursor, " \r\n");
+      if (nameLength == 3 && strncmp(cursor, "END", 3) == 0) return (*lineEnd == '\n') ? lineEnd + 1 : lineEnd;
+      int metric = metricForName(cursor, nameLength);
+      ok = metric >= 0 && parseBucketList(cursor + nameLength, lineEnd, hist->counts[metric]);
+      if (*lineEnd == '\0') ok = false;
+      cursor = lineEnd + 1;
+    }
+  }
+  return NULL;
+}
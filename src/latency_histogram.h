@@ -0,0 +1,137 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Half-octave buckets: 0 and 1 ms exactly, then two per power of two, so each
+// bucket spans at most ~41% of its lower bound. The last one is open-ended
+// from 49152 ms, past the worst case of three 15 s attempts.
+#define LATENCY_BUCKETS 32
+
+#define LATENCY_MAGIC 0x4C415448u  // "LATH"
+#define LATENCY_VERSION 1
+
+// Longest unit id a dump carries, including the NUL (the firmware uses the
+// 12 hex digits of the eFuse MAC).
+#define LATENCY_UNIT_ID_SIZE 32
+
+// Buffer that holds any dump: a header with the longest unit id and boot
+// count, then every bucket of every metric non-empty with a 10-digit count
+// (about 2380 bytes).
+#define LATENCY_DUMP_CAPACITY 2560
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Latencies tracked per wake cycle, all in milliseconds.
+ */
+typedef enum {
+  LATENCY_WIFI_CONNECT = 0,  // WiFi.begin() until associated with an IP
+  LATENCY_FIRST_BYTE,        // request start until the response headers are in
+  LATENCY_BODY_TRANSFER,     // response headers in until the body ended or departureList closed
+  LATENCY_PARSE,             // parser busy time, excluding waits for data
+  LATENCY_TOTAL,             // power-on until the departures are on the display
+  LATENCY_METRIC_COUNT,
+} LatencyMetric;
+
+/**
+ * Histograms for every metric, stored as one NVS blob. magic and version
+ * guard against reading a blob written by a different layout.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t boots;  // wake cycles that recorded at least one sample
+  uint32_t counts[LATENCY_METRIC_COUNT][LATENCY_BUCKETS];
+} LatencyHistograms;
+
+/**
+ * Empty histograms with the current magic and version.
+ */
+void latencyInit(LatencyHistograms* hist);
+
+/**
+ * Whether a blob read back from storage has the current layout.
+ */
+bool latencyIsValid(const LatencyHistograms* hist);
+
+/**
+ * Bucket index for a latency.
+ */
+int latencyBucketFor(uint32_t ms);
+
+/**
+ * Smallest latency that falls into a bucket.
+ */
+uint32_t latencyBucketLowerMs(int bucket);
+
+/**
+ * Largest latency that falls into a bucket (UINT32_MAX for the last one).
+ */
+uint32_t latencyBucketUpperMs(int bucket);
+
+/**
+ * Count one sample.
+ */
+void latencyRecord(LatencyHistograms* hist, LatencyMetric metric, uint32_t ms);
+
+/**
+ * Total samples of a metric.
+ */
+uint32_t latencySampleCount(const LatencyHistograms* hist, LatencyMetric metric);
+
+/**
+ * Latency at or below which percent% of the samples fall, reported as the
+ * upper bound of the bucket holding that sample, so it never understates.
+ *
+ * @return Milliseconds, or 0 if the metric has no samples
+ */
+uint32_t latencyPercentileMs(const LatencyHistograms* hist, LatencyMetric metric, int percent);
+
+/**
+ * Add every count (and the boot counter) of from into into.
+ */
+void latencyMerge(LatencyHistograms* into, const LatencyHistograms* from);
+
+/**
+ * Short name used in dumps and reports, e.g. "first-byte".
+ */
+const char* latencyMetricName(LatencyMetric metric);
+
+/**
+ * Write a text dump that latencyParseDump() reads back:
+ *
+ *   LATENCY v1 unit=<unitId> boots=<n>
+ *   wifi-connect 22:4 23:17 24:3
+ *   ...
+ *   END
+ *
+ * Each metric line lists only the non-empty buckets as bucket:count. Any
+ * dump fits LATENCY_DUMP_CAPACITY bytes if unitId fits LATENCY_UNIT_ID_SIZE.
+ *
+ * @return Characters written (excluding the NUL), or 0 if buffer is too small
+ */
+size_t latencyFormatDump(const LatencyHistograms* hist, const char* unitId, char* buffer, size_t capacity);
+
+/**
+ * Find and parse the next dump in text. Anything before the LATENCY header
+ * (other serial output) is skipped, so a whole captured log can be fed in.
+ *
+ * @param text Text to scan
+ * @param hist Receives the parsed histograms
+ * @param unitId Receives the dump's unit id ("-" if it has none) in
+ *        LATENCY_UNIT_ID_SIZE bytes, cut to fit; may be NULL
+ * @return Pointer just past the dump's END line, or NULL if no complete dump
+ *         was found
+ */
+const char* latencyParseDump(const char* text, LatencyHistograms* hist, char* unitId);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LATENCY_HISTOGRAM_H
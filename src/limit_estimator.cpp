@@ -0,0 +1,78 @@
+#include "limit_estimator.h"
+
+#include <math.h>
+#include <string.h>
+
+void limitEstimatorInit(LimitEstimator* est) {
+  memset(est, 0, sizeof(*est));
+  est->magic = LIMIT_ESTIMATOR_MAGIC;
+  est->version = LIMIT_ESTIMATOR_VERSION;
+}
+
+bool limitEstimatorIsValid(const LimitEstimator* est) {
+  return est->magic == LIMIT_ESTIMATOR_MAGIC && est->version == LIMIT_ESTIMATOR_VERSION && est->passed <= est->seen;
+}
+
+void limitEstimatorRecord(LimitEstimator* est, int entries, int displayable, bool secondFetch) {
+  if (entries < 0) entries = 0;
+  if (displayable < 0) displayable = 0;
+  if (displayable > entries) displayable = entries;
+  est->seen += (uint32_t)entries;
+  est->passed += (uint32_t)displayable;
+  // Halving both keeps the fraction and passed <= seen.
+  while (est->seen > LIMIT_ESTIMATOR_WINDOW) {
+    est->seen /= 2;
+    est->passed /= 2;
+  }
+  est->fetches++;
+  if (secondFetch) est->secondFetches++;
+}
+
+double limitEstimatorFillProbability(const LimitEstimator* est, int limit, int rows) {
+  if (rows <= 0) return 1.0;
+  if (limit < rows) return 0.0;
+
+  // Beta(a, b) posterior over the pass fraction; the number of displayable
+  // entries among limit is then beta-binomial. Its pmf is built up from
+  // pmf(0) by the ratio of successive terms, in logs so that a long history
+  // with a high fraction does not underflow pmf(0).
+  double a = (double)est->passed + 1.0;
+  double b = (double)(est->seen - est->passed) + 1.0;
+  int n = limit;
+  double logPmf = 0.0;
+  for (int i = 0; i < n; i++) logPmf += log((b + i) / (a + b + i));
+
+  double below = 0.0;  // P(fewer than rows displayable)
+  for (int k = 0; k < rows; k++) {
+    below += exp(logPmf);
+    logPmf += log((double)(n - k) / (k + 1)) + log((a + k) / (b + n - k - 1));
+  }
+  return (below >= 1.0) ? 0.0 : 1.0 - below;
+}
+
+static int clampLimit(int limit, int low, int high) {
+  if (limit > high) limit = high;
+  if (limit < low) limit = low;
+  return limit;
+}
+
+int limitEstimatorChoose(const LimitEstimator* est, const LimitPolicy* policy) {
+  if (est->seen == 0) return clampLimit(policy->defaultLimit, 1, policy->maxLimit);
+
+  double confidence = policy->confidencePercent / 100.0;
+  for (int limit = clampLimit(policy->rows, 1, policy->maxLimit); limit < policy->maxLimit; limit++) {
+    if (limitEstimatorFillProbability(est, limit, policy->rows) >= confidence) return limit;
+  }
+  return policy->maxLimit;
+}
+
+int limitEstimatorSecondLimit(const LimitEstimator* est, const LimitPolicy* policy, int firstLimit, int displayable) {
+  int missing = policy->rows - displayable;
+  if (missing <= 0 || firstLimit >= policy->maxLimit) return 0;
+
+  double confidence = policy->confidencePercent / 100.0;
+  for (int extra = missing; firstLimit + extra < policy->maxLimit; extra++) {
+    if (limitEstimatorFillProbability(est, extra, missing) >= confidence) return firstLimit + extra;
+  }
+  return policy->maxLimit;
+}
@@ -0,0 +1,94 @@
+#ifndef LIMIT_ESTIMATOR_H
+#define LIMIT_ESTIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LIMIT_ESTIMATOR_MAGIC 0x4C494D54u  // "LIMT"
+#define LIMIT_ESTIMATOR_VERSION 1
+
+// Entries of history the estimate is based on. Past this the counts are
+// halved, so a timetable or filter change is picked up within a few days of
+// presses instead of being outvoted by months of old samples.
+#define LIMIT_ESTIMATOR_WINDOW 200
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Running count of how many departureList entries turned out displayable
+ * (direction filter and countdown checks), stored as one NVS blob. magic and
+ * version guard against reading a blob written by a different layout.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t seen;    // entries observed, decayed
+  uint32_t passed;  // of those, displayable
+  uint32_t fetches;
+  uint32_t secondFetches;  // fetches that needed a second, larger request
+} LimitEstimator;
+
+/**
+ * How the request limit is chosen.
+ */
+typedef struct {
+  int rows;               // displayable entries needed to fill the display
+  int confidencePercent;  // wanted probability that one request fills it
+  int defaultLimit;       // used until there is any history
+  int maxLimit;           // never request more (result buffer capacity)
+} LimitPolicy;
+
+/**
+ * Empty history with the current magic and version.
+ */
+void limitEstimatorInit(LimitEstimator* est);
+
+/**
+ * Whether a blob read back from storage has the current layout.
+ */
+bool limitEstimatorIsValid(const LimitEstimator* est);
+
+/**
+ * Add one fetch: entries parsed from departureList, displayable of them, and
+ * whether the first request fell short and a second one was made.
+ */
+void limitEstimatorRecord(LimitEstimator* est, int entries, int displayable, bool secondFetch);
+
+/**
+ * Probability that a request for limit entries yields at least rows
+ * displayable ones.
+ *
+ * The pass fraction is not known exactly, only estimated from the history, so
+ * this is the beta-binomial predictive probability with a uniform prior: a
+ * short history gives a wide spread and asks for more entries than a long one
+ * with the same fraction.
+ */
+double limitEstimatorFillProbability(const LimitEstimator* est, int limit, int rows);
+
+/**
+ * Smallest limit in [rows, maxLimit] whose fill probability reaches the
+ * policy's confidence; maxLimit if none does, defaultLimit (clamped) without
+ * history.
+ */
+int limitEstimatorChoose(const LimitEstimator* est, const LimitPolicy* policy);
+
+/**
+ * Limit for one more request after the first returned a full list of
+ * firstLimit entries with only displayable < rows of them usable. The second
+ * response repeats the first entries, so the extra entries it must bring are
+ * sized for the rows still missing, at the same confidence.
+ *
+ * Call after recording the first fetch, so its entries count as history.
+ *
+ * @return The second limit, or 0 if no second request is warranted (display
+ *         already filled, or firstLimit already at maxLimit)
+ */
+int limitEstimatorSecondLimit(const LimitEstimator* est, const LimitPolicy* policy, int firstLimit, int displayable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LIMIT_ESTIMATOR_H
@@ -7,18 +7,67 @@
 #include <Adafruit_SSD1306.h>
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <HTTPClient.h>
+#include <Preferences.h>
 #include <WiFi.h>
 #include <Wire.h>
 
 #include "departure_logic.h"
+#include "efa_config.h"
+#include "fetch_cycle.h"
+#include "http_client.h"
+#include "latency_histogram.h"
+#include "limit_estimator.h"
+#include "power_governor.h"
+#include "refresh_stats.h"
+#include "row_renderer.h"
 #include "secrets.h"
+#include "task_profiler.h"
 #include "soc/rtc_cntl_reg.h"
 #include "soc/soc.h"
 
 // --- USER SETTINGS ---
 const int awakeTimeMs = 10000;  // Time to display results before sleep (ms); switch cuts power on release
 
+// Always-on refresh for units on permanent power: a non-zero interval keeps
+// the unit awake with WiFi up (and the EFA connection, when the server keeps
+// it open) and refetches that often, redrawing only the rows that changed.
+// 0 keeps the press-and-sleep cycle. History is written to NVS every
+// kRefreshSaveCycles refreshes instead of once per wake.
+const uint32_t kRefreshIntervalMs = 0;
+const uint32_t kRefreshSaveCycles = 60;
+
+// Rows shown on the display, and how many departures to request from EFA so
+// that enough remain after direction and countdown filtering to fill them.
+// The limit is learned per unit (see limit_estimator.h): EFA_REQUEST_LIMIT is
+// used until there is history, kMaxRequestLimit caps it, and the confidence
+// is the wanted chance that the first request fills every row.
+#define EFA_REQUEST_LIMIT 15
+const int kDisplayRows = 3;
+const int kRequestLimit = EFA_REQUEST_LIMIT;
+const int kMaxRequestLimit = 30;
+const int kLimitConfidencePercent = 90;
+static_assert(kDisplayRows <= kRequestLimit, "request limit cannot fill every display row");
+static_assert(kRequestLimit <= kMaxRequestLimit, "default request limit above the maximum");
+
+// Reject bad secrets.h settings at build time rather than on a field unit.
+static_assert(isValidWifiSsid(WIFI_SSID), "WIFI_SSID must be 1-32 characters and not the placeholder");
+static_assert(isValidWifiPassword(WIFI_PASSWORD),
+              "WIFI_PASSWORD must be empty, 8-63 characters or 64 hex digits, and not the placeholder");
+static_assert(isValidStationId(STATION_ID), "STATION_ID must be the numeric EFA stop ID (see secrets.h.example)");
+static_assert(isValidDirectionFilter(DIRECTION_FILTER),
+              "DIRECTION_FILTER needs a usable keyword (not the placeholder); no bare '!' or over-long keyword");
+static_assert(isValidRequestLimit(kRequestLimit), "EFA_REQUEST_LIMIT out of range");
+static_assert(isValidRequestLimit(kMaxRequestLimit), "kMaxRequestLimit out of range");
+
+// Request URL with the limit left as a printf conversion, assembled by the
+// preprocessor; logged on each fetch (the request itself is written by
+// buildEfaRequest into the fetch cycle's buffer).
+static const char kEfaUrlFormat[] = EFA_DM_URL(STATION_ID, %d);
+
+// Parse target, sized for the largest limit so no entry is dropped. File
+// scope keeps its ~2.8 KB off the loop task stack.
+static DeparturesResultN<kMaxRequestLimit> departures;
+
 // Hardware Settings
 #define I2C_SDA 21
 #define I2C_SCL 22
@@ -26,52 +75,470 @@ const int awakeTimeMs = 10000;  // Time to display results before sleep (ms); sw
 // Display Settings
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
+#define SCREEN_ADDRESS 0x3C
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+static_assert(SCREEN_WIDTH == ROW_BUFFER_WIDTH && SCREEN_HEIGHT == ROW_BUFFER_HEIGHT,
+              "row renderer is laid out for a 128x64 SSD1306 buffer");
+static_assert(kDisplayRows <= ROW_SLOTS, "more display rows than row slots");
 
-void fetchDepartures();
+// Per-phase CPU clock and sleep policy; see power_governor.h for the table.
+static PowerGovernor powerGovernor;
 
-// Spinner runs on the other core so it keeps moving during synchronous WiFi
-// connect and HTTP GET. The main core flips spinnerRunning=false before drawing
-// real content; the task then exits and self-deletes.
-volatile bool spinnerRunning = false;
-SemaphoreHandle_t displayMutex = NULL;
+// Stack high-water marks per task and phase, and busy time per task, for the
+// end-of-cycle report. Run-time stats are not enabled in the Arduino core's
+// FreeRTOS build, so each task times its own work with esp_timer.
+static TaskProfiler taskProfiler;
+static int loopSlot = -1;
 
-void spinnerTask(void* /*param*/) {
-  // 8 dots arranged in a ring; the "head" dot is largest, trailing dots shrink.
-  const int cx = 64, cy = 32, ringR = 18;
-  const int dotCount = 8;
-  // Radius per trail position (head=0, then clockwise). Index = (i - head) mod 8.
-  const int dotR[8] = {5, 4, 3, 2, 1, 1, 0, 0};
-  int head = 0;
-  while (spinnerRunning) {
-    if (xSemaphoreTake(displayMutex, portMAX_DELAY) == pdTRUE) {
-      display.clearDisplay();
-      for (int i = 0; i < dotCount; i++) {
-        float angle = -PI / 2.0f + i * (2.0f * PI / dotCount);
-        int dx = (int)(ringR * cosf(angle));
-        int dy = (int)(ringR * sinf(angle));
-        int trail = (head - i + dotCount) % dotCount;
-        display.fillCircle(cx + dx, cy + dy, dotR[trail], WHITE);
+static void sampleStack(int slot, BootPhase phase) {
+  taskProfilerSampleStack(&taskProfiler, slot, phase, uxTaskGetStackHighWaterMark(NULL));
+}
+
+// Enter a boot phase and apply the parts of its power policy that changed.
+void enterPhase(BootPhase phase) {
+  if (powerGovernor.started && powerGovernor.phase == phase) return;
+  if (powerGovernor.started) sampleStack(loopSlot, powerGovernor.phase);  // mark for the phase being left
+  uint8_t changes = powerGovernorEnter(&powerGovernor, phase, millis());
+  const PowerPolicy* policy = powerPolicyFor(phase);
+  if (changes & POWER_CHANGE_CPU) setCpuFrequencyMhz(policy->cpuMhz);
+  if ((changes & POWER_CHANGE_MODEM_SLEEP) && WiFi.getMode() != WIFI_OFF) WiFi.setSleep(policy->modemSleep);
+  Serial.printf("   [power] %s: %u MHz, modem sleep %s, light sleep %s\n", bootPhaseName(phase),
+                (unsigned)getCpuFrequencyMhz(), policy->modemSleep ? "on" : "off", policy->lightSleep ? "on" : "off");
+}
+
+// Hold the finished image. The SSD1306 refreshes from its own RAM, so once the
+// radio is off the CPU can light-sleep through the hold instead of spinning.
+void holdDisplay(uint32_t ms) {
+  if (!powerPolicyFor(powerGovernor.phase)->lightSleep) {
+    delay(ms);
+    return;
+  }
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+  esp_light_sleep_start();
+}
+
+// One line per phase with its duration, plus the clock-weighted total against
+// the same cycle run at a fixed 240 MHz.
+void printPowerReport() {
+  uint32_t now = millis();
+  uint32_t totalMs = 0;
+  for (int i = 0; i < powerGovernor.logCount; i++) {
+    uint32_t ms = powerPhaseDurationMs(&powerGovernor, i, now);
+    totalMs += ms;
+    Serial.printf("   [power] %-12s %6lu ms @ %u MHz\n", bootPhaseName(powerGovernor.log[i].phase), (unsigned long)ms,
+                  (unsigned)powerPolicyFor(powerGovernor.log[i].phase)->cpuMhz);
+  }
+  uint32_t mhzMs = powerCpuMhzMs(&powerGovernor, now);
+  Serial.printf("   [power] %lu ms total, %u%% of the cycles of a fixed 240 MHz clock\n", (unsigned long)totalMs,
+                totalMs ? (unsigned)(mhzMs / 240 * 100 / totalMs) : 100);
+}
+
+void printTaskReport() {
+  sampleStack(loopSlot, powerGovernor.phase);
+  char line[96];
+  for (int slot = 0; slot < taskProfiler.count; slot++) {
+    taskProfilerFormat(&taskProfiler, slot, line, sizeof(line));
+    Serial.printf("   [task] %s\n", line);
+    Serial.print("   [task]   free by phase:");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+      uint32_t freeBytes = taskProfiler.tasks[slot].phaseFreeBytes[p];
+      if (freeBytes) Serial.printf(" %s %lu", bootPhaseName((BootPhase)p), (unsigned long)freeBytes);
+    }
+    Serial.println();
+  }
+}
+
+// Latency histograms survive power-off in NVS. Samples of this wake cycle are
+// added in RAM and written back as one blob as soon as the fetch is done, so
+// each press costs a single NVS write (none if nothing was measured) and a
+// power cut during the display hold loses nothing.
+static LatencyHistograms latency;
+static bool latencyDirty = false;
+static Preferences latencyPrefs;
+
+void loadLatency() {
+  latencyPrefs.begin("latency", true);
+  size_t length = latencyPrefs.getBytes("hist", &latency, sizeof(latency));
+  latencyPrefs.end();
+  if (length != sizeof(latency) || !latencyIsValid(&latency)) latencyInit(&latency);
+}
+
+void recordLatency(LatencyMetric metric, uint32_t ms) {
+  latencyRecord(&latency, metric, ms);
+  latencyDirty = true;
+}
+
+void saveLatency() {
+  if (!latencyDirty) return;
+  latency.boots++;
+  latencyPrefs.begin("latency", false);
+  latencyPrefs.putBytes("hist", &latency, sizeof(latency));
+  latencyPrefs.end();
+  latencyDirty = false;
+}
+
+// Pass fraction of the direction filter and countdown checks, persisted like
+// the latency histograms (right after the fetch) and used to pick the next
+// request limit.
+static LimitEstimator limitEstimate;
+static bool limitDirty = false;
+static Preferences limitPrefs;
+static const LimitPolicy kLimitPolicy = {kDisplayRows, kLimitConfidencePercent, kRequestLimit, kMaxRequestLimit};
+
+void loadLimitEstimate() {
+  limitPrefs.begin("limit", true);
+  size_t length = limitPrefs.getBytes("est", &limitEstimate, sizeof(limitEstimate));
+  limitPrefs.end();
+  if (length != sizeof(limitEstimate) || !limitEstimatorIsValid(&limitEstimate)) limitEstimatorInit(&limitEstimate);
+}
+
+void saveLimitEstimate() {
+  if (!limitDirty) return;
+  limitPrefs.begin("limit", false);
+  limitPrefs.putBytes("est", &limitEstimate, sizeof(limitEstimate));
+  limitPrefs.end();
+  limitDirty = false;
+}
+
+// Always-on refresh counters: cycle times, connection reuse and heap drift.
+static RefreshStats refreshStats;
+
+// Serial commands, checked while the fetch runs (and between refreshes) and once
+// more after the display hold, just before deep sleep. Input sent during the
+// light-sleep hold is not seen; send it again after "6. Going to deep sleep".
+// 'd' dumps the histograms (merge dumps with `make latency-merge`), 'x' clears them,
+// 's' prints the refresh counters.
+void pollLatencyCommands() {
+  while (Serial.available() > 0) {
+    int command = Serial.read();
+    if (command == 'd') {
+      char unit[13];
+      snprintf(unit, sizeof(unit), "%012llx", (unsigned long long)ESP.getEfuseMac());
+      char dump[LATENCY_DUMP_CAPACITY];
+      if (latencyFormatDump(&latency, unit, dump, sizeof(dump)) > 0) {
+        Serial.print(dump);
+      } else {
+        Serial.println("   [latency] dump does not fit its buffer");
       }
-      display.display();
-      xSemaphoreGive(displayMutex);
+    } else if (command == 'x') {
+      latencyInit(&latency);
+      latencyDirty = true;
+      Serial.println("   [latency] cleared");
+    } else if (command == 's') {
+      char line[112];
+      if (refreshStatsFormat(&refreshStats, line, sizeof(line)) > 0) Serial.printf("   [refresh] %s\n", line);
+    }
+  }
+}
+
+// HttpTransport over one WiFiClient that lives for the whole wake cycle, so
+// retries reuse it instead of constructing a client (and HTTPClient Strings)
+// per attempt. Reads never block: they return what lwIP has buffered. Idle
+// timeouts belong to the fetch cycle, which owns every deadline.
+class WiFiTransport : public HttpTransport {
+ public:
+  bool connect(const char* host, uint16_t port) override { return _client.connect(host, port) != 0; }
+
+  bool write(const uint8_t* data, size_t length) override { return _client.write(data, length) == length; }
+
+  int read(uint8_t* buffer, size_t capacity) override {
+    int available = _client.available();
+    if (available > 0) {
+      int n = _client.read(buffer, (size_t)available < capacity ? (size_t)available : capacity);
+      if (n > 0) return n;
     }
-    head = (head + 1) % dotCount;
-    vTaskDelay(pdMS_TO_TICKS(100));
+    // Nothing buffered: the response has ended once the peer closes.
+    return _client.connected() ? 0 : -1;
+  }
+
+  void close() override { _client.stop(); }
+
+ private:
+  WiFiClient _client;
+};
+
+// Send pages [firstPage, lastPage] of the frame buffer to the panel, as
+// display() does for all eight: a refresh that changed one row sends a
+// quarter of the frame over I2C.
+static void pushDisplayPages(int firstPage, int lastPage) {
+  const size_t kChunk = 31;  // data bytes per transmission, after the control byte
+  display.ssd1306_command(SSD1306_PAGEADDR);
+  display.ssd1306_command(firstPage);
+  display.ssd1306_command(lastPage);
+  display.ssd1306_command(SSD1306_COLUMNADDR);
+  display.ssd1306_command(0);
+  display.ssd1306_command(SCREEN_WIDTH - 1);
+
+  const uint8_t* data = display.getBuffer() + firstPage * SCREEN_WIDTH;
+  size_t remaining = (size_t)(lastPage - firstPage + 1) * SCREEN_WIDTH;
+  Wire.setClock(400000);  // display() runs its transfers at this clock too
+  while (remaining > 0) {
+    size_t n = (remaining < kChunk) ? remaining : kChunk;
+    Wire.beginTransmission(SCREEN_ADDRESS);
+    Wire.write((uint8_t)0x40);  // Co = 0, D/C = 1: the rest is display data
+    Wire.write(data, n);
+    Wire.endTransmission();
+    data += n;
+    remaining -= n;
   }
-  vTaskDelete(NULL);
+  Wire.setClock(100000);
 }
 
-void startSpinner() {
-  if (displayMutex == NULL) displayMutex = xSemaphoreCreateMutex();
-  spinnerRunning = true;
-  xTaskCreatePinnedToCore(spinnerTask, "spinner", 4096, NULL, 1, NULL, 0);
+// The board side of the fetch cycle. Everything runs on the loop task: the
+// spinner is drawn between reads, so there is no spinner task and no display
+// mutex.
+class BoardPlatform : public FetchPlatform {
+ public:
+  int requestLimit = kRequestLimit;  // of the request in flight, for the log
+  bool refreshing = false;           // a refresh after the first cycle: rows stay up, no spinner
+  uint8_t rowsRedrawn = 0;           // row slots the last result redrew
+
+  uint64_t nowUs() override { return (uint64_t)esp_timer_get_time(); }
+
+  void wifiBegin() override {
+    Serial.print("2. Connecting to WiFi: ");
+    Serial.println(WIFI_SSID);
+    WiFi.mode(WIFI_STA);
+    WiFi.setSleep(powerPolicyFor(PHASE_WIFI_CONNECT)->modemSleep);
+    WiFi.setTxPower(WIFI_POWER_11dBm);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  }
+
+  bool wifiConnected() override { return WiFi.status() == WL_CONNECTED; }
+
+  void enterPhase(BootPhase phase) override {
+    if (phase == PHASE_HTTP_WAIT) {
+      Serial.println("3. Fetching departure data...");
+      Serial.print("   URL: ");
+      Serial.printf(kEfaUrlFormat, requestLimit);
+      Serial.println();
+    }
+    ::enterPhase(phase);
+  }
+
+  // 8 dots arranged in a ring; the "head" dot is largest, trailing dots shrink.
+  void drawSpinner(int frame) override {
+    // Keep departures up once there are any: the previous ones while
+    // refreshing, or the first rows of this response.
+    if (refreshing || _rowCache.count >= 0) return;
+    int64_t frameStart = esp_timer_get_time();
+    const int cx = 64, cy = 32, ringR = 18;
+    const int dotCount = 8;
+    // Radius per trail position (head=0, then clockwise). Index = (i - head) mod 8.
+    const int dotR[8] = {5, 4, 3, 2, 1, 1, 0, 0};
+    int head = frame % dotCount;
+    display.clearDisplay();
+    for (int i = 0; i < dotCount; i++) {
+      float angle = -PI / 2.0f + i * (2.0f * PI / dotCount);
+      int dx = (int)(ringR * cosf(angle));
+      int dy = (int)(ringR * sinf(angle));
+      int trail = (head - i + dotCount) % dotCount;
+      display.fillCircle(cx + dx, cy + dy, dotR[trail], WHITE);
+    }
+    display.display();
+    rowCacheInvalidate(&_rowCache);
+    taskProfilerAddCpu(&taskProfiler, loopSlot, (uint32_t)(esp_timer_get_time() - frameStart));
+    sampleStack(loopSlot, powerGovernor.phase);
+  }
+
+  // Put each displayable departure in its row as soon as it is parsed, so the
+  // first row is up when its element arrives rather than after the last byte.
+  // Not while refreshing: the old rows stay until showResult() swaps in the
+  // changed ones, instead of blanking the rows not yet parsed.
+  void departureParsed(const Departure* dep, int index) override {
+    if (refreshing) return;
+    bool dropped = false;
+    if (index <= _lastParsedIndex) {
+      // A retry lists from the start again; a second request whose list
+      // shifted, from the first entry that changed. Rows put up from there
+      // on came from the abandoned list and are taken down.
+      int slot = countDisplayableDepartures(departures.departures, index, DIRECTION_FILTER);
+      if (slot > kDisplayRows) slot = kDisplayRows;
+      dropped = slot < _nextSlot;
+      _nextSlot = slot;
+    }
+    _lastParsedIndex = index;
+    bool added = _nextSlot < kDisplayRows && isDisplayableDeparture(dep, DIRECTION_FILTER);
+    if (added) _parsedRows[_nextSlot++] = *dep;
+    if (!added && !dropped) return;
+
+    if (_nextSlot == 0) {
+      rowCacheInvalidate(&_rowCache);  // nothing left to show: back to the spinner
+      return;
+    }
+    bool wasShown = _rowCache.count >= 0;
+    pushRows(updateDepartureRows(display.getBuffer(), &_rowCache, _parsedRows, _nextSlot), wasShown);
+    if (!wasShown) Serial.printf("   First row on display at %lu ms\n", (unsigned long)millis());
+  }
+
+  void recordLatency(LatencyMetric metric, uint32_t ms) override {
+    if (metric == LATENCY_TOTAL && refreshing) return;  // boot to first render only
+    if (metric == LATENCY_PARSE) taskProfilerAddCpu(&taskProfiler, loopSlot, ms * 1000);
+    ::recordLatency(metric, ms);
+  }
+
+  int secondLimit(int limit, int displayable) override {
+    // Sized with this response already counted, as the next boot will see it.
+    LimitEstimator withThis = limitEstimate;
+    limitEstimatorRecord(&withThis, limit, displayable, true);
+    int next = limitEstimatorSecondLimit(&withThis, &kLimitPolicy, limit, displayable);
+    if (next > 0) {
+      Serial.printf("   Only %d of %d rows in %d departures; asking for %d\n", displayable, kDisplayRows, limit, next);
+      requestLimit = next;
+    }
+    return next;
+  }
+
+  void showResult(FetchOutcome outcome, int httpCode, const Departure* rows, int count) override {
+    int64_t renderStart = esp_timer_get_time();
+    if (outcome == FETCH_OK && showDepartures(rows, count)) {
+      taskProfilerAddCpu(&taskProfiler, loopSlot, (uint32_t)(esp_timer_get_time() - renderStart));
+      return;
+    }
+
+    // A message screen: drawn whole, and the next departures are too.
+    rowCacheInvalidate(&_rowCache);
+    rowsRedrawn = (1u << ROW_SLOTS) - 1;
+    display.clearDisplay();
+    display.setTextSize(1);
+    switch (outcome) {
+      case FETCH_OK:
+        display.setCursor(0, 20);
+        display.println("No Trams found");
+        break;
+      case FETCH_ERR_WIFI:
+        Serial.println("   FAILED: Could not connect to WiFi");
+        display.setCursor(30, 28);
+        display.print("WiFi Error!");
+        break;
+      case FETCH_ERR_TOO_LARGE:
+        Serial.println("   JSON parse error: departure too large, not retryable");
+        display.setCursor(0, 20);
+        display.print("Data too large");
+        display.setCursor(0, 36);
+        display.print("Lower limit/raise buf");
+        break;
+      case FETCH_ERR_PARSE:
+        Serial.println("   JSON parse error");
+        display.setCursor(0, 20);
+        display.print("Parse error");
+        display.setCursor(0, 36);
+        display.print("Try again later");
+        break;
+      case FETCH_ERR_NETWORK:
+      case FETCH_ERR_SERVER:
+        Serial.printf("   HTTP error: %d\n", httpCode);
+        display.setCursor(0, 20);
+        if (httpCode < 0) {
+          display.print("Network error");
+          display.setCursor(0, 36);
+          display.print("Code: ");
+          display.print(httpCode);
+        } else {
+          display.print("Server error: ");
+          display.print(httpCode);
+        }
+        display.setCursor(0, 52);
+        display.print("Try again later");
+        break;
+    }
+    display.display();
+    taskProfilerAddCpu(&taskProfiler, loopSlot, (uint32_t)(esp_timer_get_time() - renderStart));
+  }
+
+ private:
+  // Draw the displayable departures; false if there are none. Only rows that
+  // differ from what the panel shows are redrawn and sent.
+  bool showDepartures(const Departure* rows, int count) {
+    Departure shown[ROW_SLOTS];
+    int matches = 0;
+
+    for (int i = 0; i < count && matches < kDisplayRows; i++) {
+      const Departure* dep = &rows[i];
+      if (!isDisplayableDeparture(dep, DIRECTION_FILTER)) continue;
+
+      Serial.print("Direction: ");
+      Serial.println(dep->direction);
+      Serial.printf("  Sched: %02d:%02d | Real: %02d:%02d | Delay: %d min | Countdown: %d\n", dep->schedHour,
+                    dep->schedMinute, dep->realHour, dep->realMinute, dep->delayMin, dep->countdown);
+      shown[matches++] = *dep;
+    }
+
+    Serial.printf("   Found %d matching departures\n", matches);
+    if (matches == 0) return false;
+
+    // Blit pre-rendered glyphs straight into the SSD1306 buffer; same pixels
+    // as the GFX setTextSize/print sequence, without per-pixel drawing.
+    bool wasShown = _rowCache.count >= 0;
+    rowsRedrawn = updateDepartureRows(display.getBuffer(), &_rowCache, shown, matches);
+    pushRows(rowsRedrawn, wasShown);
+    return true;
+  }
+
+  // Send the redrawn row slots to the panel.
+  void pushRows(uint8_t redrawn, bool wasShown) {
+    if (!wasShown || redrawn == (1u << ROW_SLOTS) - 1) {
+      display.display();  // a whole redraw may also have cleared spilled text between rows
+      return;
+    }
+    for (int slot = 0; slot < ROW_SLOTS; slot++) {
+      if (!(redrawn & (1u << slot))) continue;
+      int y = departureRowY(slot);
+      pushDisplayPages(y / 8, (y + ROW_HEIGHT - 1) / 8);
+    }
+  }
+
+  RowCache _rowCache = {{}, -1};
+  Departure _parsedRows[ROW_SLOTS];  // rows put up by departureParsed(), _parsedRows[0.._nextSlot)
+  int _nextSlot = 0;
+  int _lastParsedIndex = -1;
+};
+
+static WiFiTransport wifiTransport;
+static BoardPlatform boardPlatform;
+static const FetchRequest kFetchRequest = {EFA_HOST, EFA_PORT, STATION_ID, kRequestLimit, DIRECTION_FILTER,
+                                           kDisplayRows, kRefreshIntervalMs > 0};
+static FetchCycle fetchCycle(boardPlatform, wifiTransport, kFetchRequest, departures);
+
+static uint32_t lastRefreshMs = 0;
+
+// WiFi, fetch and render, stepped on this task between spinner frames; then
+// the outcome feeds the limit history.
+void runFetchCycle() {
+  lastRefreshMs = millis();
+  int limit = limitEstimatorChoose(&limitEstimate, &kLimitPolicy);
+  boardPlatform.requestLimit = limit;
+  Serial.printf("   Request limit %d (%lu of %lu recent departures shown)\n", limit,
+                (unsigned long)limitEstimate.passed, (unsigned long)limitEstimate.seen);
+  fetchCycle.start(limit);
+  while (!fetchCycle.finished()) {
+    uint32_t idleMs = fetchCycle.step();
+    pollLatencyCommands();
+    if (idleMs > 0) delay(idleMs);
+  }
+  Serial.printf("   Fetch done after %d attempt(s): outcome %d, %d departures (parse %d)\n", fetchCycle.attempts(),
+                fetchCycle.outcome(), departures.count, departures.error);
+  if (departures.success) {
+    int count = departures.count;
+    limitEstimatorRecord(&limitEstimate, count,
+                         countDisplayableDepartures(departures.departures, count, DIRECTION_FILTER),
+                         fetchCycle.secondFetch());
+    limitDirty = true;
+  }
 }
 
-void stopSpinner() {
-  spinnerRunning = false;
-  // Brief grace period to let the task finish its current draw and exit cleanly.
-  vTaskDelay(pdMS_TO_TICKS(100));
+// Count one always-on refresh and persist the history every kRefreshSaveCycles.
+void recordRefresh() {
+  RefreshSample sample = {fetchCycle.durationMs(), fetchCycle.outcome() == FETCH_OK, fetchCycle.reusedConnection(),
+                          boardPlatform.rowsRedrawn, (uint32_t)(ESP.getHeapSize() - ESP.getFreeHeap())};
+  refreshStatsRecord(&refreshStats, &sample);
+  char line[112];
+  if (refreshStatsFormat(&refreshStats, line, sizeof(line)) > 0) Serial.printf("   [refresh] %s\n", line);
+  if (refreshStats.cycles % kRefreshSaveCycles == 0) {
+    saveLatency();
+    saveLimitEstimate();
+  }
 }
 
 void setup() {
@@ -79,11 +546,18 @@ void setup() {
 
   Serial.begin(115200);
   Serial.println("\n\n=== Starting VAG Departure Display ===");
+  powerGovernorInit(&powerGovernor);
+  taskProfilerInit(&taskProfiler);
+  refreshStatsInit(&refreshStats);
+  loopSlot = taskProfilerRegister(&taskProfiler, "loop", getArduinoLoopTaskStackSize());
+  enterPhase(PHASE_BOOT);
+  loadLatency();
+  loadLimitEstimate();
 
   // 1. Init Display
   Serial.println("1. Initializing display...");
   Wire.begin(I2C_SDA, I2C_SCL);
-  if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
+  if (!display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
     Serial.println("   FAILED: SSD1306 allocation failed");
     for (;;);
   }
@@ -91,40 +565,21 @@ void setup() {
   display.clearDisplay();
   display.setTextColor(WHITE);
 
-  startSpinner();
-
-  // 2. WiFi
-  Serial.print("2. Connecting to WiFi: ");
-  Serial.println(WIFI_SSID);
-
-  WiFi.mode(WIFI_STA);
-  WiFi.setTxPower(WIFI_POWER_11dBm);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  int timeout = 0;
-  while (WiFi.status() != WL_CONNECTED && timeout < 40) {
-    delay(250);
-    Serial.print(".");
-    timeout++;
+  // 2-3. WiFi, fetch and render.
+  runFetchCycle();
+  if (kRefreshIntervalMs > 0) {
+    // Always-on: WiFi stays up and loop() refreshes, also after a WiFi error.
+    boardPlatform.refreshing = true;
+    recordRefresh();
+    Serial.printf("4. Refreshing every %lu ms\n", (unsigned long)kRefreshIntervalMs);
+    return;
   }
-
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("\n   FAILED: Could not connect to WiFi");
-    stopSpinner();
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setCursor(30, 28);
-    display.print("WiFi Error!");
-    display.display();
+  saveLatency();
+  saveLimitEstimate();
+  if (fetchCycle.outcome() == FETCH_ERR_WIFI) {
     delay(2000);
     esp_deep_sleep_start();
   }
-  Serial.println("\n   OK - Connected!");
-  Serial.print("   IP: ");
-  Serial.println(WiFi.localIP());
-
-  // 3. Get Data
-  Serial.println("3. Fetching departure data...");
-  fetchDepartures();
 
   // 4. Shutdown WiFi
   Serial.println("4. Shutting down WiFi...");
@@ -133,201 +588,30 @@ void setup() {
   Serial.println("   OK");
 
   Serial.printf("5. Displaying for %d ms before sleep...\n", awakeTimeMs);
-  delay(awakeTimeMs);
+  enterPhase(PHASE_DISPLAY_HOLD);
+  holdDisplay(awakeTimeMs);
 
   // 5. Sleep
   Serial.println("6. Going to deep sleep...");
+  enterPhase(PHASE_SHUTDOWN);
+  printPowerReport();
+  printTaskReport();
+  pollLatencyCommands();
+  saveLatency();  // only writes if 'x' cleared the histograms above
   display.clearDisplay();
   display.display();
   display.ssd1306_command(SSD1306_DISPLAYOFF);
   esp_deep_sleep_start();
 }
 
-void fetchDepartures() {
-  Serial.println("   Starting HTTP request...");
-
-  String url =
-      "http://efa.vagfr.de/vagfr3/XSLT_DM_REQUEST"
-      "?outputFormat=JSON&language=de&stateless=1"
-      "&type_dm=stop&name_dm=" +
-      String(STATION_ID) + "&mode=direct&useRealtime=1&limit=15&depType=stopEvents";
-  Serial.print("   URL: ");
-  Serial.println(url);
-
-  const int maxRetries = 3;
-  int httpCode = 0;
-
-  for (int attempt = 1; attempt <= maxRetries; attempt++) {
-    Serial.printf("   Attempt %d/%d...\n", attempt, maxRetries);
-
-    WiFiClient client;
-    client.setTimeout(15000);
-    HTTPClient http;
-    http.setTimeout(15000);
-
-    if (!http.begin(client, url)) {
-      Serial.println("   HTTP begin failed!");
-      http.end();
-      if (attempt < maxRetries) {
-        delay(1000);
-        continue;
-      }
-      // All retries failed
-      stopSpinner();
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 24);
-      display.print("Connection failed");
-      display.setCursor(0, 40);
-      display.print("Check WiFi");
-      display.display();
-      return;
-    }
-
-    httpCode = http.GET();
-    Serial.printf("   HTTP response code: %d\n", httpCode);
-
-    // Retry on timeout or connection errors
-    if (httpCode < 0 && attempt < maxRetries) {
-      Serial.println("   Retrying...");
-      http.end();
-      delay(2000);
-      continue;
-    }
-
-    if (httpCode == HTTP_CODE_OK) {
-      Serial.printf("   Parsing JSON... (free heap: %u, content-length: %d)\n", ESP.getFreeHeap(),
-                    http.getSize());
-
-      // Stream-parse directly from the socket. The EFA body is ~167 KB; buffering
-      // it whole via http.getString() exhausts the heap once WiFi is up, leaving a
-      // truncated body that fails as invalid JSON. Streaming keeps peak RAM low.
-      DeparturesResult parsed = parseDeparturesJsonStream(http.getStream(), 15);
-      http.end();
-      if (!parsed.success) {
-        // A too-large response is deterministic: retrying the identical payload
-        // cannot help, so fail fast instead of burning the remaining attempts.
-        bool retryable = (parsed.error != PARSE_ERR_NO_MEMORY);
-        Serial.printf("   JSON parse error (code %d)%s\n", parsed.error,
-                      retryable ? ", retrying..." : ", not retryable");
-        if (retryable && attempt < maxRetries) {
-          delay(2000);
-          continue;
-        }
-
-        // Out of retries (or unrecoverable): show a message specific to the cause.
-        stopSpinner();
-        display.clearDisplay();
-        display.setTextSize(1);
-        display.setCursor(0, 20);
-        if (parsed.error == PARSE_ERR_NO_MEMORY) {
-          display.print("Data too large");
-          display.setCursor(0, 36);
-          display.print("Lower limit/raise buf");
-        } else {
-          display.print("Parse error");
-          display.setCursor(0, 36);
-          display.print("Try again later");
-        }
-        display.display();
-        return;
-      }
-
-      stopSpinner();
-      display.clearDisplay();
-
-      int matches = 0;
-      int rowY[3] = {0, 24, 48};
-
-      for (int i = 0; i < parsed.count && matches < 3; i++) {
-        Departure* dep = &parsed.departures[i];
-        if (!dep->valid) continue;
-        if (!matchesDirectionFilter(dep->direction, DIRECTION_FILTER)) continue;
-        if (dep->countdown < 2) continue;
-
-        Serial.print("Direction: ");
-        Serial.println(dep->direction);
-        Serial.printf("  Sched: %02d:%02d | Real: %02d:%02d | Delay: %d min | Countdown: %d\n", dep->schedHour,
-                      dep->schedMinute, dep->realHour, dep->realMinute, dep->delayMin, dep->countdown);
-
-        int y = rowY[matches];
-
-        display.setTextColor(WHITE);
-        display.setTextSize(2);
-        display.setCursor(0, y);
-        char hrBuf[3], mnBuf[3];
-        snprintf(hrBuf, sizeof(hrBuf), "%02d", dep->realHour);
-        snprintf(mnBuf, sizeof(mnBuf), "%02d", dep->realMinute);
-        display.print(hrBuf);
-        display.print(":");
-        display.setCursor(36, y);
-        display.print(mnBuf);
-
-        if (dep->delayMin != 0) {
-          display.setTextSize(1);
-          display.setCursor(62, y);
-          // Clamp displayed delay to [-99, +99]; show "!" when out of range.
-          int displayDelay = dep->delayMin;
-          bool delayOverflow = (displayDelay > 99 || displayDelay < -99);
-          if (delayOverflow) {
-            display.print("!");
-          } else {
-            if (displayDelay > 0) display.print("+");
-            display.print(displayDelay);
-          }
-        }
-
-        display.setTextSize(1);
-        display.setCursor(83, y + 4);
-        display.print("in");
-
-        display.setTextSize(2);
-        int xPos = 110;
-        if (dep->countdown >= 10) xPos = 98;
-
-        display.setCursor(xPos, y);
-        display.print(dep->countdown);
-        display.setTextSize(1);
-        display.print("'");
-
-        matches++;
-      }
-
-      Serial.printf("   Found %d matching departures\n", matches);
-      if (matches == 0) {
-        display.setCursor(0, 20);
-        display.setTextSize(1);
-        display.println("No Trams found");
-      }
-      display.display();
-      Serial.println("   Display updated");
-      return;  // Success, exit function
-    }
-
-    // Error handling
-    Serial.printf("   HTTP error: %d\n", httpCode);
-    http.end();
-
-    if (attempt == maxRetries) {
-      // All retries exhausted, show error
-      stopSpinner();
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 20);
-      if (httpCode < 0) {
-        display.print("Network error");
-        display.setCursor(0, 36);
-        display.print("Code: ");
-        display.print(httpCode);
-      } else {
-        display.print("Server error: ");
-        display.print(httpCode);
-      }
-      display.setCursor(0, 52);
-      display.print("Try again later");
-      display.display();
-    }
+// Reached only in always-on refresh mode; press-and-sleep ends in setup().
+void loop() {
+  // Radio up between refreshes: 80 MHz with modem sleep, as in the display hold.
+  enterPhase(PHASE_DISPLAY_HOLD);
+  while ((uint32_t)(millis() - lastRefreshMs) < kRefreshIntervalMs) {
+    pollLatencyCommands();
+    delay(50);
   }
+  runFetchCycle();
+  recordRefresh();
 }
-
-void loop() {}
@@ -0,0 +1,80 @@
+#include "power_governor.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Indexed by BootPhase. The ESP32 draws roughly 20 mA less at 80 MHz than at
+// 240 MHz, and WiFi is happy at 80, so only the phases that actually compute
+// run at full clock. Modem sleep (the Arduino default) is dropped only while
+// the body streams in, where DTIM dozing would throttle the TCP window.
+static const PowerPolicy kPolicies[PHASE_COUNT] = {
+    {80, true, false},    // PHASE_BOOT
+    {80, true, false},    // PHASE_WIFI_CONNECT
+    {80, true, false},    // PHASE_HTTP_WAIT
+    {240, false, false},  // PHASE_RECEIVE
+    {240, true, false},   // PHASE_RENDER
+    {80, true, true},     // PHASE_DISPLAY_HOLD: radio is off, panel keeps its own RAM
+    {80, true, false},    // PHASE_SHUTDOWN
+};
+
+static const char* const kPhaseNames[PHASE_COUNT] = {
+    "boot", "wifi-connect", "http-wait", "receive", "render", "display-hold", "shutdown",
+};
+
+static bool isValidPhase(BootPhase phase) { return (int)phase >= 0 && (int)phase < PHASE_COUNT; }
+
+const PowerPolicy* powerPolicyFor(BootPhase phase) {
+  return &kPolicies[isValidPhase(phase) ? phase : PHASE_BOOT];
+}
+
+const char* bootPhaseName(BootPhase phase) { return isValidPhase(phase) ? kPhaseNames[phase] : "?"; }
+
+void powerGovernorInit(PowerGovernor* gov) {
+  memset(gov, 0, sizeof(*gov));
+  gov->started = false;
+  gov->phase = PHASE_BOOT;
+}
+
+static uint8_t policyChanges(const PowerPolicy* from, const PowerPolicy* to) {
+  uint8_t changes = 0;
+  if (from->cpuMhz != to->cpuMhz) changes |= POWER_CHANGE_CPU;
+  if (from->modemSleep != to->modemSleep) changes |= POWER_CHANGE_MODEM_SLEEP;
+  if (from->lightSleep != to->lightSleep) changes |= POWER_CHANGE_LIGHT_SLEEP;
+  return changes;
+}
+
+uint8_t powerGovernorEnter(PowerGovernor* gov, BootPhase phase, uint32_t nowMs) {
+  if (!isValidPhase(phase)) phase = PHASE_BOOT;
+  if (gov->started && gov->phase == phase) return 0;
+
+  // Nothing is known about the hardware before the first phase: apply all.
+  uint8_t changes =
+      gov->started ? policyChanges(powerPolicyFor(gov->phase), powerPolicyFor(phase)) : (uint8_t)POWER_CHANGE_ALL;
+  gov->started = true;
+  gov->phase = phase;
+
+  if (gov->logCount < POWER_LOG_CAPACITY) {
+    PowerTransition* entry = &gov->log[gov->logCount++];
+    entry->phase = phase;
+    entry->atMs = nowMs;
+    entry->changes = changes;
+  } else {
+    gov->dropped++;
+  }
+  return changes;
+}
+
+uint32_t powerPhaseDurationMs(const PowerGovernor* gov, int index, uint32_t nowMs) {
+  if (index < 0 || index >= gov->logCount) return 0;
+  // Once entries have been dropped the last stored one no longer ends at nowMs.
+  uint32_t end = (index + 1 < gov->logCount) ? gov->log[index + 1].atMs : (gov->dropped ? gov->log[index].atMs : nowMs);
+  return end - gov->log[index].atMs;
+}
+
+uint32_t powerCpuMhzMs(const PowerGovernor* gov, uint32_t nowMs) {
+  uint32_t total = 0;
+  for (int i = 0; i < gov->logCount; i++) {
+    total += powerPhaseDurationMs(gov, i, nowMs) * powerPolicyFor(gov->log[i].phase)->cpuMhz;
+  }
+  return total;
+}
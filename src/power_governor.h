@@ -0,0 +1,118 @@
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define POWER_LOG_CAPACITY 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Phases of one wake cycle, in the order setup() normally walks them.
+ */
+typedef enum {
+  PHASE_BOOT = 0,      // display init, spinner start
+  PHASE_WIFI_CONNECT,  // association and DHCP; mostly polling WiFi.status()
+  PHASE_HTTP_WAIT,     // connect, send request, wait for the status line
+  PHASE_RECEIVE,       // body arriving; parsed between socket reads
+  PHASE_RENDER,        // rows blitted and pushed over I2C
+  PHASE_DISPLAY_HOLD,  // radio off, static image held on the panel
+  PHASE_SHUTDOWN,      // blank the panel, enter deep sleep
+  PHASE_COUNT,
+} BootPhase;
+
+/**
+ * What the governor asks for in one phase.
+ *
+ * cpuMhz is one of the ESP32 PLL steps (80, 160, 240); WiFi needs at least 80.
+ * modemSleep lets the radio doze between DTIM beacons while associated, which
+ * adds up to a beacon interval of latency to every packet. lightSleep means
+ * waits in this phase may use light sleep instead of a busy delay.
+ */
+typedef struct {
+  uint16_t cpuMhz;
+  bool modemSleep;
+  bool lightSleep;
+} PowerPolicy;
+
+/** Which parts of the policy differ from the previous phase (bit mask). */
+enum {
+  POWER_CHANGE_CPU = 1 << 0,
+  POWER_CHANGE_MODEM_SLEEP = 1 << 1,
+  POWER_CHANGE_LIGHT_SLEEP = 1 << 2,
+  POWER_CHANGE_ALL = POWER_CHANGE_CPU | POWER_CHANGE_MODEM_SLEEP | POWER_CHANGE_LIGHT_SLEEP,
+};
+
+/** One entry of the transition log. */
+typedef struct {
+  BootPhase phase;  // phase entered
+  uint32_t atMs;    // when it was entered
+  uint8_t changes;  // POWER_CHANGE_* bits applied on entry
+} PowerTransition;
+
+/**
+ * Governor state: the current phase and a fixed-size transition log.
+ * Entries past POWER_LOG_CAPACITY are counted in dropped but not stored.
+ */
+typedef struct {
+  bool started;
+  BootPhase phase;
+  PowerTransition log[POWER_LOG_CAPACITY];
+  int logCount;
+  int dropped;
+} PowerGovernor;
+
+/**
+ * Policy for a phase. Low clock wherever the CPU mostly waits on the radio or
+ * holds a static image; full clock for the receive/parse and render bursts.
+ *
+ * @param phase Boot phase (out-of-range values get the PHASE_BOOT policy)
+ * @return Pointer into the static policy table
+ */
+const PowerPolicy* powerPolicyFor(BootPhase phase);
+
+/**
+ * Short name for logs, e.g. "wifi-connect".
+ */
+const char* bootPhaseName(BootPhase phase);
+
+/**
+ * Reset the governor; the next powerGovernorEnter() applies everything.
+ */
+void powerGovernorInit(PowerGovernor* gov);
+
+/**
+ * Enter a phase and log the transition.
+ *
+ * Re-entering the current phase is a no-op and is not logged. The caller
+ * applies the returned changes (setCpuFrequencyMhz, WiFi.setSleep, ...) using
+ * powerPolicyFor(phase); the governor itself touches no hardware.
+ *
+ * @param gov Governor state
+ * @param phase Phase being entered
+ * @param nowMs Current time in milliseconds (millis())
+ * @return POWER_CHANGE_* bits for the settings that differ from the last phase
+ */
+uint8_t powerGovernorEnter(PowerGovernor* gov, BootPhase phase, uint32_t nowMs);
+
+/**
+ * Time spent in the phase of log entry index: up to the next entry, or up to
+ * nowMs for the last one.
+ */
+uint32_t powerPhaseDurationMs(const PowerGovernor* gov, int index, uint32_t nowMs);
+
+/**
+ * Time spent in each phase, summed over the log, weighted by its clock:
+ * sum of duration * cpuMhz, in MHz-milliseconds. Comparing this against the
+ * same cycle at a fixed 240 MHz gives the share of CPU cycles avoided.
+ */
+uint32_t powerCpuMhzMs(const PowerGovernor* gov, uint32_t nowMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // POWER_GOVERNOR_H
@@ -0,0 +1,98 @@
+#include "receive_pipeline.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <thread>
+#endif
+
+// Longest span the consumer holds before handing space back to the producer,
+// so a slow parse never keeps the whole ring pinned.
+static const size_t kMaxSpan = 256;
+
+void pipelineYield() {
+#ifdef ARDUINO
+  vTaskDelay(1);
+#else
+  std::this_thread::yield();
+#endif
+}
+
+size_t pumpToRing(ByteRing& ring, ReceiveFn receive, void* context, PipelineWaitFn wait) {
+  size_t total = 0;
+  while (!ring.cancelled()) {
+    uint8_t* span;
+    size_t room = ring.writableSpan(&span);
+    if (room == 0) {
+      wait();
+      continue;
+    }
+
+    int n = receive(context, span, room);
+    if (n < 0) break;
+    if (n == 0) {
+      wait();
+      continue;
+    }
+    ring.commitWrite((size_t)n);
+    total += (size_t)n;
+  }
+  ring.close();
+  return total;
+}
+
+ParseError parseFromRing(ByteRing& ring, DeparturePushParser& parser, PipelineWaitFn wait) {
+  while (!parser.finished()) {
+    // As in RingSource::refill(): closed first, so an empty ring after it
+    // really is the end of input.
+    bool closed = ring.closed();
+    const uint8_t* span;
+    size_t n = ring.readableSpan(&span);
+    if (n > 0) {
+      ring.commitRead(parser.feed(span, n));
+    } else if (closed) {
+      parser.finish();
+    } else {
+      wait();
+    }
+  }
+  ring.cancel();
+  return parser.error();
+}
+
+int RingSource::read() {
+  if (_remaining == 0 && !refill()) return -1;
+  int c = _span[_spanLength - _remaining];
+  _remaining--;
+  return c;
+}
+
+size_t RingSource::peekSpan(const uint8_t** data) {
+  if (_remaining == 0 && !refill()) return 0;
+  *data = _span + (_spanLength - _remaining);
+  return _remaining;
+}
+
+void RingSource::consume(size_t n) { _remaining -= (n < _remaining) ? n : _remaining; }
+
+void RingSource::release() {
+  if (_spanLength > 0) _ring.commitRead(_spanLength - _remaining);
+  _spanLength = 0;
+  _remaining = 0;
+}
+
+bool RingSource::refill() {
+  release();
+  for (;;) {
+    // Sample closed before looking for data: everything written before
+    // close() is visible by then, so an empty ring afterwards really is the end.
+    bool closed = _ring.closed();
+    size_t n = _ring.readableSpan(&_span);
+    if (n > 0) {
+      _spanLength = _remaining = (n < kMaxSpan) ? n : kMaxSpan;
+      return true;
+    }
+    if (closed) return false;
+    _wait();
+  }
+}
@@ -0,0 +1,87 @@
+#ifndef RECEIVE_PIPELINE_H
+#define RECEIVE_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "departure_logic.h"
+#include "spsc_ring.h"
+
+/**
+ * Receive/parse pipeline over a ByteRing.
+ *
+ * A receive task drains the socket into the ring as fast as data arrives
+ * (pumpToRing) while the parser, on another core, consumes the ring through
+ * a RingSource or parseFromRing(). Neither side waits on the other except
+ * when the ring is full or empty, so TCP windows are emptied at network speed
+ * instead of parse speed.
+ *
+ * The firmware does not use it: FetchCycle receives and parses on the loop
+ * task, between spinner frames. It is kept for a board or payload where the
+ * parse cannot keep up with the socket, and is built and stress-tested on the
+ * host only (the ESP32 env's build_src_filter leaves it out of the image).
+ */
+
+/** Called by either side when it has to wait for the other. */
+typedef void (*PipelineWaitFn)();
+
+/** Default wait: a one-tick vTaskDelay on the ESP32, a thread yield on the host. */
+void pipelineYield();
+
+/**
+ * Fill up to capacity bytes of buffer from the network.
+ *
+ * @return Bytes read (> 0), 0 if nothing is available yet, or -1 once the
+ *         input has ended (connection closed, body complete, or timed out)
+ */
+typedef int (*ReceiveFn)(void* context, uint8_t* buffer, size_t capacity);
+
+/**
+ * Producer side: move bytes from receive() into the ring until the input ends
+ * or the consumer cancels, then close the ring. Bytes are received straight
+ * into the ring's free space, without an intermediate copy.
+ *
+ * @return Number of bytes placed in the ring
+ */
+size_t pumpToRing(ByteRing& ring, ReceiveFn receive, void* context, PipelineWaitFn wait);
+
+/**
+ * Consumer side: presents the ring as a DepartureSource for the incremental
+ * parser. read() waits while the ring is empty and returns -1 only after the
+ * producer has closed it and every byte has been consumed.
+ */
+class RingSource : public DepartureSource {
+ public:
+  RingSource(ByteRing& ring, PipelineWaitFn wait)
+      : _ring(ring), _wait(wait), _span(NULL), _spanLength(0), _remaining(0) {}
+  ~RingSource() { release(); }
+
+  int read();
+
+  /** Waits like read(); returns 0 only at the end of input. */
+  size_t peekSpan(const uint8_t** data);
+  void consume(size_t n);
+
+  /** Hand the bytes consumed so far back to the producer. */
+  void release();
+
+ private:
+  bool refill();
+
+  ByteRing& _ring;
+  PipelineWaitFn _wait;
+  const uint8_t* _span;  // current readable span, consumed in place
+  size_t _spanLength;    // length of that span when it was taken
+  size_t _remaining;     // bytes of the span not yet read or consumed
+};
+
+/**
+ * Consumer side for the push parser: feed it spans straight out of the ring
+ * until it is finished or the producer has closed the ring and every byte
+ * has been read, then cancel the ring so the producer stops.
+ *
+ * @return parser.error() once settled
+ */
+ParseError parseFromRing(ByteRing& ring, DeparturePushParser& parser, PipelineWaitFn wait);
+
+#endif  // RECEIVE_PIPELINE_H
@@ -0,0 +1,46 @@
+#include "refresh_stats.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void refreshStatsInit(RefreshStats* stats) { memset(stats, 0, sizeof(*stats)); }
+
+void refreshStatsRecord(RefreshStats* stats, const RefreshSample* sample) {
+  stats->cycles++;
+  if (!sample->ok) stats->failures++;
+  if (sample->reusedConnection) stats->reusedConnections++;
+  if (sample->rowsRedrawn == 0) stats->unchangedFrames++;
+  for (uint8_t rows = sample->rowsRedrawn; rows != 0; rows &= (uint8_t)(rows - 1)) stats->rowsRedrawn++;
+
+  stats->lastCycleMs = sample->cycleMs;
+  if (stats->cycles == 1 || sample->cycleMs < stats->minCycleMs) stats->minCycleMs = sample->cycleMs;
+  if (sample->cycleMs > stats->maxCycleMs) stats->maxCycleMs = sample->cycleMs;
+  stats->totalCycleMs += sample->cycleMs;
+
+  stats->lastHeapUsed = sample->heapUsed;
+  if (sample->heapUsed > stats->peakHeapUsed) stats->peakHeapUsed = sample->heapUsed;
+  if (stats->cycles == REFRESH_WARMUP_CYCLES) stats->baselineHeapUsed = sample->heapUsed;
+}
+
+int32_t refreshStatsHeapDrift(const RefreshStats* stats) {
+  if (stats->cycles < REFRESH_WARMUP_CYCLES) return 0;
+  return (int32_t)(stats->lastHeapUsed - stats->baselineHeapUsed);
+}
+
+uint32_t refreshStatsMeanCycleMs(const RefreshStats* stats) {
+  return stats->cycles ? (uint32_t)(stats->totalCycleMs / stats->cycles) : 0;
+}
+
+size_t refreshStatsFormat(const RefreshStats* stats, char* buffer, size_t capacity) {
+  int n = snprintf(buffer, capacity,
+                   "cycles %lu (%lu failed, %lu reused) cycle %lu/%lu/%lu ms heap drift %+ld peak %lu",
+                   (unsigned long)stats->cycles, (unsigned long)stats->failures,
+                   (unsigned long)stats->reusedConnections, (unsigned long)stats->lastCycleMs,
+                   (unsigned long)refreshStatsMeanCycleMs(stats), (unsigned long)stats->maxCycleMs,
+                   (long)refreshStatsHeapDrift(stats), (unsigned long)stats->peakHeapUsed);
+  if (n < 0 || (size_t)n >= capacity) {
+    if (capacity > 0) buffer[0] = '\0';
+    return 0;
+  }
+  return (size_t)n;
+}
@@ -0,0 +1,75 @@
+#ifndef REFRESH_STATS_H
+#define REFRESH_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Cycles before the heap baseline is taken: the first ones allocate lwIP,
+// WiFi and TLS-free socket state that then stays for good.
+#define REFRESH_WARMUP_CYCLES 3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * One always-on refresh cycle, as seen by the caller.
+ */
+typedef struct {
+  uint32_t cycleMs;       // start of the fetch until the rows were on screen
+  bool ok;                // the fetch produced departures
+  bool reusedConnection;  // the request went out on the previous cycle's connection
+  uint8_t rowsRedrawn;    // row slots redrawn (0 = frame unchanged, nothing sent)
+  uint32_t heapUsed;      // heap bytes in use after the cycle
+} RefreshSample;
+
+/**
+ * Sustained-operation counters for always-on refresh. Heap drift is heap in
+ * use now minus after warm-up: a steady non-zero value is a leak.
+ */
+typedef struct {
+  uint32_t cycles;
+  uint32_t failures;
+  uint32_t reusedConnections;
+  uint32_t rowsRedrawn;
+  uint32_t unchangedFrames;  // cycles that redrew nothing
+  uint32_t lastCycleMs;
+  uint32_t minCycleMs;
+  uint32_t maxCycleMs;
+  uint64_t totalCycleMs;
+  uint32_t baselineHeapUsed;  // at the end of warm-up; 0 before
+  uint32_t lastHeapUsed;
+  uint32_t peakHeapUsed;
+} RefreshStats;
+
+void refreshStatsInit(RefreshStats* stats);
+
+/**
+ * Count one cycle.
+ */
+void refreshStatsRecord(RefreshStats* stats, const RefreshSample* sample);
+
+/**
+ * Heap in use now minus at the end of warm-up, in bytes; 0 during warm-up.
+ */
+int32_t refreshStatsHeapDrift(const RefreshStats* stats);
+
+/**
+ * Mean cycle time in milliseconds (0 before the first cycle).
+ */
+uint32_t refreshStatsMeanCycleMs(const RefreshStats* stats);
+
+/**
+ * One-line summary for the serial log, e.g.
+ * "cycles 120 (2 failed, 118 reused) cycle 412/398/1630 ms heap drift +0 peak 61234".
+ *
+ * @return Characters written (excluding the NUL), or 0 if buffer is too small
+ */
+size_t refreshStatsFormat(const RefreshStats* stats, char* buffer, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // REFRESH_STATS_H
@@ -0,0 +1,76 @@
+// Generated by scripts/gen_row_glyphs.py -- do not edit.
+//
+// Pre-rasterized glyphs for the departure row renderer, taken from the
+// Adafruit GFX classic 5x7 font and laid out like the SSD1306 frame buffer:
+// one byte per column per 8-row page, bit 0 = top row.
+
+#ifndef ROW_GLYPHS_H
+#define ROW_GLYPHS_H
+
+#include <stdint.h>
+
+#define ROW_GLYPH_COUNT 17
+
+// Characters covered, in table order.
+static const char kRowGlyphChars[] = "0123456789:+-!'in";
+
+// Text size 1: the font's own five columns, one page tall.
+static const uint8_t kRowGlyphs1[ROW_GLYPH_COUNT][5] = {
+    {0x3E, 0x51, 0x49, 0x45, 0x3E},  // '0'
+    {0x00, 0x42, 0x7F, 0x40, 0x00},  // '1'
+    {0x72, 0x49, 0x49, 0x49, 0x46},  // '2'
+    {0x21, 0x41, 0x49, 0x4D, 0x33},  // '3'
+    {0x18, 0x14, 0x12, 0x7F, 0x10},  // '4'
+    {0x27, 0x45, 0x45, 0x45, 0x39},  // '5'
+    {0x3C, 0x4A, 0x49, 0x49, 0x31},  // '6'
+    {0x41, 0x21, 0x11, 0x09, 0x07},  // '7'
+    {0x36, 0x49, 0x49, 0x49, 0x36},  // '8'
+    {0x46, 0x49, 0x49, 0x29, 0x1E},  // '9'
+    {0x00, 0x00, 0x14, 0x00, 0x00},  // ':'
+    {0x08, 0x08, 0x3E, 0x08, 0x08},  // '+'
+    {0x08, 0x08, 0x08, 0x08, 0x08},  // '-'
+    {0x00, 0x00, 0x5F, 0x00, 0x00},  // '!'
+    {0x00, 0x08, 0x07, 0x03, 0x00},  // '''
+    {0x00, 0x44, 0x7D, 0x40, 0x00},  // 'i'
+    {0x7C, 0x08, 0x04, 0x04, 0x78},  // 'n'
+};
+
+// Text size 2: every column and row doubled, ten columns two pages tall.
+static const uint8_t kRowGlyphs2[ROW_GLYPH_COUNT][2][10] = {
+    {{0xFC, 0xFC, 0x03, 0x03, 0xC3, 0xC3, 0x33, 0x33, 0xFC, 0xFC},  // '0'
+     {0x0F, 0x0F, 0x33, 0x33, 0x30, 0x30, 0x30, 0x30, 0x0F, 0x0F}},
+    {{0x00, 0x00, 0x0C, 0x0C, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00},  // '1'
+     {0x00, 0x00, 0x30, 0x30, 0x3F, 0x3F, 0x30, 0x30, 0x00, 0x00}},
+    {{0x0C, 0x0C, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0x3C, 0x3C},  // '2'
+     {0x3F, 0x3F, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30}},
+    {{0x03, 0x03, 0x03, 0x03, 0xC3, 0xC3, 0xF3, 0xF3, 0x0F, 0x0F},  // '3'
+     {0x0C, 0x0C, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0F, 0x0F}},
+    {{0xC0, 0xC0, 0x30, 0x30, 0x0C, 0x0C, 0xFF, 0xFF, 0x00, 0x00},  // '4'
+     {0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x3F, 0x3F, 0x03, 0x03}},
+    {{0x3F, 0x3F, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xC3, 0xC3},  // '5'
+     {0x0C, 0x0C, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0F, 0x0F}},
+    {{0xF0, 0xF0, 0xCC, 0xCC, 0xC3, 0xC3, 0xC3, 0xC3, 0x03, 0x03},  // '6'
+     {0x0F, 0x0F, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0F, 0x0F}},
+    {{0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0xC3, 0xC3, 0x3F, 0x3F},  // '7'
+     {0x30, 0x30, 0x0C, 0x0C, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00}},
+    {{0x3C, 0x3C, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0x3C, 0x3C},  // '8'
+     {0x0F, 0x0F, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0F, 0x0F}},
+    {{0x3C, 0x3C, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFC, 0xFC},  // '9'
+     {0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0C, 0x0C, 0x03, 0x03}},
+    {{0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00},  // ':'
+     {0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00}},
+    {{0xC0, 0xC0, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xC0, 0xC0},  // '+'
+     {0x00, 0x00, 0x00, 0x00, 0x0F, 0x0F, 0x00, 0x00, 0x00, 0x00}},
+    {{0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0},  // '-'
+     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    {{0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00},  // '!'
+     {0x00, 0x00, 0x00, 0x00, 0x33, 0x33, 0x00, 0x00, 0x00, 0x00}},
+    {{0x00, 0x00, 0xC0, 0xC0, 0x3F, 0x3F, 0x0F, 0x0F, 0x00, 0x00},  // '''
+     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    {{0x00, 0x00, 0x30, 0x30, 0xF3, 0xF3, 0x00, 0x00, 0x00, 0x00},  // 'i'
+     {0x00, 0x00, 0x30, 0x30, 0x3F, 0x3F, 0x30, 0x30, 0x00, 0x00}},
+    {{0xF0, 0xF0, 0xC0, 0xC0, 0x30, 0x30, 0x30, 0x30, 0xC0, 0xC0},  // 'n'
+     {0x3F, 0x3F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3F, 0x3F}},
+};
+
+#endif  // ROW_GLYPHS_H
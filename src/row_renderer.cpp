@@ -0,0 +1,192 @@
+#include "row_renderer.h"
+
+#include <string.h>
+
+#include "row_glyphs.h"
+
+static const int kPages = ROW_BUFFER_HEIGHT / 8;
+
+// Text cursor with the same semantics as Adafruit GFX: each glyph advances it
+// by 6 * size, and a glyph that would cross the right edge wraps to the start
+// of the next text line first.
+struct RowCursor {
+  int x;
+  int y;
+  int size;
+};
+
+static void setCursor(RowCursor& cursor, int x, int y, int size) {
+  cursor.x = x;
+  cursor.y = y;
+  cursor.size = size;
+}
+
+static int glyphIndex(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c == '\0') return -1;
+  const char* p = strchr(kRowGlyphChars, c);
+  return (p != NULL) ? (int)(p - kRowGlyphChars) : -1;
+}
+
+// OR a pre-rasterized glyph into the buffer with its top-left corner at (x, y).
+// Page-aligned rows copy column bytes as-is; other rows split each byte across
+// two pages. Anything past the right or bottom edge is clipped.
+static void blitGlyph(uint8_t* buffer, int x, int y, int size, int glyph) {
+  if (x >= ROW_BUFFER_WIDTH || y >= ROW_BUFFER_HEIGHT) return;
+
+  const uint8_t* columns = (size == 1) ? kRowGlyphs1[glyph] : kRowGlyphs2[glyph][0];
+  const int width = 5 * size;
+  const int shift = y & 7;
+
+  for (int p = 0; p < size; p++) {
+    int page = (y >> 3) + p;
+    if (page >= kPages) break;
+    uint8_t* dst = buffer + page * ROW_BUFFER_WIDTH;
+    uint8_t* below = (shift != 0 && page + 1 < kPages) ? dst + ROW_BUFFER_WIDTH : NULL;
+    const uint8_t* src = columns + p * width;
+
+    for (int c = 0; c < width && x + c < ROW_BUFFER_WIDTH; c++) {
+      dst[x + c] |= (uint8_t)(src[c] << shift);
+      if (below != NULL) below[x + c] |= (uint8_t)(src[c] >> (8 - shift));
+    }
+  }
+}
+
+static void printChar(uint8_t* buffer, RowCursor& cursor, char c) {
+  const int advance = 6 * cursor.size;
+  if (cursor.x + advance > ROW_BUFFER_WIDTH) {
+    cursor.x = 0;
+    cursor.y += 8 * cursor.size;
+  }
+  int glyph = glyphIndex(c);
+  if (glyph >= 0) blitGlyph(buffer, cursor.x, cursor.y, cursor.size, glyph);
+  cursor.x += advance;
+}
+
+static void printText(uint8_t* buffer, RowCursor& cursor, const char* text) {
+  while (*text != '\0') printChar(buffer, cursor, *text++);
+}
+
+// Decimal digits of value into out (at least 12 bytes), like Print::print(int).
+static void formatInt(int value, char* out) {
+  char digits[11];
+  int n = 0;
+  unsigned int magnitude = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+  do {
+    digits[n++] = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0) *out++ = '-';
+  while (n > 0) *out++ = digits[--n];
+  *out = '\0';
+}
+
+// Same characters snprintf(out, 3, "%02d", value) produces: zero-padded to two
+// digits and cut to two characters when the value does not fit.
+static void formatTwoDigits(int value, char out[3]) {
+  char full[12];
+  formatInt(value, full);
+  if (value >= 0 && value < 10) {
+    out[0] = '0';
+    out[1] = full[0];
+  } else {
+    out[0] = full[0];
+    out[1] = full[1];
+  }
+  out[2] = '\0';
+}
+
+void renderDepartureRow(uint8_t* buffer, int y, const Departure* dep) {
+  RowCursor cursor;
+  char text[12];
+
+  // Real time "HH:" at size 2, minutes at x=36
+  setCursor(cursor, 0, y, 2);
+  formatTwoDigits(dep->realHour, text);
+  printText(buffer, cursor, text);
+  printChar(buffer, cursor, ':');
+  setCursor(cursor, 36, y, 2);
+  formatTwoDigits(dep->realMinute, text);
+  printText(buffer, cursor, text);
+
+  if (dep->delayMin != 0) {
+    setCursor(cursor, 62, y, 1);
+    // Clamp displayed delay to [-99, +99]; show "!" when out of range.
+    if (dep->delayMin > 99 || dep->delayMin < -99) {
+      printChar(buffer, cursor, '!');
+    } else {
+      if (dep->delayMin > 0) printChar(buffer, cursor, '+');
+      formatInt(dep->delayMin, text);
+      printText(buffer, cursor, text);
+    }
+  }
+
+  setCursor(cursor, 83, y + 4, 1);
+  printText(buffer, cursor, "in");
+
+  // Countdown at size 2, right-aligned for two digits, then a size 1 tick
+  setCursor(cursor, (dep->countdown >= 10) ? 98 : 110, y, 2);
+  formatInt(dep->countdown, text);
+  printText(buffer, cursor, text);
+  cursor.size = 1;
+  printChar(buffer, cursor, '\'');
+}
+
+static const int kRowY[ROW_SLOTS] = {0, 24, 48};
+
+int departureRowY(int slot) { return (slot >= 0 && slot < ROW_SLOTS) ? kRowY[slot] : 0; }
+
+bool departureRowEquals(const Departure* a, const Departure* b) {
+  return a->realHour == b->realHour && a->realMinute == b->realMinute && a->delayMin == b->delayMin &&
+         a->countdown == b->countdown;
+}
+
+void rowCacheInvalidate(RowCache* cache) { cache->count = -1; }
+
+// Clear the ROW_HEIGHT pixel lines from y down, bit-exact for rows that do not
+// start on a page boundary.
+static void clearRow(uint8_t* buffer, int y) {
+  for (int line = y; line < y + ROW_HEIGHT && line < ROW_BUFFER_HEIGHT; line++) {
+    uint8_t* page = buffer + (line >> 3) * ROW_BUFFER_WIDTH;
+    uint8_t keep = (uint8_t)~(1u << (line & 7));
+    for (int x = 0; x < ROW_BUFFER_WIDTH; x++) page[x] &= keep;
+  }
+}
+
+// A countdown of three characters, or a negative one, does not fit at its
+// x position and wraps onto the next text line, below the row's own band.
+static bool rowSpills(const Departure* dep) { return dep->countdown < 0 || dep->countdown >= 100; }
+
+uint8_t updateDepartureRows(uint8_t* buffer, RowCache* cache, const Departure* rows, int count) {
+  if (count > ROW_SLOTS) count = ROW_SLOTS;
+  if (count < 0) count = 0;
+
+  uint8_t changed = 0;
+  bool spills = false;
+  bool whole = (cache->count < 0);
+  for (int slot = 0; slot < ROW_SLOTS && !whole; slot++) {
+    bool want = slot < count;
+    bool had = slot < cache->count;
+    if ((had && rowSpills(&cache->rows[slot])) || (want && rowSpills(&rows[slot]))) spills = true;
+    if (want == had && (!want || departureRowEquals(&cache->rows[slot], &rows[slot]))) continue;
+    changed |= (uint8_t)(1u << slot);
+  }
+
+  // Clearing one band would leave or cut the wrapped part of a spilling row.
+  if (whole || (changed && spills)) {
+    whole = true;
+    memset(buffer, 0, ROW_BUFFER_WIDTH * ROW_BUFFER_HEIGHT / 8);
+    changed = (1u << ROW_SLOTS) - 1;
+  }
+  for (int slot = 0; slot < ROW_SLOTS; slot++) {
+    if (!(changed & (1u << slot))) continue;
+    if (!whole) clearRow(buffer, kRowY[slot]);
+    if (slot < count) {
+      renderDepartureRow(buffer, kRowY[slot], &rows[slot]);
+      cache->rows[slot] = rows[slot];
+    }
+  }
+  cache->count = count;
+  return changed;
+}
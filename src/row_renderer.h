@@ -0,0 +1,83 @@
+#ifndef ROW_RENDERER_H
+#define ROW_RENDERER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "departure_logic.h"
+
+// Frame buffer geometry the renderer writes into (SSD1306 128x64).
+#define ROW_BUFFER_WIDTH 128
+#define ROW_BUFFER_HEIGHT 64
+
+// Rows on the display: ROW_SLOTS rows of ROW_HEIGHT pixels (size 2 text).
+#define ROW_SLOTS 3
+#define ROW_HEIGHT 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Draw one departure row ("17:26+3   in 4'") into an SSD1306 frame buffer.
+ *
+ * The buffer uses the SSD1306 page layout that Adafruit_SSD1306::getBuffer()
+ * exposes: byte x + (y / 8) * ROW_BUFFER_WIDTH holds column x of page y / 8,
+ * bit y % 8. Glyphs are blitted a column byte at a time from the tables in
+ * row_glyphs.h instead of being drawn pixel by pixel through Adafruit GFX.
+ *
+ * The output is bit-identical to the setTextSize()/setCursor()/print() sequence
+ * this replaces (white text on a transparent background, text wrap on): pixels
+ * are only ever set, so the caller clears the buffer first.
+ *
+ * @param buffer Frame buffer of ROW_BUFFER_WIDTH * ROW_BUFFER_HEIGHT / 8 bytes
+ * @param y Top of the row in pixels (rows sit at 0, 24 and 48)
+ * @param dep Departure to draw
+ */
+void renderDepartureRow(uint8_t* buffer, int y, const Departure* dep);
+
+/**
+ * Top of row slot in pixels: 0, 24 or 48.
+ */
+int departureRowY(int slot);
+
+/**
+ * Whether two departures draw the same row. Only what the row shows is
+ * compared (real time, delay, countdown); direction is not drawn.
+ */
+bool departureRowEquals(const Departure* a, const Departure* b);
+
+/**
+ * What the frame buffer's row slots currently show, so that a refresh can
+ * redraw only the rows that changed. count < 0 means the buffer holds
+ * something else (spinner, message) and must be redrawn whole.
+ */
+typedef struct {
+  Departure rows[ROW_SLOTS];
+  int count;
+} RowCache;
+
+/**
+ * Forget what the buffer shows; the next updateDepartureRows() clears the
+ * buffer and draws every row.
+ */
+void rowCacheInvalidate(RowCache* cache);
+
+/**
+ * Bring the buffer up to date with rows[0..count) (at most ROW_SLOTS are
+ * used): row slots whose content changed are cleared and redrawn, the others
+ * are left alone.
+ *
+ * @param buffer Frame buffer as for renderDepartureRow
+ * @param cache What buffer shows; updated to rows
+ * @param rows Departures for slots 0, 1, 2, already filtered
+ * @param count Number of rows; slots past it are left blank
+ * @return Bit mask of redrawn slots (bit n = slot n); 0 if the buffer is unchanged
+ */
+uint8_t updateDepartureRows(uint8_t* buffer, RowCache* cache, const Departure* rows, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ROW_RENDERER_H
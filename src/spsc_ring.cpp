@@ -0,0 +1,73 @@
+#include "spsc_ring.h"
+
+#include <string.h>
+
+ByteRing::ByteRing(uint8_t* storage, size_t capacity)
+    : _storage(storage), _capacity(capacity), _mask(capacity - 1), _head(0), _tail(0), _closed(false),
+      _cancelled(false) {}
+
+void ByteRing::reset() {
+  _head.store(0, std::memory_order_relaxed);
+  _tail.store(0, std::memory_order_relaxed);
+  _closed.store(false, std::memory_order_relaxed);
+  _cancelled.store(false, std::memory_order_release);
+}
+
+size_t ByteRing::writableSpan(uint8_t** span) {
+  size_t head = _head.load(std::memory_order_relaxed);
+  size_t tail = _tail.load(std::memory_order_acquire);
+  size_t free = _capacity - (head - tail);
+  size_t index = head & _mask;
+  size_t toEnd = _capacity - index;
+  *span = _storage + index;
+  return (free < toEnd) ? free : toEnd;
+}
+
+void ByteRing::commitWrite(size_t n) {
+  // Release: the bytes written into the span are visible before the new head.
+  _head.store(_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+size_t ByteRing::write(const uint8_t* data, size_t len) {
+  size_t written = 0;
+  // At most two spans: up to the wrap point, then from the start.
+  for (int pass = 0; pass < 2 && written < len; pass++) {
+    uint8_t* span;
+    size_t room = writableSpan(&span);
+    if (room == 0) break;
+    size_t n = (len - written < room) ? len - written : room;
+    memcpy(span, data + written, n);
+    commitWrite(n);
+    written += n;
+  }
+  return written;
+}
+
+size_t ByteRing::readableSpan(const uint8_t** span) {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  size_t head = _head.load(std::memory_order_acquire);
+  size_t available = head - tail;
+  size_t index = tail & _mask;
+  size_t toEnd = _capacity - index;
+  *span = _storage + index;
+  return (available < toEnd) ? available : toEnd;
+}
+
+void ByteRing::commitRead(size_t n) {
+  // Release: the bytes are fully consumed before the producer may reuse them.
+  _tail.store(_tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+size_t ByteRing::read(uint8_t* out, size_t len) {
+  size_t done = 0;
+  for (int pass = 0; pass < 2 && done < len; pass++) {
+    const uint8_t* span;
+    size_t available = readableSpan(&span);
+    if (available == 0) break;
+    size_t n = (len - done < available) ? len - done : available;
+    memcpy(out + done, span, n);
+    commitRead(n);
+    done += n;
+  }
+  return done;
+}
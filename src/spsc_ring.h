@@ -0,0 +1,90 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/**
+ * Lock-free single-producer/single-consumer byte ring.
+ *
+ * Exactly one thread/task may call the producer methods (writableSpan,
+ * commitWrite, write, close) and exactly one the consumer methods
+ * (readableSpan, commitRead, read, cancel). Head and tail are free-running
+ * counters published with release/acquire ordering, so neither side ever
+ * takes a lock and a full ring never blocks the other side.
+ *
+ * Storage is supplied by the owner (see StaticByteRing); its size must be a
+ * power of two so indices wrap with a mask.
+ */
+class ByteRing {
+ public:
+  ByteRing(uint8_t* storage, size_t capacity);
+
+  /** Capacity in bytes. */
+  size_t capacity() const { return _capacity; }
+
+  /** Forget all content and flags. Only while neither side is active. */
+  void reset();
+
+  // --- Producer side ---
+
+  /**
+   * Contiguous free space the producer may fill in place (e.g. straight from
+   * a socket read). May be shorter than the total free space at the wrap point.
+   */
+  size_t writableSpan(uint8_t** span);
+
+  /** Publish n bytes written into the span from writableSpan(). */
+  void commitWrite(size_t n);
+
+  /** Copy up to len bytes in; returns how many fit. */
+  size_t write(const uint8_t* data, size_t len);
+
+  /** Mark the end of input. Bytes already written stay readable. */
+  void close() { _closed.store(true, std::memory_order_release); }
+
+  /** True once the consumer has stopped reading. */
+  bool cancelled() const { return _cancelled.load(std::memory_order_acquire); }
+
+  // --- Consumer side ---
+
+  /** Contiguous readable bytes, up to the wrap point. */
+  size_t readableSpan(const uint8_t** span);
+
+  /** Release n bytes obtained from readableSpan(). */
+  void commitRead(size_t n);
+
+  /** Copy up to len bytes out; returns how many were available. */
+  size_t read(uint8_t* out, size_t len);
+
+  /** True once the producer has called close(). */
+  bool closed() const { return _closed.load(std::memory_order_acquire); }
+
+  /** Tell the producer no more bytes will be read. */
+  void cancel() { _cancelled.store(true, std::memory_order_release); }
+
+ private:
+  uint8_t* _storage;
+  size_t _capacity;
+  size_t _mask;
+  std::atomic<size_t> _head;  // total bytes written; producer-owned
+  std::atomic<size_t> _tail;  // total bytes read; consumer-owned
+  std::atomic<bool> _closed;
+  std::atomic<bool> _cancelled;
+};
+
+/** ByteRing with its storage inline, sized at compile time. */
+template <size_t N>
+class StaticByteRing : public ByteRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "ring capacity must be a power of two");
+
+ public:
+  StaticByteRing() : ByteRing(_buffer, N) {}
+
+ private:
+  uint8_t _buffer[N];
+};
+
+#endif  // SPSC_RING_H
@@ -0,0 +1,66 @@
+#include "task_profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void taskProfilerInit(TaskProfiler* profiler) { memset(profiler, 0, sizeof(*profiler)); }
+
+static TaskProfile* profileAt(TaskProfiler* profiler, int slot) {
+  return (slot >= 0 && slot < profiler->count) ? &profiler->tasks[slot] : NULL;
+}
+
+static const TaskProfile* profileAt(const TaskProfiler* profiler, int slot) {
+  return (slot >= 0 && slot < profiler->count) ? &profiler->tasks[slot] : NULL;
+}
+
+int taskProfilerRegister(TaskProfiler* profiler, const char* name, uint32_t stackBytes) {
+  for (int i = 0; i < profiler->count; i++) {
+    if (strcmp(profiler->tasks[i].name, name) == 0) return i;
+  }
+  if (profiler->count >= PROFILER_MAX_TASKS) return -1;
+
+  TaskProfile* task = &profiler->tasks[profiler->count];
+  memset(task, 0, sizeof(*task));
+  task->name = name;
+  task->stackBytes = stackBytes;
+  task->minFreeBytes = stackBytes;
+  task->peakPhase = PHASE_BOOT;
+  return profiler->count++;
+}
+
+void taskProfilerSampleStack(TaskProfiler* profiler, int slot, BootPhase phase, uint32_t freeBytes) {
+  TaskProfile* task = profileAt(profiler, slot);
+  if (task == NULL || (int)phase < 0 || (int)phase >= PHASE_COUNT) return;
+
+  // Several samples in one phase (e.g. per spinner frame): keep the lowest.
+  uint32_t* phaseFree = &task->phaseFreeBytes[phase];
+  if (*phaseFree == 0 || freeBytes < *phaseFree) *phaseFree = freeBytes;
+
+  if (freeBytes < task->minFreeBytes) {
+    task->minFreeBytes = freeBytes;
+    task->peakPhase = phase;
+  }
+}
+
+void taskProfilerAddCpu(TaskProfiler* profiler, int slot, uint32_t us) {
+  TaskProfile* task = profileAt(profiler, slot);
+  if (task != NULL) task->cpuUs += us;
+}
+
+uint32_t taskProfilerPeakBytes(const TaskProfiler* profiler, int slot) {
+  const TaskProfile* task = profileAt(profiler, slot);
+  return (task != NULL) ? task->stackBytes - task->minFreeBytes : 0;
+}
+
+size_t taskProfilerFormat(const TaskProfiler* profiler, int slot, char* buffer, size_t capacity) {
+  const TaskProfile* task = profileAt(profiler, slot);
+  if (task == NULL || buffer == NULL || capacity == 0) return 0;
+
+  uint32_t peak = task->stackBytes - task->minFreeBytes;
+  unsigned percent = task->stackBytes ? (unsigned)((uint64_t)peak * 100 / task->stackBytes) : 0;
+  int n = snprintf(buffer, capacity, "%-8s stack %5lu  peak %5lu (%u%%) in %-12s cpu %lu ms", task->name,
+                   (unsigned long)task->stackBytes, (unsigned long)peak, percent, bootPhaseName(task->peakPhase),
+                   (unsigned long)(task->cpuUs / 1000));
+  if (n < 0) return 0;
+  return ((size_t)n < capacity) ? (size_t)n : capacity - 1;
+}
@@ -0,0 +1,90 @@
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "power_governor.h"
+
+#define PROFILER_MAX_TASKS 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Stack and CPU budget of one FreeRTOS task over a wake cycle.
+ *
+ * Stack figures come from uxTaskGetStackHighWaterMark(), which on the ESP32
+ * reports the fewest bytes that have ever been free on the task's stack. The
+ * mark only ever falls, so sampling it at the end of each phase shows in which
+ * phase the peak was reached.
+ */
+typedef struct {
+  const char* name;                      // task name as shown in the report
+  uint32_t stackBytes;                   // stack size the task was created with
+  uint32_t minFreeBytes;                 // lowest high-water mark seen so far
+  BootPhase peakPhase;                   // phase in which minFreeBytes was first seen
+  uint32_t phaseFreeBytes[PHASE_COUNT];  // high-water mark at the end of each phase; 0 = not sampled
+  uint64_t cpuUs;                        // busy time reported by the task itself
+} TaskProfile;
+
+/**
+ * Profiles of every registered task. Each task writes only its own slot, so
+ * tasks may sample concurrently once registration is done.
+ */
+typedef struct {
+  TaskProfile tasks[PROFILER_MAX_TASKS];
+  int count;
+} TaskProfiler;
+
+/**
+ * Reset the profiler.
+ */
+void taskProfilerInit(TaskProfiler* profiler);
+
+/**
+ * Add a task, or find it again if a task with the same name is registered.
+ * Register before the task starts, since slots must not move while tasks run.
+ *
+ * @param profiler Profiler state
+ * @param name Task name (string literal; not copied)
+ * @param stackBytes Stack size the task is created with
+ * @return Slot to pass to the other calls, or -1 if the table is full
+ */
+int taskProfilerRegister(TaskProfiler* profiler, const char* name, uint32_t stackBytes);
+
+/**
+ * Record a stack high-water mark taken during phase.
+ *
+ * @param profiler Profiler state
+ * @param slot Slot from taskProfilerRegister (out of range is ignored)
+ * @param phase Phase the sample belongs to
+ * @param freeBytes uxTaskGetStackHighWaterMark() of the task
+ */
+void taskProfilerSampleStack(TaskProfiler* profiler, int slot, BootPhase phase, uint32_t freeBytes);
+
+/**
+ * Add busy time measured by the task around its own work.
+ */
+void taskProfilerAddCpu(TaskProfiler* profiler, int slot, uint32_t us);
+
+/**
+ * Peak stack use of a task in bytes (stackBytes - minFreeBytes), or 0 if it
+ * was never sampled.
+ */
+uint32_t taskProfilerPeakBytes(const TaskProfiler* profiler, int slot);
+
+/**
+ * Format one report line for a task, e.g.
+ * "loop     stack  8192  peak  3180 (38%) in receive      cpu 212 ms".
+ *
+ * @return Characters written (excluding the NUL), 0 if slot is invalid
+ */
+size_t taskProfilerFormat(const TaskProfiler* profiler, int slot, char* buffer, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TASK_PROFILER_H
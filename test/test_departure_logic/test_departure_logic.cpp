@@ -0,0 +1,1178 @@
+#include <unity.h>
+#include "../../src/departure_logic.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Tests for matchesDirectionFilter
+// ============================================================================
+
+void test_matchesDirectionFilter_empty_filter_matches_all(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Hauptbahnhof", ""));
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Any Direction", ""));
+}
+
+void test_matchesDirectionFilter_null_filter_matches_all(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Hauptbahnhof", NULL));
+}
+
+void test_matchesDirectionFilter_exact_match(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Alpha", "Alpha"));
+}
+
+void test_matchesDirectionFilter_partial_match(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Test City Alpha", "Alpha"));
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Alpha Street", "Alpha"));
+}
+
+void test_matchesDirectionFilter_no_match(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Beta", "Alpha"));
+}
+
+void test_matchesDirectionFilter_multiple_keywords_first_matches(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Alpha", "Alpha,Gamma"));
+}
+
+void test_matchesDirectionFilter_multiple_keywords_second_matches(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Gamma", "Alpha,Gamma"));
+}
+
+void test_matchesDirectionFilter_multiple_keywords_none_match(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Beta", "Alpha,Gamma"));
+}
+
+void test_matchesDirectionFilter_keywords_with_spaces(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Alpha", " Alpha , Gamma "));
+}
+
+void test_matchesDirectionFilter_null_direction(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter(NULL, "Alpha"));
+}
+
+void test_matchesDirectionFilter_case_sensitive(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter("alpha", "Alpha"));
+}
+
+void test_matchesDirectionFilter_trailing_comma(void) {
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Alpha", "Alpha,"));
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Gamma", "Alpha,Gamma,"));
+}
+
+void test_matchesDirectionFilter_only_commas(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Alpha", ","));
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Alpha", ",,"));
+}
+
+void test_matchesDirectionFilter_whitespace_only(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Alpha", "   "));
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Alpha", " , "));
+}
+
+void test_matchesDirectionFilter_exclude_blocks_match(void) {
+    // "!Alpha" shows everything except directions containing "Alpha"
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Alpha", "!Alpha"));
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Beta", "!Alpha"));
+}
+
+void test_matchesDirectionFilter_exclude_substring(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Test City Alpha Station", "!Alpha"));
+}
+
+void test_matchesDirectionFilter_multiple_excludes(void) {
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Alpha", "!Alpha,!Gamma"));
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Gamma", "!Alpha,!Gamma"));
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Beta", "!Alpha,!Gamma"));
+}
+
+void test_matchesDirectionFilter_exclude_wins_over_include(void) {
+    // An exclusion always rejects, even if an include would otherwise match.
+    TEST_ASSERT_FALSE(matchesDirectionFilter("Alpha Beta", "Beta,!Alpha"));
+    // Include without the excluded term still matches.
+    TEST_ASSERT_TRUE(matchesDirectionFilter("Beta", "Beta,!Alpha"));
+}
+
+// ============================================================================
+// Tests for parseDeparturesJson (VAG EFA shape)
+// ============================================================================
+
+void test_parseDeparturesJson_valid_response(void) {
+    const char* json = R"({
+        "departureList": [
+            {
+                "countdown": "4",
+                "dateTime": { "year": "2026", "month": "4", "day": "15", "hour": "17", "minute": "26" },
+                "realDateTime": { "year": "2026", "month": "4", "day": "15", "hour": "17", "minute": "29" },
+                "servingLine": { "number": "99", "direction": "Alpha", "realtime": "1", "name": "Tram" }
+            },
+            {
+                "countdown": "12",
+                "dateTime": { "year": "2026", "month": "4", "day": "15", "hour": "17", "minute": "34" },
+                "servingLine": { "number": "99", "direction": "Beta", "realtime": "0", "name": "Tram" }
+            }
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 10);
+
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(2, result.count);
+
+    TEST_ASSERT_EQUAL_STRING("Alpha", result.departures[0].direction);
+    TEST_ASSERT_TRUE(result.departures[0].valid);
+    TEST_ASSERT_EQUAL_INT(17, result.departures[0].schedHour);
+    TEST_ASSERT_EQUAL_INT(26, result.departures[0].schedMinute);
+    TEST_ASSERT_EQUAL_INT(17, result.departures[0].realHour);
+    TEST_ASSERT_EQUAL_INT(29, result.departures[0].realMinute);
+    TEST_ASSERT_EQUAL_INT(3, result.departures[0].delayMin);
+    TEST_ASSERT_EQUAL_INT(4, result.departures[0].countdown);
+
+    // Second: no realDateTime -> real falls back to scheduled, delay 0
+    TEST_ASSERT_EQUAL_STRING("Beta", result.departures[1].direction);
+    TEST_ASSERT_EQUAL_INT(17, result.departures[1].schedHour);
+    TEST_ASSERT_EQUAL_INT(34, result.departures[1].schedMinute);
+    TEST_ASSERT_EQUAL_INT(17, result.departures[1].realHour);
+    TEST_ASSERT_EQUAL_INT(34, result.departures[1].realMinute);
+    TEST_ASSERT_EQUAL_INT(0, result.departures[1].delayMin);
+    TEST_ASSERT_EQUAL_INT(12, result.departures[1].countdown);
+}
+
+void test_parseDeparturesJson_midnight_wrap_delay(void) {
+    // Scheduled 23:58, real 00:03 next day -> +5 min
+    const char* json = R"({
+        "departureList": [
+            {
+                "countdown": "5",
+                "dateTime": { "hour": "23", "minute": "58" },
+                "realDateTime": { "hour": "0", "minute": "3" },
+                "servingLine": { "direction": "Alpha", "number": "99", "realtime": "1" }
+            }
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(1, result.count);
+    TEST_ASSERT_EQUAL_INT(5, result.departures[0].delayMin);
+}
+
+void test_parseDeparturesJson_empty_list(void) {
+    const char* json = R"({ "departureList": [] })";
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(0, result.count);
+}
+
+void test_parseDeparturesJson_no_departure_list_key(void) {
+    const char* json = R"({ "error": "not found" })";
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_LIST, result.error);
+}
+
+void test_parseDeparturesJson_invalid_json(void) {
+    DeparturesResult result = parseDeparturesJson("not valid json at all", 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_INVALID_JSON, result.error);
+}
+
+void test_parseDeparturesJson_null_input(void) {
+    DeparturesResult result = parseDeparturesJson(NULL, 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NULL_INPUT, result.error);
+}
+
+void test_parseDeparturesJson_success_sets_ok(void) {
+    const char* json = R"({ "departureList": [] })";
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, result.error);
+}
+
+void test_parseDeparturesJson_no_memory(void) {
+    // Build a well-formed response large enough to overflow the document pool.
+    // Each entry carries a long direction string; ~400 entries far exceeds the
+    // 16 KB pool, so deserialization must report NoMemory, not malformed JSON.
+    std::string json = "{ \"departureList\": [";
+    for (int i = 0; i < 400; i++) {
+        if (i > 0) json += ",";
+        json +=
+            "{ \"countdown\": \"5\","
+            "\"dateTime\": { \"hour\": \"17\", \"minute\": \"26\" },"
+            "\"realDateTime\": { \"hour\": \"17\", \"minute\": \"29\" },"
+            "\"servingLine\": { \"direction\": "
+            "\"Very long direction name used to inflate the payload well past the pool size\","
+            "\"number\": \"3\", \"realtime\": \"1\" } }";
+    }
+    json += "] }";
+
+    DeparturesResult result = parseDeparturesJson(json.c_str(), 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_MEMORY, result.error);
+}
+
+void test_parseDeparturesJson_max_results_limit(void) {
+    const char* json = R"({
+        "departureList": [
+            {"countdown":"2","dateTime":{"hour":"17","minute":"00"},"servingLine":{"direction":"A","number":"99","realtime":"0"}},
+            {"countdown":"4","dateTime":{"hour":"17","minute":"10"},"servingLine":{"direction":"B","number":"99","realtime":"0"}},
+            {"countdown":"6","dateTime":{"hour":"17","minute":"20"},"servingLine":{"direction":"C","number":"99","realtime":"0"}},
+            {"countdown":"8","dateTime":{"hour":"17","minute":"30"},"servingLine":{"direction":"D","number":"99","realtime":"0"}},
+            {"countdown":"10","dateTime":{"hour":"17","minute":"40"},"servingLine":{"direction":"E","number":"99","realtime":"0"}}
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 3);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(3, result.count);
+    TEST_ASSERT_EQUAL_STRING("A", result.departures[0].direction);
+    TEST_ASSERT_EQUAL_STRING("C", result.departures[2].direction);
+}
+
+void test_parseDeparturesJson_unicode_direction(void) {
+    const char* json = R"({
+        "departureList": [
+            {
+                "countdown": "3",
+                "dateTime": { "hour": "17", "minute": "26" },
+                "servingLine": { "direction": "Alpha via Delta", "number": "99", "realtime": "0" }
+            }
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_STRING("Alpha via Delta", result.departures[0].direction);
+}
+
+void test_parseDeparturesJson_long_direction_truncated(void) {
+    const char* json = R"({
+        "departureList": [
+            {
+                "countdown": "3",
+                "dateTime": { "hour": "17", "minute": "26" },
+                "servingLine": {
+                    "direction": "This is a very long direction name that exceeds the maximum allowed length for direction strings",
+                    "number": "99",
+                    "realtime": "0"
+                }
+            }
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(MAX_DIRECTION_LEN - 1, (int)strlen(result.departures[0].direction));
+}
+
+void test_parseDeparturesJson_missing_direction(void) {
+    const char* json = R"({
+        "departureList": [
+            {
+                "countdown": "3",
+                "dateTime": { "hour": "17", "minute": "26" },
+                "servingLine": { "number": "99", "realtime": "0" }
+            }
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(1, result.count);
+    TEST_ASSERT_EQUAL_STRING("", result.departures[0].direction);
+}
+
+void test_parseDeparturesJson_realtime_equals_scheduled_no_delay(void) {
+    // realDateTime == dateTime -> delay 0
+    const char* json = R"({
+        "departureList": [
+            {
+                "countdown": "7",
+                "dateTime": { "hour": "17", "minute": "26" },
+                "realDateTime": { "hour": "17", "minute": "26" },
+                "servingLine": { "direction": "Alpha", "number": "99", "realtime": "1" }
+            }
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(0, result.departures[0].delayMin);
+    TEST_ASSERT_EQUAL_INT(7, result.departures[0].countdown);
+}
+
+void test_parseDeparturesJson_realistic_efa_response(void) {
+    // Response shape mirroring real VAG EFA output, including extra fields
+    // that should be filtered out.
+    const char* json = R"({
+        "parameters": [{"name":"language","value":"de"}],
+        "dm": { "itdDateTime": { "itdDate": {"year":"2026","month":"4","day":"15"} } },
+        "departureList": [
+            {
+                "stopName": "Test City, Test Stop",
+                "stopID": "1234567",
+                "countdown": "4",
+                "dateTime": { "year":"2026","month":"4","day":"15","hour":"17","minute":"26" },
+                "realDateTime": { "year":"2026","month":"4","day":"15","hour":"17","minute":"29" },
+                "servingLine": {
+                    "key":"99","code":"99","number":"99","symbol":"99",
+                    "direction":"Test City, Alpha Street",
+                    "realtime":"1","name":"Tram"
+                }
+            },
+            {
+                "stopName": "Test City, Test Stop",
+                "countdown": "1",
+                "dateTime": { "hour":"17","minute":"30" },
+                "servingLine": { "number":"99","direction":"Test City, Beta","realtime":"0","name":"Tram" }
+            }
+        ]
+    })";
+
+    DeparturesResult result = parseDeparturesJson(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(2, result.count);
+
+    TEST_ASSERT_EQUAL_INT(4, result.departures[0].countdown);
+    TEST_ASSERT_EQUAL_INT(3, result.departures[0].delayMin);
+    TEST_ASSERT_TRUE(matchesDirectionFilter(result.departures[0].direction, "Alpha"));
+    TEST_ASSERT_FALSE(matchesDirectionFilter(result.departures[1].direction, "Alpha"));
+}
+
+// ============================================================================
+// Tests for parseDeparturesJsonIncremental
+// ============================================================================
+
+// Build an EFA-shaped response with `entries` departures, preceded by a bulky
+// servingLines member the parser has to skip. Entry i departs at 17:i%60 with
+// countdown i and direction "Dir<i>".
+static std::string buildEfaFixture(int entries) {
+    std::string json =
+        "{ \"parameters\": [{\"name\":\"language\",\"value\":\"de\"}],"
+        "\"servingLines\": { \"lines\": [";
+    for (int i = 0; i < 20; i++) {
+        if (i > 0) json += ",";
+        json += "{ \"name\": \"Line [x] {y}\", \"desc\": \"quoted \\\"]}\\\" text\" }";
+    }
+    json += "] }, \"departureList\": [";
+    for (int i = 0; i < entries; i++) {
+        char entry[512];
+        snprintf(entry, sizeof(entry),
+                 "%s{ \"stopName\": \"Test Stop\", \"countdown\": \"%d\","
+                 "\"dateTime\": { \"year\": \"2026\", \"month\": \"4\", \"day\": \"15\", \"hour\": \"17\", \"minute\": \"%d\" },"
+                 "\"realDateTime\": { \"year\": \"2026\", \"month\": \"4\", \"day\": \"15\", \"hour\": \"17\", \"minute\": \"%d\" },"
+                 "\"servingLine\": { \"key\": \"3\", \"number\": \"3\", \"direction\": \"Dir%d\", \"realtime\": \"1\", \"name\": \"Tram\" } }",
+                 i > 0 ? "," : "", i, i % 60, (i + 1) % 60, i);
+        json += entry;
+    }
+    json += "] }";
+    return json;
+}
+
+static void assertFixtureEntries(const DeparturesResult& result, int expected) {
+    TEST_ASSERT_EQUAL_INT(expected, result.count);
+    for (int i = 0; i < expected; i++) {
+        char direction[16];
+        snprintf(direction, sizeof(direction), "Dir%d", i);
+        TEST_ASSERT_EQUAL_STRING(direction, result.departures[i].direction);
+        TEST_ASSERT_TRUE(result.departures[i].valid);
+        TEST_ASSERT_EQUAL_INT(i, result.departures[i].countdown);
+        TEST_ASSERT_EQUAL_INT(i % 60, result.departures[i].schedMinute);
+    }
+}
+
+void test_parseDeparturesJsonIncremental_matches_document_parse(void) {
+    const char* json = R"({
+        "departureList": [
+            {
+                "countdown": "4",
+                "dateTime": { "year": "2026", "month": "4", "day": "15", "hour": "17", "minute": "26" },
+                "realDateTime": { "year": "2026", "month": "4", "day": "15", "hour": "17", "minute": "29" },
+                "servingLine": { "number": "99", "direction": "Alpha", "realtime": "1", "name": "Tram" }
+            },
+            {
+                "countdown": "12",
+                "dateTime": { "year": "2026", "month": "4", "day": "15", "hour": "17", "minute": "34" },
+                "servingLine": { "number": "99", "direction": "Beta", "realtime": "0", "name": "Tram" }
+            }
+        ]
+    })";
+
+    DeparturesResult expected = parseDeparturesJson(json, 10);
+    DeparturesResult result = parseDeparturesJsonIncremental(json, 10);
+
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, result.error);
+    TEST_ASSERT_EQUAL_INT(expected.count, result.count);
+    for (int i = 0; i < expected.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(expected.departures[i].direction, result.departures[i].direction);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].schedHour, result.departures[i].schedHour);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].schedMinute, result.departures[i].schedMinute);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].realHour, result.departures[i].realHour);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].realMinute, result.departures[i].realMinute);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].delayMin, result.departures[i].delayMin);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].countdown, result.departures[i].countdown);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].valid, result.departures[i].valid);
+    }
+}
+
+// Every entry of the fixture through the incremental parse, so an element
+// pool that grew with the list would show up as PARSE_ERR_NO_MEMORY.
+template <int N>
+static void assertParsesEveryEntry(const std::string& json) {
+    static DeparturesResultN<N> result;
+    parseDeparturesJsonIncremental(json.c_str(), result);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(N, result.count);
+    for (int i = 0; i < N; i++) {
+        char direction[16];
+        snprintf(direction, sizeof(direction), "Dir%d", i);
+        TEST_ASSERT_EQUAL_STRING(direction, result.departures[i].direction);
+        TEST_ASSERT_EQUAL_INT(i, result.departures[i].countdown);
+    }
+}
+
+struct ElementPeaks {
+    size_t element;
+    size_t pool;
+};
+
+// Largest trimmed element and element pool use over every entry of json.
+static ElementPeaks pushParserPeaks(const std::string& json, int entries) {
+    static Departure out[200];
+    static char element[1024];
+    TEST_ASSERT_TRUE(entries <= 200);
+    DeparturePushParser parser(out, entries, element, sizeof(element));
+    parser.feed((const uint8_t*)json.data(), json.size());
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, parser.error());
+    TEST_ASSERT_EQUAL_INT(entries, parser.count());
+    ElementPeaks peaks = {parser.elementPeak(), parser.poolPeak()};
+    return peaks;
+}
+
+void test_parseDeparturesJsonIncremental_15_entries(void) {
+    std::string json = buildEfaFixture(15);
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 10);
+    TEST_ASSERT_TRUE(result.success);
+    assertFixtureEntries(result, 10);
+    assertParsesEveryEntry<15>(json);
+}
+
+void test_parseDeparturesJsonIncremental_50_entries(void) {
+    std::string json = buildEfaFixture(50);
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 10);
+    TEST_ASSERT_TRUE(result.success);
+    assertFixtureEntries(result, 10);
+    assertParsesEveryEntry<50>(json);
+}
+
+void test_parseDeparturesJsonIncremental_200_entries(void) {
+    // The whole-document parse runs out of pool on this fixture; the
+    // incremental parse gets through it with the same per-element pool.
+    std::string json = buildEfaFixture(200);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_MEMORY, parseDeparturesJson(json.c_str(), 10).error);
+
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 10);
+    TEST_ASSERT_TRUE(result.success);
+    assertFixtureEntries(result, 10);
+    assertParsesEveryEntry<200>(json);
+}
+
+void test_parseDeparturesJsonIncremental_memory_independent_of_list_length(void) {
+    // Parsing every entry, the largest element and pool use stay those of one
+    // entry. Entries 15-49 are as wide as entry 14; from entry 100 on the
+    // countdown and direction gain a digit each, and nothing more.
+    ElementPeaks of15 = pushParserPeaks(buildEfaFixture(15), 15);
+    ElementPeaks of50 = pushParserPeaks(buildEfaFixture(50), 50);
+    ElementPeaks of200 = pushParserPeaks(buildEfaFixture(200), 200);
+    TEST_ASSERT_TRUE(of15.element > 0);
+    TEST_ASSERT_TRUE(of15.pool > 0);
+    TEST_ASSERT_EQUAL_UINT32(of15.element, of50.element);
+    TEST_ASSERT_EQUAL_UINT32(of15.pool, of50.pool);
+    TEST_ASSERT_EQUAL_UINT32(of15.element + 2, of200.element);
+    TEST_ASSERT_TRUE(of200.pool <= of15.pool + 2);
+}
+
+void test_parseDeparturesJsonIncremental_walks_whole_list(void) {
+    // Entries past maxResults are still scanned to the end of the list, so a
+    // missing separator after entry 200 is reported.
+    std::string json = buildEfaFixture(200);
+    json.insert(json.rfind(']'), ", { } { }");
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_INVALID_JSON, result.error);
+}
+
+void test_parseDeparturesJsonIncremental_oversized_element(void) {
+    // A single element larger than the per-element pool is the only way to
+    // run out of memory.
+    std::string direction(2000, 'x');
+    std::string json = "{ \"departureList\": [ { \"countdown\": \"3\","
+                       "\"dateTime\": { \"hour\": \"17\", \"minute\": \"26\" },"
+                       "\"servingLine\": { \"direction\": \"" + direction + "\" } } ] }";
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_MEMORY, result.error);
+}
+
+void test_parseDeparturesJsonIncremental_skips_tricky_preamble(void) {
+    // Brackets, braces, escaped quotes and a lookalike key inside skipped
+    // members must not confuse the scanner.
+    const char* json = R"({
+        "note": "departureList: [ { \"fake\" } ] \\",
+        "nested": { "departureList": [1, 2, 3], "deep": [[[{"a": "]"}]]] },
+        "number": -12.5e3,
+        "flag": true,
+        "departureList": [
+            { "countdown": "6", "dateTime": { "hour": "8", "minute": "5" },
+              "servingLine": { "direction": "Alpha" } }
+        ]
+    })";
+    DeparturesResult result = parseDeparturesJsonIncremental(json, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(1, result.count);
+    TEST_ASSERT_EQUAL_STRING("Alpha", result.departures[0].direction);
+    TEST_ASSERT_EQUAL_INT(8, result.departures[0].schedHour);
+    TEST_ASSERT_EQUAL_INT(5, result.departures[0].schedMinute);
+    TEST_ASSERT_EQUAL_INT(6, result.departures[0].countdown);
+}
+
+// DepartureSource over a string that offers spans of at most `span` bytes
+// (0 = no bulk access, read() only), so skipped values cross span boundaries.
+class SpanSource : public DepartureSource {
+ public:
+    SpanSource(const std::string& text, size_t span) : _text(text), _pos(0), _span(span) {}
+
+    int read() override { return (_pos < _text.size()) ? (unsigned char)_text[_pos++] : -1; }
+
+    size_t peekSpan(const uint8_t** data) override {
+        *data = (const uint8_t*)_text.data() + _pos;
+        size_t left = _text.size() - _pos;
+        return (left < _span) ? left : _span;
+    }
+
+    void consume(size_t n) override { _pos += n; }
+
+ private:
+    const std::string& _text;
+    size_t _pos;
+    size_t _span;
+};
+
+void test_parseDeparturesJsonIncremental_skip_across_spans(void) {
+    // Skipped members split at every span size, with escapes and brackets in
+    // strings landing on span boundaries, parse the same as the C string.
+    std::string json = R"({ "note": "]} \\\" {[", "lines": [ { "name": "Line [x] {y}", "desc": "\"]}\"" } ],)"
+                       R"( "departureList": [ { "countdown": "6", "dateTime": { "hour": "8", "minute": "5" },)"
+                       R"( "servingLine": { "direction": "Alpha" } }, { "skipped": "]}\"" } ] })";
+    DeparturesResult direct = parseDeparturesJsonIncremental(json.c_str(), 1);
+    TEST_ASSERT_TRUE(direct.success);
+    TEST_ASSERT_EQUAL_STRING("Alpha", direct.departures[0].direction);
+
+    for (size_t span = 0; span <= 24; span++) {
+        SpanSource source(json, span);
+        DeparturesResultN<1> result;
+        parseDeparturesJsonIncremental(source, result);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_INT(1, result.count);
+        TEST_ASSERT_EQUAL_STRING("Alpha", result.departures[0].direction);
+        TEST_ASSERT_EQUAL_INT(6, result.departures[0].countdown);
+    }
+}
+
+void test_parseDeparturesJsonIncremental_empty_list(void) {
+    DeparturesResult result = parseDeparturesJsonIncremental(R"({ "departureList": [ ] })", 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(0, result.count);
+}
+
+void test_parseDeparturesJsonIncremental_no_departure_list_key(void) {
+    DeparturesResult result = parseDeparturesJsonIncremental(R"({ "error": "not found" })", 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_LIST, result.error);
+
+    result = parseDeparturesJsonIncremental(R"({ "departureList": null })", 10);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_LIST, result.error);
+}
+
+void test_parseDeparturesJsonIncremental_invalid_json(void) {
+    DeparturesResult result = parseDeparturesJsonIncremental("not valid json at all", 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_INVALID_JSON, result.error);
+}
+
+void test_parseDeparturesJsonIncremental_null_input(void) {
+    DeparturesResult result = parseDeparturesJsonIncremental(NULL, 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NULL_INPUT, result.error);
+}
+
+void test_parseDeparturesJsonIncremental_max_results_limit(void) {
+    std::string json = buildEfaFixture(5);
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 3);
+    TEST_ASSERT_TRUE(result.success);
+    assertFixtureEntries(result, 3);
+}
+
+// ============================================================================
+// Tests for partial results from truncated input
+// ============================================================================
+
+// Cut `json` after every byte and check each prefix: before departureList's
+// '[' nothing is salvageable, after the closing ']' the parse is complete, and
+// in between the result is PARSE_PARTIAL holding exactly the entries whose
+// closing brace made it into the prefix (capped at the result capacity).
+template <int N>
+static void assertTruncationAtEveryOffset(const std::string& json, int entries) {
+    const char* listKey = "\"departureList\": [";
+    size_t listStart = json.find(listKey) + strlen(listKey);
+    size_t listEnd = json.rfind(']');
+    std::vector<size_t> entryEnds;
+    for (size_t pos = listStart; (pos = json.find("\"Tram\" } }", pos)) != std::string::npos;) {
+        pos += strlen("\"Tram\" } }");
+        entryEnds.push_back(pos);
+    }
+    TEST_ASSERT_EQUAL_INT(entries, entryEnds.size());
+
+    static DeparturesResultN<N> result;
+    for (size_t length = 0; length <= json.size(); length++) {
+        std::string prefix = json.substr(0, length);
+        parseDeparturesJsonIncremental(prefix.c_str(), result);
+
+        int complete = 0;
+        while (complete < entries && entryEnds[complete] <= length) complete++;
+        int expectedCount = (complete < N) ? complete : N;
+
+        if (length < listStart) {
+            TEST_ASSERT_EQUAL_INT(PARSE_ERR_INVALID_JSON, result.error);
+            TEST_ASSERT_EQUAL_INT(0, result.count);
+        } else if (length > listEnd) {
+            TEST_ASSERT_EQUAL_INT(PARSE_OK, result.error);
+            TEST_ASSERT_EQUAL_INT(expectedCount, result.count);
+        } else {
+            TEST_ASSERT_EQUAL_INT(PARSE_PARTIAL, result.error);
+            TEST_ASSERT_FALSE(result.success);
+            TEST_ASSERT_EQUAL_INT(expectedCount, result.count);
+        }
+        for (int i = 0; i < result.count; i++) {
+            char direction[16];
+            snprintf(direction, sizeof(direction), "Dir%d", i);
+            TEST_ASSERT_EQUAL_STRING(direction, result.departures[i].direction);
+            TEST_ASSERT_EQUAL_INT(i, result.departures[i].countdown);
+            TEST_ASSERT_EQUAL_INT((i + 1) % 60, result.departures[i].realMinute);
+        }
+    }
+}
+
+void test_parseDeparturesJsonIncremental_truncated_at_every_offset(void) {
+    assertTruncationAtEveryOffset<16>(buildEfaFixture(6), 6);
+}
+
+void test_parseDeparturesJsonIncremental_truncated_past_capacity(void) {
+    // Truncation inside the skipped tail still reports the filled entries.
+    assertTruncationAtEveryOffset<3>(buildEfaFixture(6), 6);
+}
+
+void test_parseDeparturesJsonIncremental_partial_c_abi(void) {
+    std::string json = buildEfaFixture(5);
+    json.resize(json.find("Dir3"));
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 10);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_PARTIAL, result.error);
+    assertFixtureEntries(result, 3);
+}
+
+void test_parseDeparturesJsonIncremental_garbage_is_not_partial(void) {
+    // Malformed input inside the list stays an error, not a partial result.
+    std::string json = buildEfaFixture(5);
+    json.resize(json.find("Dir3"));
+    json += "\" } } } ]";
+    DeparturesResult result = parseDeparturesJsonIncremental(json.c_str(), 10);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_INVALID_JSON, result.error);
+}
+
+// ============================================================================
+// Tests for DeparturePushParser
+// ============================================================================
+
+// Push `json` in pieces of `piece` bytes (then finish()) and check the
+// outcome against the pull parser on the same input.
+static void assertPushMatchesPull(const std::string& json, size_t piece, int maxResults) {
+    static Departure pushed[16];
+    static char element[1024];
+    DeparturePushParser parser(pushed, maxResults, element, sizeof(element));
+    for (size_t pos = 0; pos < json.size() && !parser.finished(); pos += piece) {
+        size_t n = std::min(piece, json.size() - pos);
+        size_t used = parser.feed((const uint8_t*)json.data() + pos, n);
+        TEST_ASSERT_TRUE(used == n || parser.finished());
+    }
+    parser.finish();
+
+    DeparturesResult pulled = parseDeparturesJsonIncremental(json.c_str(), maxResults);
+    TEST_ASSERT_EQUAL_INT(pulled.error, parser.error());
+    TEST_ASSERT_EQUAL_INT(pulled.count, parser.count());
+    for (int i = 0; i < pulled.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(pulled.departures[i].direction, pushed[i].direction);
+        TEST_ASSERT_EQUAL_INT(pulled.departures[i].countdown, pushed[i].countdown);
+        TEST_ASSERT_EQUAL_INT(pulled.departures[i].delayMin, pushed[i].delayMin);
+        TEST_ASSERT_EQUAL_INT(pulled.departures[i].valid, pushed[i].valid);
+    }
+}
+
+void test_DeparturePushParser_matches_pull_parser(void) {
+    const std::string inputs[] = {
+        buildEfaFixture(12),
+        R"({ "note": "departureList: [ \"]", "nested": { "departureList": [1] }, "n": -1.5e3, "t": true,)"
+        R"( "departureList": [ { "countdown": "6", "dateTime": { "hour": "8", "minute": "5" },)"
+        R"( "servingLine": { "direction": "Alpha" } }, "s" ] })",
+        R"({ "departureList": [ ] })",
+        R"({ "departureList": null })",
+        R"({ "other": [] })",
+        R"({})",
+        R"({ "departureList": [ {}, ] })",
+        R"({ "departureList": [ { "countdown": } ] })",
+        R"([ "departureList" ])",
+        R"({ "departureList": [ {} {} ] })",
+        // Cut off inside an element that is already malformed, or a scalar
+        // that is complete at the cut.
+        R"({ "departureList": [ {}, { "countdown": "1" "x": {)",
+        R"({ "departureList": [ {}, { "servingLine": { "direction": "A" }, : )",
+        R"({ "departureList": [ {}, 42)",
+        // Members the element trimmer drops, keeps or cannot classify.
+        R"({ "departureList": [ { "count\u0064own": "7", "x": [1, {"y": "]"}], "dateTime": "17:05",)"
+        R"( "servingLine": { "junk": {"a": [1, 2]}, "direction": "B", "n": 4, "number": "4" } } ] })",
+        R"({ "departureList": [ { "x": 12, "y": true, "z": null, "countdown": "3" } ] })",
+        R"({ "departureList": [ { "x": [1,, 2], "countdown": "3" } ] })",
+        R"({ "departureList": [ { "x": , "countdown": "3" } ] })",
+        R"({ "departureList": [ { "x" 1, "countdown": "3" } ] })",
+        // A kept string close to the element pool size: both parsers copy it
+        // into the pool, so both run out of memory on it (or neither does).
+        R"({ "departureList": [ { "countdown": "1", "servingLine": { "direction": ")" + std::string(900, 'd') +
+            R"(" } } ] })",
+    };
+    for (const std::string& json : inputs) {
+        for (size_t piece = 1; piece <= 40; piece++) {
+            assertPushMatchesPull(json, piece, 10);
+            assertPushMatchesPull(json, piece, 2);
+        }
+        assertPushMatchesPull(json, json.size(), 10);
+    }
+}
+
+void test_DeparturePushParser_truncated_at_every_offset(void) {
+    std::string json = buildEfaFixture(6);
+    for (size_t length = 0; length <= json.size(); length++) {
+        assertPushMatchesPull(json.substr(0, length), 7, 4);
+    }
+}
+
+void test_DeparturePushParser_element_buffer_limits(void) {
+    std::string json = buildEfaFixture(3);
+    Departure out[3];
+
+    // An element that does not fit the buffer fails like the pool running out.
+    char small[64];
+    DeparturePushParser parser(out, 3, small, sizeof(small));
+    parser.feed((const uint8_t*)json.data(), json.size());
+    TEST_ASSERT_TRUE(parser.finished());
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_MEMORY, parser.error());
+
+    // Elements past maxResults are not copied, so their size does not matter.
+    std::string huge = "{ \"departureList\": [ { \"countdown\": \"5\", \"dateTime\": { \"hour\": \"1\" } }, { \"x\": \"" +
+                       std::string(5000, 'x') + "\" } ] }";
+    char buffer[128];
+    DeparturePushParser oneEntry(out, 1, buffer, sizeof(buffer));
+    oneEntry.feed((const uint8_t*)huge.data(), huge.size());
+    TEST_ASSERT_TRUE(oneEntry.finished());
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, oneEntry.error());
+    TEST_ASSERT_EQUAL_INT(1, oneEntry.count());
+    TEST_ASSERT_EQUAL_INT(5, out[0].countdown);
+}
+
+void test_DeparturePushParser_drops_unwanted_members(void) {
+    // An element far larger than the buffer parses as long as the members the
+    // filter keeps fit: line info and long texts are dropped while copying.
+    std::string json = R"({ "departureList": [ { "countdown": "4", "lineInfos": { "infoText": ")" +
+                       std::string(5000, 'i') + R"(" }, "dateTime": { "hour": "17", "minute": "26", "text": ")" +
+                       std::string(1000, 't') + R"(" }, "servingLine": { "name": ")" + std::string(2000, 'n') +
+                       R"(", "direction": "Alpha", "number": "3" } } ] })";
+    Departure out[1];
+    char buffer[256];
+    DeparturePushParser parser(out, 1, buffer, sizeof(buffer));
+    for (size_t pos = 0; pos < json.size(); pos += 100) {
+        parser.feed((const uint8_t*)json.data() + pos, std::min((size_t)100, json.size() - pos));
+    }
+    TEST_ASSERT_TRUE(parser.finished());
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, parser.error());
+    TEST_ASSERT_EQUAL_INT(1, parser.count());
+    TEST_ASSERT_EQUAL_STRING("Alpha", out[0].direction);
+    TEST_ASSERT_EQUAL_INT(4, out[0].countdown);
+    TEST_ASSERT_EQUAL_INT(26, out[0].schedMinute);
+    TEST_ASSERT_TRUE(parser.elementPeak() < 200);
+    assertPushMatchesPull(json, 37, 1);
+}
+
+void test_DeparturePushParser_stops_consuming_when_done(void) {
+    std::string json = R"({ "departureList": [] } trailing bytes)";
+    Departure out[1];
+    char buffer[64];
+    DeparturePushParser parser(out, 1, buffer, sizeof(buffer));
+    size_t used = parser.feed((const uint8_t*)json.data(), json.size());
+    TEST_ASSERT_TRUE(parser.finished());
+    TEST_ASSERT_EQUAL_INT(json.find(']') + 1, used);
+
+    parser.reset();
+    TEST_ASSERT_FALSE(parser.finished());
+    TEST_ASSERT_EQUAL_INT(0, parser.count());
+}
+
+// What onDeparture reported, and after how many fed bytes.
+struct Emissions {
+    size_t fed;
+    std::vector<int> indices;
+    std::vector<size_t> atByte;
+    std::vector<std::string> directions;
+};
+
+static void recordEmission(void* context, const Departure* departure, int index) {
+    Emissions* emissions = (Emissions*)context;
+    emissions->indices.push_back(index);
+    emissions->atByte.push_back(emissions->fed);
+    emissions->directions.push_back(departure->direction);
+}
+
+void test_DeparturePushParser_emits_each_departure_when_its_element_closes(void) {
+    std::string json = buildEfaFixture(6);
+    Departure out[4];
+    char buffer[1024];
+    DeparturePushParser parser(out, 4, buffer, sizeof(buffer));
+    Emissions emissions = {0, {}, {}, {}};
+    parser.onDeparture(recordEmission, &emissions);
+
+    // One byte at a time: each departure is reported by the feed() of the
+    // element's closing brace, not later.
+    for (size_t pos = 0; pos < json.size() && !parser.finished(); pos++) {
+        emissions.fed = pos + 1;
+        parser.feed((const uint8_t*)json.data() + pos, 1);
+    }
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, parser.error());
+    TEST_ASSERT_EQUAL_INT(4, emissions.indices.size());  // maxResults caps what is reported
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(i, emissions.indices[i]);
+        TEST_ASSERT_EQUAL_STRING(out[i].direction, emissions.directions[i].c_str());
+        size_t at = emissions.atByte[i];
+        TEST_ASSERT_EQUAL_INT('}', json[at - 1]);
+        size_t next = json.find_first_not_of(" \n\t", at);
+        TEST_ASSERT_TRUE(json[next] == ',' || json[next] == ']');
+    }
+
+    // A second response for the same list reports only the entries past the
+    // ones kept.
+    emissions = {json.size(), {}, {}, {}};
+    parser.reset(2);
+    parser.feed((const uint8_t*)json.data(), json.size());
+    TEST_ASSERT_EQUAL_INT(2, emissions.indices.size());
+    TEST_ASSERT_EQUAL_INT(2, emissions.indices[0]);
+    TEST_ASSERT_EQUAL_INT(3, emissions.indices[1]);
+}
+
+static const char kKeptList[] = R"({ "departureList": [ { "countdown": "3", "servingLine": { "direction": "A" } },)"
+                               R"( { "countdown": "4", "servingLine": { "direction": "B" } } ] })";
+
+void test_DeparturePushParser_reset_keeps_leading_entries(void) {
+    // A second response for the same list: its first two elements repeat
+    // the entries already in out[0..2), which only take the new countdowns.
+    Departure out[4];
+    char buffer[512];
+    DeparturePushParser parser(out, 4, buffer, sizeof(buffer));
+    std::string first = kKeptList;
+    parser.feed((const uint8_t*)first.data(), first.size());
+    TEST_ASSERT_EQUAL_INT(2, parser.count());
+
+    parser.reset(2);
+    TEST_ASSERT_EQUAL_INT(2, parser.count());
+    std::string second = R"({ "departureList": [ { "countdown": "2", "servingLine": { "direction": "A" } },)"
+                         R"( { "countdown": "3", "servingLine": { "direction": "B" } },)"
+                         R"( { "countdown": "5", "servingLine": { "direction": "C" } },)"
+                         R"( { "countdown": "6", "servingLine": { "direction": "D" } },)"
+                         R"( { "countdown": "7", "servingLine": { "direction": "E" } } ] })";
+    parser.feed((const uint8_t*)second.data(), second.size());
+    TEST_ASSERT_TRUE(parser.finished());
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, parser.error());
+    TEST_ASSERT_EQUAL_INT(4, parser.count());
+    TEST_ASSERT_EQUAL_STRING("A", out[0].direction);
+    TEST_ASSERT_EQUAL_INT(2, out[0].countdown);
+    TEST_ASSERT_EQUAL_STRING("B", out[1].direction);
+    TEST_ASSERT_EQUAL_STRING("C", out[2].direction);
+    TEST_ASSERT_EQUAL_STRING("D", out[3].direction);
+}
+
+struct Reported {
+    std::vector<int> indices;
+    std::vector<std::string> directions;
+};
+
+static void recordReported(void* context, const Departure* departure, int index) {
+    Reported* reported = (Reported*)context;
+    reported->indices.push_back(index);
+    reported->directions.push_back(departure->direction);
+}
+
+void test_DeparturePushParser_reset_detects_shifted_list(void) {
+    // Between the two responses the board moved on: a departure was inserted
+    // at the top, or the first one left. The kept entries no longer line up,
+    // so the list is extracted and reported again from the first difference.
+    const struct {
+        const char* second;
+        int count;
+        const char* directions;  // out[0..count), one letter each
+        int firstReported;
+    } cases[] = {
+        {R"({ "departureList": [ { "countdown": "1", "servingLine": { "direction": "X" } },)"
+         R"( { "countdown": "3", "servingLine": { "direction": "A" } },)"
+         R"( { "countdown": "4", "servingLine": { "direction": "B" } },)"
+         R"( { "countdown": "5", "servingLine": { "direction": "C" } } ] })",
+         4, "XABC", 0},
+        {R"({ "departureList": [ { "countdown": "4", "servingLine": { "direction": "B" } },)"
+         R"( { "countdown": "5", "servingLine": { "direction": "C" } },)"
+         R"( { "countdown": "6", "servingLine": { "direction": "D" } } ] })",
+         3, "BCD", 0},
+        {R"({ "departureList": [ { "countdown": "3", "servingLine": { "direction": "A" } },)"
+         R"( { "countdown": "6", "servingLine": { "direction": "D" } },)"
+         R"( { "countdown": "7", "servingLine": { "direction": "E" } } ] })",
+         3, "ADE", 1},
+        // Shorter than what was kept: only what the new list still has.
+        {R"({ "departureList": [ { "countdown": "3", "servingLine": { "direction": "A" } } ] })", 1, "A", -1},
+        {R"({ "departureList": [ ] })", 0, "", -1},
+    };
+    for (const auto& c : cases) {
+        Departure out[4];
+        char buffer[512];
+        DeparturePushParser parser(out, 4, buffer, sizeof(buffer));
+        std::string first = kKeptList;
+        parser.feed((const uint8_t*)first.data(), first.size());
+
+        Reported reported;
+        parser.onDeparture(recordReported, &reported);
+        parser.reset(2);
+        std::string second = c.second;
+        for (size_t pos = 0; pos < second.size(); pos += 5) {
+            parser.feed((const uint8_t*)second.data() + pos, std::min((size_t)5, second.size() - pos));
+        }
+        TEST_ASSERT_EQUAL_INT(PARSE_OK, parser.error());
+        TEST_ASSERT_EQUAL_INT(c.count, parser.count());
+        for (int i = 0; i < c.count; i++) {
+            const char expected[2] = {c.directions[i], '\0'};
+            TEST_ASSERT_EQUAL_STRING(expected, out[i].direction);
+        }
+        if (c.firstReported < 0) {
+            TEST_ASSERT_EQUAL_INT(0, reported.indices.size());
+        } else {
+            TEST_ASSERT_EQUAL_INT(c.count - c.firstReported, reported.indices.size());
+            TEST_ASSERT_EQUAL_INT(c.firstReported, reported.indices[0]);
+            const char expected[2] = {c.directions[c.firstReported], '\0'};
+            TEST_ASSERT_EQUAL_STRING(expected, reported.directions[0].c_str());
+        }
+    }
+}
+
+// ============================================================================
+// Tests for isDisplayableDeparture / countDisplayableDepartures
+// ============================================================================
+
+static Departure makeDeparture(const char* direction, int countdown, bool valid) {
+    Departure dep = {};
+    strncpy(dep.direction, direction, MAX_DIRECTION_LEN - 1);
+    dep.countdown = countdown;
+    dep.valid = valid;
+    return dep;
+}
+
+void test_isDisplayableDeparture(void) {
+    Departure dep = makeDeparture("Alpha", MIN_COUNTDOWN_MIN, true);
+    TEST_ASSERT_TRUE(isDisplayableDeparture(&dep, ""));
+    TEST_ASSERT_TRUE(isDisplayableDeparture(&dep, "Alpha"));
+    TEST_ASSERT_FALSE(isDisplayableDeparture(&dep, "Beta"));
+    TEST_ASSERT_FALSE(isDisplayableDeparture(&dep, "!Alpha"));
+
+    dep.countdown = MIN_COUNTDOWN_MIN - 1;
+    TEST_ASSERT_FALSE(isDisplayableDeparture(&dep, ""));
+
+    dep = makeDeparture("Alpha", 10, false);
+    TEST_ASSERT_FALSE(isDisplayableDeparture(&dep, ""));
+    TEST_ASSERT_FALSE(isDisplayableDeparture(NULL, ""));
+}
+
+void test_countDisplayableDepartures(void) {
+    Departure deps[5] = {
+        makeDeparture("Alpha", 1, true),   // too soon
+        makeDeparture("Alpha", 4, true),
+        makeDeparture("Beta", 6, true),    // filtered out
+        makeDeparture("Alpha", 9, false),  // invalid
+        makeDeparture("Alpha", 12, true),
+    };
+    TEST_ASSERT_EQUAL_INT(2, countDisplayableDepartures(deps, 5, "Alpha"));
+    TEST_ASSERT_EQUAL_INT(3, countDisplayableDepartures(deps, 5, ""));
+    TEST_ASSERT_EQUAL_INT(1, countDisplayableDepartures(deps, 2, ""));
+    TEST_ASSERT_EQUAL_INT(0, countDisplayableDepartures(deps, 0, ""));
+}
+
+// ============================================================================
+// Tests for the capacity-templated DeparturesResultN API
+// ============================================================================
+
+void test_DeparturesResultN_fills_to_capacity(void) {
+    // The result capacity, not MAX_DEPARTURES, bounds the parse.
+    std::string json = buildEfaFixture(15);
+    static DeparturesResultN<15> result;
+    parseDeparturesJsonIncremental(json.c_str(), result);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, result.error);
+    TEST_ASSERT_EQUAL_INT(15, DeparturesResultN<15>::kCapacity);
+    TEST_ASSERT_EQUAL_INT(15, result.count);
+    TEST_ASSERT_EQUAL_STRING("Dir14", result.departures[14].direction);
+}
+
+void test_DeparturesResultN_small_capacity(void) {
+    std::string json = buildEfaFixture(15);
+    DeparturesResultN<3> result;
+    parseDeparturesJson(json.c_str(), result);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(3, result.count);
+    TEST_ASSERT_EQUAL_STRING("Dir2", result.departures[2].direction);
+}
+
+void test_DeparturesResultN_200_entries_with_element_pool(void) {
+    // Every entry of a 200-entry list extracted through the same per-element pool.
+    std::string json = buildEfaFixture(200);
+    static DeparturesResultN<200> result;
+    parseDeparturesJsonIncremental(json.c_str(), result);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(200, result.count);
+    TEST_ASSERT_EQUAL_STRING("Dir199", result.departures[199].direction);
+    TEST_ASSERT_EQUAL_INT(199, result.departures[199].countdown);
+}
+
+void test_DeparturesResultN_reused_in_place(void) {
+    // Reparsing into the same result replaces the previous outcome.
+    DeparturesResultN<5> result;
+    std::string json = buildEfaFixture(4);
+    parseDeparturesJsonIncremental(json.c_str(), result);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(4, result.count);
+
+    parseDeparturesJsonIncremental(R"({ "departureList": [] })", result);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(0, result.count);
+
+    parseDeparturesJson(NULL, result);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NULL_INPUT, result.error);
+    TEST_ASSERT_EQUAL_INT(0, result.count);
+}
+
+void test_DeparturesResultN_matches_c_abi(void) {
+    std::string json = buildEfaFixture(12);
+    DeparturesResult expected = parseDeparturesJson(json.c_str(), MAX_DEPARTURES);
+    DeparturesResultN<MAX_DEPARTURES> result;
+    parseDeparturesJson(json.c_str(), result);
+    TEST_ASSERT_EQUAL_INT(expected.success, result.success);
+    TEST_ASSERT_EQUAL_INT(expected.count, result.count);
+    for (int i = 0; i < expected.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(expected.departures[i].direction, result.departures[i].direction);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].realMinute, result.departures[i].realMinute);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].delayMin, result.departures[i].delayMin);
+        TEST_ASSERT_EQUAL_INT(expected.departures[i].countdown, result.departures[i].countdown);
+    }
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // matchesDirectionFilter tests
+    RUN_TEST(test_matchesDirectionFilter_empty_filter_matches_all);
+    RUN_TEST(test_matchesDirectionFilter_null_filter_matches_all);
+    RUN_TEST(test_matchesDirectionFilter_exact_match);
+    RUN_TEST(test_matchesDirectionFilter_partial_match);
+    RUN_TEST(test_matchesDirectionFilter_no_match);
+    RUN_TEST(test_matchesDirectionFilter_multiple_keywords_first_matches);
+    RUN_TEST(test_matchesDirectionFilter_multiple_keywords_second_matches);
+    RUN_TEST(test_matchesDirectionFilter_multiple_keywords_none_match);
+    RUN_TEST(test_matchesDirectionFilter_keywords_with_spaces);
+    RUN_TEST(test_matchesDirectionFilter_null_direction);
+    RUN_TEST(test_matchesDirectionFilter_case_sensitive);
+    RUN_TEST(test_matchesDirectionFilter_trailing_comma);
+    RUN_TEST(test_matchesDirectionFilter_only_commas);
+    RUN_TEST(test_matchesDirectionFilter_whitespace_only);
+    RUN_TEST(test_matchesDirectionFilter_exclude_blocks_match);
+    RUN_TEST(test_matchesDirectionFilter_exclude_substring);
+    RUN_TEST(test_matchesDirectionFilter_multiple_excludes);
+    RUN_TEST(test_matchesDirectionFilter_exclude_wins_over_include);
+
+    // parseDeparturesJson (EFA) tests
+    RUN_TEST(test_parseDeparturesJson_valid_response);
+    RUN_TEST(test_parseDeparturesJson_midnight_wrap_delay);
+    RUN_TEST(test_parseDeparturesJson_empty_list);
+    RUN_TEST(test_parseDeparturesJson_no_departure_list_key);
+    RUN_TEST(test_parseDeparturesJson_invalid_json);
+    RUN_TEST(test_parseDeparturesJson_null_input);
+    RUN_TEST(test_parseDeparturesJson_success_sets_ok);
+    RUN_TEST(test_parseDeparturesJson_no_memory);
+    RUN_TEST(test_parseDeparturesJson_max_results_limit);
+    RUN_TEST(test_parseDeparturesJson_unicode_direction);
+    RUN_TEST(test_parseDeparturesJson_long_direction_truncated);
+    RUN_TEST(test_parseDeparturesJson_missing_direction);
+    RUN_TEST(test_parseDeparturesJson_realtime_equals_scheduled_no_delay);
+    RUN_TEST(test_parseDeparturesJson_realistic_efa_response);
+
+    // parseDeparturesJsonIncremental tests
+    RUN_TEST(test_parseDeparturesJsonIncremental_matches_document_parse);
+    RUN_TEST(test_parseDeparturesJsonIncremental_15_entries);
+    RUN_TEST(test_parseDeparturesJsonIncremental_50_entries);
+    RUN_TEST(test_parseDeparturesJsonIncremental_200_entries);
+    RUN_TEST(test_parseDeparturesJsonIncremental_memory_independent_of_list_length);
+    RUN_TEST(test_parseDeparturesJsonIncremental_walks_whole_list);
+    RUN_TEST(test_parseDeparturesJsonIncremental_oversized_element);
+    RUN_TEST(test_parseDeparturesJsonIncremental_skips_tricky_preamble);
+    RUN_TEST(test_parseDeparturesJsonIncremental_skip_across_spans);
+    RUN_TEST(test_parseDeparturesJsonIncremental_empty_list);
+    RUN_TEST(test_parseDeparturesJsonIncremental_no_departure_list_key);
+    RUN_TEST(test_parseDeparturesJsonIncremental_invalid_json);
+    RUN_TEST(test_parseDeparturesJsonIncremental_null_input);
+    RUN_TEST(test_parseDeparturesJsonIncremental_max_results_limit);
+
+    // Partial result tests
+    RUN_TEST(test_parseDeparturesJsonIncremental_truncated_at_every_offset);
+    RUN_TEST(test_parseDeparturesJsonIncremental_truncated_past_capacity);
+    RUN_TEST(test_parseDeparturesJsonIncremental_partial_c_abi);
+    RUN_TEST(test_parseDeparturesJsonIncremental_garbage_is_not_partial);
+
+    // DeparturePushParser tests
+    RUN_TEST(test_DeparturePushParser_matches_pull_parser);
+    RUN_TEST(test_DeparturePushParser_truncated_at_every_offset);
+    RUN_TEST(test_DeparturePushParser_element_buffer_limits);
+    RUN_TEST(test_DeparturePushParser_drops_unwanted_members);
+    RUN_TEST(test_DeparturePushParser_stops_consuming_when_done);
+    RUN_TEST(test_DeparturePushParser_reset_keeps_leading_entries);
+    RUN_TEST(test_DeparturePushParser_reset_detects_shifted_list);
+    RUN_TEST(test_DeparturePushParser_emits_each_departure_when_its_element_closes);
+
+    // Displayable departure tests
+    RUN_TEST(test_isDisplayableDeparture);
+    RUN_TEST(test_countDisplayableDepartures);
+
+    // DeparturesResultN tests
+    RUN_TEST(test_DeparturesResultN_fills_to_capacity);
+    RUN_TEST(test_DeparturesResultN_small_capacity);
+    RUN_TEST(test_DeparturesResultN_200_entries_with_element_pool);
+    RUN_TEST(test_DeparturesResultN_reused_in_place);
+    RUN_TEST(test_DeparturesResultN_matches_c_abi);
+
+    return UNITY_END();
+}
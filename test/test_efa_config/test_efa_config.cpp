@@ -0,0 +1,196 @@
+#include <unity.h>
+#include "../../src/efa_config.h"
+#include <string.h>
+#include <string>
+
+// ============================================================================
+// Compile-time checks: these are the same static_asserts main.cpp applies to
+// secrets.h, so a regression here fails the build rather than a test.
+// ============================================================================
+
+static_assert(isValidStationId("6906508"), "numeric stop ID");
+static_assert(!isValidStationId("YOUR_STOP_ID"), "placeholder rejected");
+static_assert(!isValidWifiSsid("YOUR_WIFI_SSID"), "placeholder rejected");
+static_assert(isValidWifiPassword("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"), "raw PSK");
+static_assert(isValidDirectionFilter(""), "empty filter shows all");
+static_assert(isValidDirectionFilter("Alpha,!Depot"), "include plus exclude");
+static_assert(!isValidDirectionFilter(","), "separators only hide everything");
+static_assert(isValidRequestLimit(15), "default limit");
+static_assert(!isValidRequestLimit(0), "zero limit");
+
+static constexpr char kUrl[] = EFA_DM_URL("6906508", 15);
+static_assert(sizeof(kUrl) > 1, "URL is a literal");
+
+// ============================================================================
+// Tests for isValidStationId
+// ============================================================================
+
+void test_isValidStationId_accepts_numeric(void) {
+    TEST_ASSERT_TRUE(isValidStationId("6906508"));
+    TEST_ASSERT_TRUE(isValidStationId("1"));
+}
+
+void test_isValidStationId_rejects_bad_ids(void) {
+    TEST_ASSERT_FALSE(isValidStationId(""));
+    TEST_ASSERT_FALSE(isValidStationId("YOUR_STOP_ID"));
+    TEST_ASSERT_FALSE(isValidStationId("69065 08"));
+    TEST_ASSERT_FALSE(isValidStationId("6906508&limit=99"));
+    TEST_ASSERT_FALSE(isValidStationId("12345678901"));
+}
+
+// ============================================================================
+// Tests for isValidWifiSsid / isValidWifiPassword
+// ============================================================================
+
+void test_isValidWifiSsid(void) {
+    TEST_ASSERT_TRUE(isValidWifiSsid("home"));
+    TEST_ASSERT_TRUE(isValidWifiSsid("12345678901234567890123456789012"));
+    TEST_ASSERT_FALSE(isValidWifiSsid(""));
+    TEST_ASSERT_FALSE(isValidWifiSsid("123456789012345678901234567890123"));
+    TEST_ASSERT_FALSE(isValidWifiSsid("YOUR_WIFI_SSID"));
+    TEST_ASSERT_FALSE(isValidWifiSsid("your-network"));
+}
+
+void test_isValidWifiPassword(void) {
+    TEST_ASSERT_TRUE(isValidWifiPassword(""));
+    TEST_ASSERT_TRUE(isValidWifiPassword("12345678"));
+    TEST_ASSERT_FALSE(isValidWifiPassword("short"));
+    TEST_ASSERT_FALSE(isValidWifiPassword(std::string(64, 'x').c_str()));
+    TEST_ASSERT_FALSE(isValidWifiPassword(std::string(65, 'a').c_str()));
+    TEST_ASSERT_FALSE(isValidWifiPassword("YOUR_WIFI_PASSWORD"));
+    TEST_ASSERT_FALSE(isValidWifiPassword("your-password"));
+    // A raw PSK as 64 hex digits, as wpa_passphrase prints it.
+    TEST_ASSERT_TRUE(isValidWifiPassword("0123456789abcdefABCDEF0123456789abcdef0123456789abcdef0123456789"));
+}
+
+// ============================================================================
+// Tests for isValidRequestLimit
+// ============================================================================
+
+void test_isValidRequestLimit(void) {
+    TEST_ASSERT_TRUE(isValidRequestLimit(1));
+    TEST_ASSERT_TRUE(isValidRequestLimit(EFA_MAX_REQUEST_LIMIT));
+    TEST_ASSERT_FALSE(isValidRequestLimit(0));
+    TEST_ASSERT_FALSE(isValidRequestLimit(-3));
+    TEST_ASSERT_FALSE(isValidRequestLimit(EFA_MAX_REQUEST_LIMIT + 1));
+}
+
+// ============================================================================
+// Tests for isValidDirectionFilter
+// ============================================================================
+
+void test_isValidDirectionFilter_accepts_runtime_syntax(void) {
+    // Everything the matchesDirectionFilter tests treat as a working filter.
+    TEST_ASSERT_TRUE(isValidDirectionFilter(""));
+    TEST_ASSERT_TRUE(isValidDirectionFilter("Alpha"));
+    TEST_ASSERT_TRUE(isValidDirectionFilter("Alpha,Gamma"));
+    TEST_ASSERT_TRUE(isValidDirectionFilter(" Alpha , Gamma "));
+    TEST_ASSERT_TRUE(isValidDirectionFilter("Alpha,"));
+    TEST_ASSERT_TRUE(isValidDirectionFilter("Alpha,,Gamma"));
+    TEST_ASSERT_TRUE(isValidDirectionFilter("!Alpha"));
+    TEST_ASSERT_TRUE(isValidDirectionFilter("!Alpha,!Gamma"));
+    TEST_ASSERT_TRUE(isValidDirectionFilter("Beta,!Alpha"));
+}
+
+void test_isValidDirectionFilter_rejects_filters_that_hide_everything(void) {
+    TEST_ASSERT_FALSE(isValidDirectionFilter(","));
+    TEST_ASSERT_FALSE(isValidDirectionFilter(",,"));
+    TEST_ASSERT_FALSE(isValidDirectionFilter("   "));
+    TEST_ASSERT_FALSE(isValidDirectionFilter(" , "));
+    TEST_ASSERT_FALSE(isValidDirectionFilter("YOUR_DIRECTION"));
+}
+
+void test_isValidDirectionFilter_rejects_bare_exclusion(void) {
+    TEST_ASSERT_FALSE(isValidDirectionFilter("!"));
+    TEST_ASSERT_FALSE(isValidDirectionFilter("Alpha, !"));
+}
+
+void test_isValidDirectionFilter_rejects_unmatchable_keyword(void) {
+    // Directions are truncated to MAX_DIRECTION_LEN - 1, so a longer keyword
+    // can never be found in one.
+    std::string fits(MAX_DIRECTION_LEN - 1, 'a');
+    std::string tooLong(MAX_DIRECTION_LEN, 'a');
+    TEST_ASSERT_TRUE(isValidDirectionFilter(fits.c_str()));
+    TEST_ASSERT_TRUE(isValidDirectionFilter(("!" + fits).c_str()));
+    TEST_ASSERT_FALSE(isValidDirectionFilter(tooLong.c_str()));
+    TEST_ASSERT_FALSE(isValidDirectionFilter(("Alpha," + tooLong).c_str()));
+}
+
+// ============================================================================
+// Tests for EFA_DM_URL / buildEfaRequest
+// ============================================================================
+
+void test_EFA_DM_URL_literal(void) {
+    TEST_ASSERT_EQUAL_STRING(
+        "http://efa.vagfr.de/vagfr3/XSLT_DM_REQUEST"
+        "?outputFormat=JSON&language=de&stateless=1"
+        "&type_dm=stop&name_dm=6906508&mode=direct&useRealtime=1&limit=15&depType=stopEvents",
+        kUrl);
+}
+
+void test_buildEfaRequest_matches_url(void) {
+    char buffer[512];
+    size_t length = buildEfaRequest(buffer, sizeof(buffer), "6906508", 15, false);
+    TEST_ASSERT_EQUAL_INT(strlen(buffer), length);
+
+    // Request target is the URL minus scheme and host.
+    std::string expected = std::string("GET ") + (kUrl + strlen("http://" EFA_HOST)) +
+                           " HTTP/1.1\r\nHost: efa.vagfr.de\r\nConnection: close\r\n\r\n";
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), buffer);
+}
+
+void test_buildEfaRequest_runtime_limit(void) {
+    char buffer[512];
+    TEST_ASSERT_TRUE(buildEfaRequest(buffer, sizeof(buffer), "42", 7, false) > 0);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "name_dm=42&"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "&limit=7&"));
+}
+
+void test_buildEfaRequest_keep_alive(void) {
+    char close[512], keepAlive[512];
+    buildEfaRequest(close, sizeof(close), "6906508", 15, false);
+    size_t length = buildEfaRequest(keepAlive, sizeof(keepAlive), "6906508", 15, true);
+    TEST_ASSERT_EQUAL_INT(strlen(keepAlive), length);
+
+    // Same request line and Host; only the Connection header differs.
+    std::string expected = close;
+    expected.replace(expected.find("close"), strlen("close"), "keep-alive");
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), keepAlive);
+}
+
+void test_buildEfaRequest_too_small(void) {
+    char buffer[512];
+    size_t needed = buildEfaRequest(buffer, sizeof(buffer), "6906508", 15, false);
+
+    // Exactly enough room (length + NUL) succeeds; one byte less fails cleanly.
+    TEST_ASSERT_EQUAL_INT(needed, buildEfaRequest(buffer, needed + 1, "6906508", 15, false));
+    TEST_ASSERT_EQUAL_INT(0, buildEfaRequest(buffer, needed, "6906508", 15, false));
+    TEST_ASSERT_EQUAL_STRING("", buffer);
+    TEST_ASSERT_EQUAL_INT(0, buildEfaRequest(buffer, 0, "6906508", 15, false));
+    TEST_ASSERT_EQUAL_INT(0, buildEfaRequest(NULL, 64, "6906508", 15, false));
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_isValidStationId_accepts_numeric);
+    RUN_TEST(test_isValidStationId_rejects_bad_ids);
+    RUN_TEST(test_isValidWifiSsid);
+    RUN_TEST(test_isValidWifiPassword);
+    RUN_TEST(test_isValidRequestLimit);
+    RUN_TEST(test_isValidDirectionFilter_accepts_runtime_syntax);
+    RUN_TEST(test_isValidDirectionFilter_rejects_filters_that_hide_everything);
+    RUN_TEST(test_isValidDirectionFilter_rejects_bare_exclusion);
+    RUN_TEST(test_isValidDirectionFilter_rejects_unmatchable_keyword);
+    RUN_TEST(test_EFA_DM_URL_literal);
+    RUN_TEST(test_buildEfaRequest_matches_url);
+    RUN_TEST(test_buildEfaRequest_runtime_limit);
+    RUN_TEST(test_buildEfaRequest_keep_alive);
+    RUN_TEST(test_buildEfaRequest_too_small);
+
+    return UNITY_END();
+}
@@ -0,0 +1,857 @@
+#include <unity.h>
+#include "../../src/fetch_cycle.h"
+#include "../../src/refresh_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Heap accounting: every C++ allocation in the test binary goes through here,
+// but only those made while heapCounting is set (the measured fetch cycles)
+// are counted, not Unity's or the test's own.
+// ============================================================================
+
+static bool heapCounting = false;
+static size_t liveHeapBytes = 0;
+static size_t heapAllocations = 0;
+
+// The size and whether it was counted are kept in front of the block, so
+// delete can subtract exactly what new added.
+static const size_t kHeapHeader = sizeof(max_align_t);
+
+void* operator new(size_t size) {
+    unsigned char* block = (unsigned char*)malloc(size + kHeapHeader);
+    if (block == NULL) throw std::bad_alloc();
+    memcpy(block, &size, sizeof(size));
+    block[sizeof(size)] = heapCounting;
+    if (heapCounting) {
+        liveHeapBytes += size;
+        heapAllocations++;
+    }
+    return block + kHeapHeader;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer == NULL) return;
+    unsigned char* block = (unsigned char*)pointer - kHeapHeader;
+    size_t size;
+    memcpy(&size, block, sizeof(size));
+    if (block[sizeof(size)]) liveHeapBytes -= size;
+    free(block);
+}
+
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+
+// ============================================================================
+// Fakes: a manual clock, scripted WiFi and a scripted HTTP server
+// ============================================================================
+
+class FakePlatform : public FetchPlatform {
+ public:
+    FakePlatform()
+        : nowUsValue(0), wifiAtMs(0), wifiBegun(false), results(0), resultOutcome(FETCH_OK), resultCode(0),
+          resultCount(0), resultAtMs(0), secondLimitResult(0), secondLimitCalls(0), secondLimitDisplayable(-1),
+          departures(NULL), departureUs(0) {
+        memset(latency, 0, sizeof(latency));
+        memset(latencyCount, 0, sizeof(latencyCount));
+    }
+
+    uint64_t nowUs() override { return nowUsValue; }
+    void wifiBegin() override { wifiBegun = true; }
+    bool wifiConnected() override { return wifiBegun && nowUsValue >= wifiAtMs * 1000; }
+    void enterPhase(BootPhase phase) override { phases.push_back(phase); }
+    void drawSpinner(int frame) override {
+        TEST_ASSERT_EQUAL_INT((int)frameAtMs.size(), frame);
+        frameAtMs.push_back(nowUsValue / 1000);
+    }
+    void recordLatency(LatencyMetric metric, uint32_t ms) override {
+        latency[metric] = ms;
+        latencyCount[metric]++;
+    }
+    void departureParsed(const Departure* departure, int index) override {
+        TEST_ASSERT_EQUAL_INT(0, results);  // before the outcome
+        if (departures != NULL) TEST_ASSERT_TRUE(departure == &departures[index]);
+        parsedIndex.push_back(index);
+        parsedAtMs.push_back(nowUsValue / 1000);
+        nowUsValue += departureUs;
+    }
+    int secondLimit(int limit, int displayable) override {
+        (void)limit;
+        secondLimitCalls++;
+        secondLimitDisplayable = displayable;
+        return secondLimitResult;
+    }
+    void showResult(FetchOutcome outcome, int httpCode, const Departure* departures, int count) override {
+        results++;
+        resultOutcome = outcome;
+        resultCode = httpCode;
+        resultCount = count;
+        resultAtMs = nowUsValue / 1000;
+        if (count > 0) firstDirection = departures[0].direction;
+    }
+
+    uint64_t nowUsValue;
+    uint64_t wifiAtMs;  // WiFi reports connected from this time on
+    bool wifiBegun;
+    std::vector<BootPhase> phases;
+    std::vector<uint64_t> frameAtMs;
+    uint32_t latency[LATENCY_METRIC_COUNT];
+    int latencyCount[LATENCY_METRIC_COUNT];
+    int results;
+    FetchOutcome resultOutcome;
+    int resultCode;
+    int resultCount;
+    uint64_t resultAtMs;
+    std::string firstDirection;
+    int secondLimitResult;  // what secondLimit() answers
+    int secondLimitCalls;
+    int secondLimitDisplayable;
+    Departure* departures;       // the cycle's, to check what departureParsed() is given
+    std::vector<int> parsedIndex;
+    std::vector<uint64_t> parsedAtMs;
+    uint64_t departureUs;        // each departureParsed() takes this long (drawing a row)
+};
+
+// One scripted connection: pieces of the response become readable at fixed
+// times after connect(), then the server closes (or goes silent).
+struct FakeConnection {
+    bool connects;
+    std::vector<std::pair<uint64_t, std::string>> pieces;  // (ms after connect, bytes)
+    bool closeAfterLast;
+};
+
+class FakeTransport : public HttpTransport {
+ public:
+    explicit FakeTransport(FakePlatform& platform)
+        : readUs(0), _platform(platform), _current(-1), _piece(0), _offset(0) {}
+
+    bool connect(const char* host, uint16_t port) override {
+        (void)host;
+        (void)port;
+        _current++;
+        TEST_ASSERT_TRUE(_current < (int)connections.size());
+        connectAtMs.push_back(_platform.nowUsValue / 1000);
+        _piece = 0;
+        _offset = 0;
+        bytesRead.push_back(0);
+        return connections[_current].connects;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        requests.push_back(std::string((const char*)data, length));
+        return true;
+    }
+
+    int read(uint8_t* buffer, size_t capacity) override {
+        const FakeConnection& connection = connections[_current];
+        uint64_t sinceConnectMs = _platform.nowUsValue / 1000 - connectAtMs.back();
+        if (_piece >= connection.pieces.size()) return connection.closeAfterLast ? -1 : 0;
+        const std::pair<uint64_t, std::string>& piece = connection.pieces[_piece];
+        if (piece.first > sinceConnectMs) return 0;
+        size_t n = piece.second.size() - _offset;
+        if (n > capacity) n = capacity;
+        memcpy(buffer, piece.second.data() + _offset, n);
+        _offset += n;
+        if (_offset == piece.second.size()) {
+            _piece++;
+            _offset = 0;
+        }
+        bytesRead.back() += n;
+        reads++;
+        _platform.nowUsValue += readUs;
+        return (int)n;
+    }
+
+    void close() override { closes++; }
+
+    std::vector<FakeConnection> connections;
+    std::vector<uint64_t> connectAtMs;
+    std::vector<size_t> bytesRead;
+    std::vector<std::string> requests;
+    int closes = 0;
+    int reads = 0;   // reads that returned data
+    uint64_t readUs; // each such read (and the parse after it) takes this long
+
+ private:
+    FakePlatform& _platform;
+    int _current;
+    size_t _piece;
+    size_t _offset;
+};
+
+// Entries first..first+entries-1 of one board: entry i leaves at 17:<i>
+// towards <prefix><i>, so a later body with a larger first has lost the
+// departures before it.
+static std::string buildBody(int entries, const char* directionPrefix = "Dir", int first = 0) {
+    std::string json = "{ \"servingLines\": { \"lines\": [ { \"name\": \"[x] {y}\" } ] }, \"departureList\": [";
+    for (int i = first; i < first + entries; i++) {
+        char entry[256];
+        snprintf(entry, sizeof(entry),
+                 "%s{ \"countdown\": \"%d\", \"dateTime\": { \"hour\": \"17\", \"minute\": \"%d\" },"
+                 "\"servingLine\": { \"direction\": \"%s%d\" } }",
+                 i > first ? "," : "", i + 3, i, directionPrefix, i);
+        json += entry;
+    }
+    return json + "] }";
+}
+
+static std::string okResponse(const std::string& body) {
+    char head[128];
+    snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n", body.size());
+    return head + body;
+}
+
+static FakeConnection connection(bool connects, const std::vector<std::pair<uint64_t, std::string>>& pieces,
+                                 bool closeAfterLast) {
+    FakeConnection c = {connects, pieces, closeAfterLast};
+    return c;
+}
+
+static const FetchRequest kRequest = {"127.0.0.1", 80, "6930502", 10, "", 3, false};
+
+// Step until finished, idling exactly as long as step() allows each time.
+static void run(FetchCycle& cycle, FakePlatform& platform, int limit = 0) {
+    if (limit > 0) {
+        cycle.start(limit);
+    } else {
+        cycle.start();
+    }
+    for (int guard = 0; !cycle.finished(); guard++) {
+        TEST_ASSERT_TRUE(guard < 100000);
+        uint32_t idleMs = cycle.step();
+        platform.nowUsValue += (uint64_t)idleMs * 1000;
+    }
+    TEST_ASSERT_EQUAL_INT(1, platform.results);
+}
+
+// Sized for kRequest, and wider for the second-request tests.
+static DeparturesResultN<10> result;
+static DeparturesResultN<20> wideResult;
+
+// ============================================================================
+// Tests for FetchCycle
+// ============================================================================
+
+void test_fetch_cycle_success(void) {
+    FakePlatform platform;
+    platform.wifiAtMs = 1200;
+    FakeTransport transport(platform);
+    std::string response = okResponse(buildBody(6));
+    size_t third = response.size() / 3;
+    transport.connections.push_back(connection(true,
+                                               {{50, response.substr(0, third)},
+                                                {80, response.substr(third, third)},
+                                                {400, response.substr(2 * third)}},
+                                               false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(200, platform.resultCode);
+    TEST_ASSERT_EQUAL_INT(6, platform.resultCount);
+    TEST_ASSERT_EQUAL_STRING("Dir0", platform.firstDirection.c_str());
+    TEST_ASSERT_EQUAL_INT(1, cycle.attempts());
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_OK, result.error);
+    TEST_ASSERT_EQUAL_INT(6, result.count);
+
+    const BootPhase expected[] = {PHASE_WIFI_CONNECT, PHASE_HTTP_WAIT, PHASE_RECEIVE, PHASE_RENDER};
+    TEST_ASSERT_EQUAL_INT(4, platform.phases.size());
+    for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL_INT(expected[i], platform.phases[i]);
+
+    TEST_ASSERT_EQUAL_UINT32(1200, platform.latency[LATENCY_WIFI_CONNECT]);
+    TEST_ASSERT_EQUAL_UINT32(50, platform.latency[LATENCY_FIRST_BYTE]);
+    TEST_ASSERT_EQUAL_UINT32(350, platform.latency[LATENCY_BODY_TRANSFER]);
+    TEST_ASSERT_EQUAL_UINT32(1600, platform.latency[LATENCY_TOTAL]);
+    TEST_ASSERT_EQUAL_UINT32(1600, platform.resultAtMs);
+
+    // The request is the EFA GET for the configured station and limit.
+    TEST_ASSERT_EQUAL_INT(1, transport.requests.size());
+    TEST_ASSERT_TRUE(transport.requests[0].find("name_dm=6930502") != std::string::npos);
+    TEST_ASSERT_TRUE(transport.requests[0].find("limit=10") != std::string::npos);
+}
+
+void test_fetch_cycle_spinner_keeps_its_cadence(void) {
+    // Frames every 100 ms through WiFi, waiting and receiving, and none after
+    // the result is on screen.
+    FakePlatform platform;
+    platform.wifiAtMs = 730;
+    FakeTransport transport(platform);
+    std::string response = okResponse(buildBody(3));
+    transport.connections.push_back(
+        connection(true, {{300, response.substr(0, 40)}, {1900, response.substr(40)}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_UINT32(2630, platform.resultAtMs);
+    TEST_ASSERT_EQUAL_INT(27, platform.frameAtMs.size());  // frames at 0, 100, ..., 2600
+    for (size_t i = 0; i < platform.frameAtMs.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(i * FetchCycle::kFrameMs, platform.frameAtMs[i]);
+    }
+}
+
+void test_fetch_cycle_wifi_deadline_is_exact(void) {
+    FakePlatform platform;
+    platform.wifiAtMs = UINT32_MAX;
+    FakeTransport transport(platform);
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_ERR_WIFI, cycle.outcome());
+    TEST_ASSERT_EQUAL_UINT32(FetchCycle::kWifiTimeoutMs, platform.resultAtMs);
+    TEST_ASSERT_EQUAL_INT(0, transport.connectAtMs.size());
+    TEST_ASSERT_EQUAL_INT(0, platform.latencyCount[LATENCY_WIFI_CONNECT]);
+}
+
+void test_fetch_cycle_wifi_just_in_time(void) {
+    FakePlatform platform;
+    platform.wifiAtMs = FetchCycle::kWifiTimeoutMs - 1;
+    FakeTransport transport(platform);
+    transport.connections.push_back(connection(true, {{0, okResponse(buildBody(3))}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    // WiFi is polled, so it is noticed at most one poll interval late.
+    TEST_ASSERT_TRUE(transport.connectAtMs[0] >= FetchCycle::kWifiTimeoutMs - 1);
+    TEST_ASSERT_TRUE(transport.connectAtMs[0] <= FetchCycle::kWifiTimeoutMs - 1 + FetchCycle::kPollMs);
+}
+
+void test_fetch_cycle_retries_after_connect_failure(void) {
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    transport.connections.push_back(connection(false, {}, true));
+    transport.connections.push_back(connection(false, {}, true));
+    transport.connections.push_back(connection(true, {{10, okResponse(buildBody(4))}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(3, cycle.attempts());
+    TEST_ASSERT_EQUAL_INT(3, transport.connectAtMs.size());
+    TEST_ASSERT_EQUAL_UINT32(0, transport.connectAtMs[0]);
+    TEST_ASSERT_EQUAL_UINT32(FetchCycle::kRetryDelayMs, transport.connectAtMs[1]);
+    TEST_ASSERT_EQUAL_UINT32(2 * FetchCycle::kRetryDelayMs, transport.connectAtMs[2]);
+}
+
+void test_fetch_cycle_network_error_after_last_attempt(void) {
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    for (int i = 0; i < FetchCycle::kMaxAttempts; i++) transport.connections.push_back(connection(false, {}, true));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_ERR_NETWORK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(-HTTP_ERR_CONNECT, platform.resultCode);
+    TEST_ASSERT_EQUAL_INT(0, platform.resultCount);
+}
+
+void test_fetch_cycle_server_error_retried_immediately(void) {
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    for (int i = 0; i < FetchCycle::kMaxAttempts; i++) {
+        transport.connections.push_back(
+            connection(true, {{20, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n"}}, false));
+    }
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_ERR_SERVER, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(503, platform.resultCode);
+    TEST_ASSERT_EQUAL_UINT32(20, transport.connectAtMs[1]);
+    TEST_ASSERT_EQUAL_UINT32(40, transport.connectAtMs[2]);
+}
+
+void test_fetch_cycle_idle_timeout_is_exact(void) {
+    // A server that accepts and never answers times out exactly
+    // kIdleTimeoutMs after the request.
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    transport.connections.push_back(connection(true, {}, false));
+    transport.connections.push_back(connection(true, {{5, okResponse(buildBody(3))}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_UINT32(FetchCycle::kIdleTimeoutMs + FetchCycle::kRetryDelayMs, transport.connectAtMs[1]);
+}
+
+void test_fetch_cycle_stalled_body_keeps_usable_rows(void) {
+    // The body stalls after five complete departures: enough rows for the
+    // display, so no retry.
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    std::string response = okResponse(buildBody(10));
+    response.resize(response.find("Dir5"));
+    transport.connections.push_back(connection(true, {{10, response}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(PARSE_PARTIAL, cycle.parseError());
+    TEST_ASSERT_EQUAL_INT(5, platform.resultCount);
+    TEST_ASSERT_EQUAL_INT(1, cycle.attempts());
+    TEST_ASSERT_EQUAL_UINT32(10 + FetchCycle::kIdleTimeoutMs, platform.resultAtMs);
+}
+
+void test_fetch_cycle_short_partial_body_is_retried(void) {
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    std::string full = okResponse(buildBody(6));
+    std::string cut = full.substr(0, full.find("Dir1"));
+    transport.connections.push_back(connection(true, {{10, cut}}, true));
+    transport.connections.push_back(connection(true, {{10, full}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(2, cycle.attempts());
+    TEST_ASSERT_EQUAL_INT(6, platform.resultCount);
+}
+
+void test_fetch_cycle_reports_departures_while_receiving(void) {
+    // Two departures arrive at 50 ms, the rest at 400 ms: the first ones are
+    // handed out on arrival, not when the body is complete.
+    FakePlatform platform;
+    platform.departures = result.departures;
+    platform.departureUs = 3000;
+    FakeTransport transport(platform);
+    std::string response = okResponse(buildBody(6));
+    size_t split = response.find("{ \"countdown\": \"5\"");
+    transport.connections.push_back(
+        connection(true, {{50, response.substr(0, split)}, {400, response.substr(split)}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(6, platform.parsedIndex.size());
+    for (int i = 0; i < 6; i++) TEST_ASSERT_EQUAL_INT(i, platform.parsedIndex[i]);
+    TEST_ASSERT_EQUAL_UINT32(50, platform.parsedAtMs[0]);
+    TEST_ASSERT_TRUE(platform.parsedAtMs[1] < 400);
+    TEST_ASSERT_TRUE(platform.parsedAtMs[2] >= 400);
+    TEST_ASSERT_TRUE(platform.resultAtMs >= platform.parsedAtMs[5]);
+    // The 18 ms spent drawing are not parse time.
+    TEST_ASSERT_EQUAL_UINT32(0, platform.latency[LATENCY_PARSE]);
+}
+
+void test_fetch_cycle_reports_departures_again_on_retry(void) {
+    // A cut-off first attempt reported one departure; the retry reports the
+    // list from its start again.
+    FakePlatform platform;
+    platform.departures = result.departures;
+    FakeTransport transport(platform);
+    std::string full = okResponse(buildBody(6));
+    transport.connections.push_back(connection(true, {{10, full.substr(0, full.find("Dir1"))}}, true));
+    transport.connections.push_back(connection(true, {{10, full}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(2, cycle.attempts());
+    const int expected[] = {0, 0, 1, 2, 3, 4, 5};
+    TEST_ASSERT_EQUAL_INT(7, platform.parsedIndex.size());
+    for (int i = 0; i < 7; i++) TEST_ASSERT_EQUAL_INT(expected[i], platform.parsedIndex[i]);
+}
+
+void test_fetch_cycle_stops_reading_after_list(void) {
+    // Everything after departureList is left unread and the connection closed.
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    std::string body = buildBody(3);
+    body.insert(body.size() - 1, ", \"trailer\": \"" + std::string(100000, 't') + "\" ");
+    transport.connections.push_back(connection(true, {{10, okResponse(body)}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_TRUE(transport.bytesRead[0] < 2 * FetchCycle::kReadChunk);
+    TEST_ASSERT_TRUE(transport.closes >= 1);
+}
+
+void test_fetch_cycle_oversized_element_not_retried(void) {
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    std::string body = "{ \"departureList\": [ { \"countdown\": \"5\", \"servingLine\": { \"direction\": \"" +
+                       std::string(FetchCycle::kElementBufferSize, 'x') + "\" } } ] }";
+    transport.connections.push_back(connection(true, {{10, okResponse(body)}}, false));
+    transport.connections.push_back(connection(true, {{10, okResponse(body)}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_ERR_TOO_LARGE, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(1, cycle.attempts());
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_ERR_NO_MEMORY, result.error);
+    TEST_ASSERT_EQUAL_INT(0, result.count);
+}
+
+void test_fetch_cycle_large_element_with_small_kept_fields(void) {
+    // Only the members the filter keeps count against the element buffer:
+    // long line info and texts in an element are dropped while it is copied.
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    std::string body = buildBody(3);
+    std::string filler = "\"lineInfos\": { \"infoText\": \"" + std::string(FetchCycle::kElementBufferSize, 'i') +
+                         "\" }, \"servingLine\": { \"name\": \"" + std::string(2000, 'n') + "\", ";
+    size_t line = body.find("\"servingLine\": {");
+    body.replace(line, strlen("\"servingLine\": {"), filler);
+    TEST_ASSERT_TRUE(body.size() > FetchCycle::kElementBufferSize + 2000);
+    transport.connections.push_back(connection(true, {{10, okResponse(body)}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(3, cycle.count());
+    TEST_ASSERT_EQUAL_STRING("Dir0", result.departures[0].direction);
+}
+
+void test_fetch_cycle_receive_runs_until_the_next_frame(void) {
+    // A body that is all there at once is read for as long as the next
+    // spinner frame allows, not a fixed number of chunks per step: the socket
+    // drains at network speed and frames still keep their cadence.
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    transport.readUs = 2000;
+    std::string body = buildBody(3);
+    body.insert(1, "\"pad\": \"" + std::string(256 * 1024, 'p') + "\", ");
+    transport.connections.push_back(connection(true, {{0, okResponse(body)}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    cycle.start();
+    int steps = 0;
+    while (!cycle.finished()) {
+        platform.nowUsValue += (uint64_t)cycle.step() * 1000;
+        steps++;
+        TEST_ASSERT_TRUE(steps < 1000);
+    }
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+
+    // ~100 ms of reads per step: far more than a fixed 8 KB budget allows.
+    uint64_t perFrame = FetchCycle::kFrameMs * 1000 / transport.readUs;
+    TEST_ASSERT_TRUE(steps <= (int)(transport.reads / (perFrame - 1)) + 3);
+    for (size_t i = 1; i < platform.frameAtMs.size(); i++) {
+        TEST_ASSERT_TRUE(platform.frameAtMs[i] - platform.frameAtMs[i - 1] <=
+                         FetchCycle::kFrameMs + transport.readUs / 1000);
+    }
+}
+
+void test_fetch_cycle_second_fetch_fills_display(void) {
+    // Four entries, none towards Dir6-8: the list was full, so a second,
+    // larger request is made. Its first four entries repeat the rows already
+    // parsed, so only the new ones are reported.
+    FakePlatform platform;
+    platform.secondLimitResult = 12;
+    FakeTransport transport(platform);
+    transport.connections.push_back(connection(true, {{10, okResponse(buildBody(4))}}, false));
+    transport.connections.push_back(connection(true, {{10, okResponse(buildBody(12))}}, false));
+    FetchRequest request = {"127.0.0.1", 80, "6930502", 4, "Dir6,Dir7,Dir8", 3, false};
+    FetchCycle cycle(platform, transport, request, wideResult);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_TRUE(cycle.secondFetch());
+    TEST_ASSERT_EQUAL_INT(1, platform.secondLimitCalls);
+    TEST_ASSERT_EQUAL_INT(0, platform.secondLimitDisplayable);
+    TEST_ASSERT_EQUAL_INT(12, cycle.limit());
+    TEST_ASSERT_EQUAL_INT(2, transport.requests.size());
+    TEST_ASSERT_TRUE(transport.requests[0].find("limit=4&") != std::string::npos);
+    TEST_ASSERT_TRUE(transport.requests[1].find("limit=12&") != std::string::npos);
+
+    TEST_ASSERT_EQUAL_INT(12, platform.resultCount);
+    TEST_ASSERT_EQUAL_STRING("Dir3", wideResult.departures[3].direction);
+    TEST_ASSERT_EQUAL_STRING("Dir4", wideResult.departures[4].direction);
+    TEST_ASSERT_EQUAL_STRING("Dir11", wideResult.departures[11].direction);
+    TEST_ASSERT_EQUAL_INT(4 + 8, platform.parsedIndex.size());
+    TEST_ASSERT_EQUAL_INT(4, platform.parsedIndex[4]);
+}
+
+void test_fetch_cycle_second_fetch_after_board_moved_on(void) {
+    // Between the two requests Dir0 left: the second list starts at Dir1, so
+    // its entries no longer line up with the rows kept from the first. They
+    // are extracted again instead of skipped, leaving no duplicate or gap.
+    FakePlatform platform;
+    platform.secondLimitResult = 12;
+    FakeTransport transport(platform);
+    transport.connections.push_back(connection(true, {{10, okResponse(buildBody(4))}}, false));
+    transport.connections.push_back(connection(true, {{10, okResponse(buildBody(12, "Dir", 1))}}, false));
+    FetchRequest request = {"127.0.0.1", 80, "6930502", 4, "Dir6,Dir7,Dir8", 3, false};
+    FetchCycle cycle(platform, transport, request, wideResult);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_TRUE(cycle.secondFetch());
+    TEST_ASSERT_EQUAL_INT(12, platform.resultCount);
+    for (int i = 0; i < 12; i++) {
+        char expected[8];
+        snprintf(expected, sizeof(expected), "Dir%d", i + 1);
+        TEST_ASSERT_EQUAL_STRING(expected, wideResult.departures[i].direction);
+    }
+    // The second attempt reports its list from the start again.
+    TEST_ASSERT_EQUAL_INT(4 + 12, platform.parsedIndex.size());
+    TEST_ASSERT_EQUAL_INT(0, platform.parsedIndex[4]);
+}
+
+void test_fetch_cycle_second_fetch_capped_and_not_retried(void) {
+    // The second limit is capped at the result capacity; when that request
+    // fails, the first response is shown rather than an error.
+    FakePlatform platform;
+    platform.secondLimitResult = 500;
+    FakeTransport transport(platform);
+    transport.connections.push_back(connection(true, {{10, okResponse(buildBody(4))}}, false));
+    transport.connections.push_back(connection(false, {}, true));
+    FetchRequest request = {"127.0.0.1", 80, "6930502", 4, "Nowhere", 3, false};
+    FetchCycle cycle(platform, transport, request, wideResult);
+    run(cycle, platform);
+
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(20, cycle.limit());
+    TEST_ASSERT_EQUAL_INT(2, cycle.attempts());
+    TEST_ASSERT_EQUAL_INT(4, platform.resultCount);
+    TEST_ASSERT_EQUAL_STRING("Dir0", wideResult.departures[0].direction);
+}
+
+void test_fetch_cycle_no_second_fetch_when_not_needed(void) {
+    // A short list means there is nothing more to fetch; a filled display
+    // needs nothing more.
+    FakePlatform shortList;
+    shortList.secondLimitResult = 12;
+    FakeTransport shortTransport(shortList);
+    shortTransport.connections.push_back(connection(true, {{10, okResponse(buildBody(3))}}, false));
+    FetchRequest request = {"127.0.0.1", 80, "6930502", 4, "Nowhere", 3, false};
+    FetchCycle shortCycle(shortList, shortTransport, request, wideResult);
+    run(shortCycle, shortList);
+    TEST_ASSERT_EQUAL_INT(0, shortList.secondLimitCalls);
+    TEST_ASSERT_FALSE(shortCycle.secondFetch());
+
+    FakePlatform filled;
+    filled.secondLimitResult = 12;
+    FakeTransport filledTransport(filled);
+    filledTransport.connections.push_back(connection(true, {{10, okResponse(buildBody(4))}}, false));
+    request.directionFilter = "";
+    FetchCycle filledCycle(filled, filledTransport, request, wideResult);
+    run(filledCycle, filled);
+    TEST_ASSERT_EQUAL_INT(0, filled.secondLimitCalls);
+    TEST_ASSERT_EQUAL_INT(4, filled.resultCount);
+}
+
+void test_fetch_cycle_start_limit_overrides_request(void) {
+    // The limit chosen at boot replaces request.limit, capped at capacity.
+    FakePlatform platform;
+    FakeTransport transport(platform);
+    transport.connections.push_back(connection(true, {{10, okResponse(buildBody(6))}}, false));
+    FetchCycle cycle(platform, transport, kRequest, result);
+    run(cycle, platform, 6);
+    TEST_ASSERT_EQUAL_INT(6, cycle.limit());
+    TEST_ASSERT_TRUE(transport.requests[0].find("limit=6&") != std::string::npos);
+
+    FakePlatform capped;
+    FakeTransport cappedTransport(capped);
+    cappedTransport.connections.push_back(connection(true, {{10, okResponse(buildBody(6))}}, false));
+    FetchCycle cappedCycle(capped, cappedTransport, kRequest, result);
+    run(cappedCycle, capped, 99);
+    TEST_ASSERT_EQUAL_INT(result.kCapacity, cappedCycle.limit());
+}
+
+// A keep-alive server on the other end of one connection: every request
+// written is answered with the next of its responses, in chunks of at most
+// chunk bytes. Allocates nothing once built.
+class LoopbackTransport : public HttpTransport {
+ public:
+    LoopbackTransport(const std::string* responses, int responseCount, size_t chunk)
+        : connects(0), writes(0), closes(0), closeIdle(false), _responses(responses), _responseCount(responseCount),
+          _chunk(chunk), _pending(NULL), _offset(0), _open(false) {}
+
+    bool connect(const char* host, uint16_t port) override {
+        (void)host;
+        (void)port;
+        connects++;
+        _open = true;
+        _pending = NULL;
+        return true;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        (void)data;
+        (void)length;
+        if (!_open) return false;
+        _pending = &_responses[writes++ % _responseCount];
+        _offset = 0;
+        return true;
+    }
+
+    int read(uint8_t* buffer, size_t capacity) override {
+        if (!_open || closeIdle) return -1;  // the server dropped the idle connection
+        if (_pending == NULL || _offset == _pending->size()) return 0;
+        size_t n = _pending->size() - _offset;
+        if (n > capacity) n = capacity;
+        if (n > _chunk) n = _chunk;
+        memcpy(buffer, _pending->data() + _offset, n);
+        _offset += n;
+        return (int)n;
+    }
+
+    void close() override {
+        closes++;
+        _open = false;
+        closeIdle = false;
+    }
+
+    int connects;
+    int writes;
+    int closes;
+    bool closeIdle;  // the next read finds the connection closed by the server
+
+ private:
+    const std::string* _responses;
+    int _responseCount;
+    size_t _chunk;
+    const std::string* _pending;
+    size_t _offset;
+    bool _open;
+};
+
+static std::string keepAliveResponse(const std::string& body) {
+    char head[128];
+    snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nConnection: keep-alive\r\nContent-Length: %zu\r\n\r\n",
+             body.size());
+    return head + body;
+}
+
+static const FetchRequest kKeepAliveRequest = {"127.0.0.1", 80, "6930502", 10, "", 3, true};
+
+void test_fetch_cycle_keep_alive_reuses_connection(void) {
+    FakePlatform platform;
+    std::string responses[] = {keepAliveResponse(buildBody(6))};
+    LoopbackTransport transport(responses, 1, 700);
+    FetchCycle cycle(platform, transport, kKeepAliveRequest, result);
+
+    run(cycle, platform);
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_FALSE(cycle.reusedConnection());
+    TEST_ASSERT_EQUAL_INT(1, platform.latencyCount[LATENCY_WIFI_CONNECT]);
+    TEST_ASSERT_EQUAL_INT(0, transport.closes);  // the tail after departureList was drained instead
+
+    // Next refresh: WiFi is still up and the request goes out on the same
+    // connection, without a connect phase.
+    platform.results = 0;
+    platform.phases.clear();
+    platform.frameAtMs.clear();
+    run(cycle, platform);
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(6, platform.resultCount);
+    TEST_ASSERT_TRUE(cycle.reusedConnection());
+    TEST_ASSERT_EQUAL_INT(1, transport.connects);
+    TEST_ASSERT_EQUAL_INT(2, transport.writes);
+    TEST_ASSERT_EQUAL_INT(1, platform.latencyCount[LATENCY_WIFI_CONNECT]);
+    TEST_ASSERT_EQUAL_INT(PHASE_HTTP_WAIT, platform.phases[0]);
+
+    // The server closed the idle connection in between: reconnect at once.
+    platform.results = 0;
+    platform.frameAtMs.clear();
+    transport.closeIdle = true;
+    uint64_t startMs = platform.nowUsValue / 1000;
+    run(cycle, platform);
+    TEST_ASSERT_EQUAL_INT(FETCH_OK, cycle.outcome());
+    TEST_ASSERT_EQUAL_INT(2, cycle.attempts());
+    TEST_ASSERT_EQUAL_INT(2, transport.connects);
+    TEST_ASSERT_FALSE(cycle.reusedConnection());
+    TEST_ASSERT_TRUE(platform.nowUsValue / 1000 - startMs < FetchCycle::kRetryDelayMs);
+}
+
+// Board side of a long refresh soak: a clock and WiFi that stays up, and
+// nothing that allocates.
+class SoakPlatform : public FetchPlatform {
+ public:
+    SoakPlatform() : nowUsValue(0), shown(0), lastCount(0) {}
+
+    uint64_t nowUs() override { return nowUsValue; }
+    void wifiBegin() override {}
+    bool wifiConnected() override { return true; }
+    void enterPhase(BootPhase) override {}
+    void drawSpinner(int) override {}
+    void recordLatency(LatencyMetric, uint32_t) override {}
+    void showResult(FetchOutcome, int, const Departure*, int count) override {
+        shown++;
+        lastCount = count;
+    }
+
+    uint64_t nowUsValue;
+    int shown;
+    int lastCount;
+};
+
+void test_fetch_cycle_refresh_soak_keeps_heap_flat(void) {
+    // Thousands of always-on refresh cycles on one cycle object and one
+    // connection: after warm-up, a cycle must not allocate at all.
+    static const int kCycles = 5000;
+    std::string responses[] = {keepAliveResponse(buildBody(8)), keepAliveResponse(buildBody(5, "Other"))};
+    LoopbackTransport transport(responses, 2, 333);
+    SoakPlatform platform;
+    FetchCycle* cycle = new FetchCycle(platform, transport, kKeepAliveRequest, result);
+
+    RefreshStats stats;
+    refreshStatsInit(&stats);
+    size_t allocationsAfterWarmup = 0;
+    for (int i = 0; i < kCycles; i++) {
+        if (i == REFRESH_WARMUP_CYCLES) allocationsAfterWarmup = heapAllocations;
+        heapCounting = true;
+        cycle->start();
+        for (int guard = 0; !cycle->finished(); guard++) {
+            if (guard >= 10000) {
+                heapCounting = false;
+                TEST_FAIL_MESSAGE("cycle did not finish");
+            }
+            platform.nowUsValue += (uint64_t)cycle->step() * 1000 + 1000;
+        }
+        heapCounting = false;
+        RefreshSample sample = {cycle->durationMs(), cycle->outcome() == FETCH_OK, cycle->reusedConnection(), 0,
+                                (uint32_t)liveHeapBytes};
+        refreshStatsRecord(&stats, &sample);
+        platform.nowUsValue += 30000000ULL;  // refresh interval
+    }
+
+    TEST_ASSERT_EQUAL_INT(kCycles, platform.shown);
+    TEST_ASSERT_EQUAL_INT(5, platform.lastCount);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.failures);
+    TEST_ASSERT_EQUAL_INT(1, transport.connects);
+    TEST_ASSERT_EQUAL_UINT32(kCycles - 1, stats.reusedConnections);
+    TEST_ASSERT_EQUAL_size_t(allocationsAfterWarmup, heapAllocations);
+    TEST_ASSERT_EQUAL_INT(0, refreshStatsHeapDrift(&stats));
+    TEST_ASSERT_EQUAL_UINT32(stats.baselineHeapUsed, stats.peakHeapUsed);
+    delete cycle;
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fetch_cycle_success);
+    RUN_TEST(test_fetch_cycle_spinner_keeps_its_cadence);
+    RUN_TEST(test_fetch_cycle_wifi_deadline_is_exact);
+    RUN_TEST(test_fetch_cycle_wifi_just_in_time);
+    RUN_TEST(test_fetch_cycle_retries_after_connect_failure);
+    RUN_TEST(test_fetch_cycle_network_error_after_last_attempt);
+    RUN_TEST(test_fetch_cycle_server_error_retried_immediately);
+    RUN_TEST(test_fetch_cycle_idle_timeout_is_exact);
+    RUN_TEST(test_fetch_cycle_stalled_body_keeps_usable_rows);
+    RUN_TEST(test_fetch_cycle_short_partial_body_is_retried);
+    RUN_TEST(test_fetch_cycle_reports_departures_while_receiving);
+    RUN_TEST(test_fetch_cycle_reports_departures_again_on_retry);
+    RUN_TEST(test_fetch_cycle_stops_reading_after_list);
+    RUN_TEST(test_fetch_cycle_oversized_element_not_retried);
+    RUN_TEST(test_fetch_cycle_large_element_with_small_kept_fields);
+    RUN_TEST(test_fetch_cycle_receive_runs_until_the_next_frame);
+    RUN_TEST(test_fetch_cycle_start_limit_overrides_request);
+    RUN_TEST(test_fetch_cycle_second_fetch_fills_display);
+    RUN_TEST(test_fetch_cycle_second_fetch_after_board_moved_on);
+    RUN_TEST(test_fetch_cycle_second_fetch_capped_and_not_retried);
+    RUN_TEST(test_fetch_cycle_no_second_fetch_when_not_needed);
+    RUN_TEST(test_fetch_cycle_keep_alive_reuses_connection);
+    RUN_TEST(test_fetch_cycle_refresh_soak_keeps_heap_flat);
+
+    return UNITY_END();
+}
@@ -0,0 +1,530 @@
+#include <unity.h>
+#include "../../src/http_client.h"
+#include "../../src/efa_config.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Feed `response` to a fresh decoder in pieces of `piece` bytes and collect
+// the body it emits.
+static std::string decodeInPieces(HttpResponseDecoder& decoder, const std::string& response, size_t piece) {
+    decoder.reset();
+    std::string body;
+    std::string buffer;
+    for (size_t pos = 0; pos < response.size(); pos += piece) {
+        buffer = response.substr(pos, piece);
+        size_t n = decoder.decode((uint8_t*)&buffer[0], buffer.size());
+        body.append(buffer, 0, n);
+    }
+    return body;
+}
+
+// Every split of `response` into two pieces, and every piece size from 1 up,
+// must yield the same body and final state.
+static void checkAllSplits(const std::string& response, const std::string& expectedBody, bool expectDone) {
+    HttpResponseDecoder decoder;
+    for (size_t piece = 1; piece <= response.size(); piece++) {
+        std::string body = decodeInPieces(decoder, response, piece);
+        TEST_ASSERT_EQUAL_STRING(expectedBody.c_str(), body.c_str());
+        TEST_ASSERT_EQUAL_INT(expectDone, decoder.done());
+        TEST_ASSERT_FALSE(decoder.failed());
+    }
+    for (size_t split = 0; split <= response.size(); split++) {
+        decoder.reset();
+        std::string head = response.substr(0, split);
+        std::string tail = response.substr(split);
+        std::string body;
+        body.append(head, 0, decoder.decode((uint8_t*)&head[0], head.size()));
+        body.append(tail, 0, decoder.decode((uint8_t*)&tail[0], tail.size()));
+        TEST_ASSERT_EQUAL_STRING(expectedBody.c_str(), body.c_str());
+        TEST_ASSERT_EQUAL_INT(expectDone, decoder.done());
+    }
+}
+
+// EFA-shaped body with `entries` departures.
+static std::string buildEfaFixture(int entries) {
+    std::string json = "{ \"servingLines\": { \"lines\": [ { \"name\": \"3\" } ] }, \"departureList\": [";
+    for (int i = 0; i < entries; i++) {
+        char entry[320];
+        snprintf(entry, sizeof(entry),
+                 "%s{ \"countdown\": \"%d\", \"dateTime\": { \"hour\": \"17\", \"minute\": \"%d\" },"
+                 "\"realDateTime\": { \"hour\": \"17\", \"minute\": \"%d\" },"
+                 "\"servingLine\": { \"number\": \"3\", \"direction\": \"Dir%d\", \"realtime\": \"1\" } }",
+                 i > 0 ? "," : "", i, i % 60, (i + 2) % 60, i);
+        json += entry;
+    }
+    json += "] }";
+    return json;
+}
+
+// Wrap body in chunked framing with chunks of at most `chunk` bytes.
+static std::string chunkedBody(const std::string& body, size_t chunk) {
+    std::string out;
+    char size[16];
+    for (size_t pos = 0; pos < body.size(); pos += chunk) {
+        std::string part = body.substr(pos, chunk);
+        snprintf(size, sizeof(size), "%zx\r\n", part.size());
+        out += size + part + "\r\n";
+    }
+    return out + "0\r\n\r\n";
+}
+
+// ============================================================================
+// Tests for HttpResponseDecoder
+// ============================================================================
+
+void test_decoder_content_length(void) {
+    std::string response =
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\n\r\nhello world";
+    checkAllSplits(response, "hello world", true);
+
+    HttpResponseDecoder decoder;
+    decodeInPieces(decoder, response, 5);
+    TEST_ASSERT_TRUE(decoder.headersDone());
+    TEST_ASSERT_EQUAL_INT(200, decoder.statusCode());
+    TEST_ASSERT_EQUAL_INT(11, decoder.contentLength());
+    TEST_ASSERT_FALSE(decoder.chunked());
+    TEST_ASSERT_TRUE(decoder.keepAlive());
+    TEST_ASSERT_EQUAL_INT(11, decoder.bodyBytes());
+}
+
+void test_decoder_ignores_bytes_after_body(void) {
+    HttpResponseDecoder decoder;
+    std::string body = decodeInPieces(decoder, "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nabcHTTP/1.1 200", 100);
+    TEST_ASSERT_EQUAL_STRING("abc", body.c_str());
+    TEST_ASSERT_TRUE(decoder.done());
+}
+
+void test_decoder_chunked(void) {
+    std::string response =
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "5\r\nhello\r\n"
+        "1;name=value\r\n \r\n"
+        "A\r\n0123456789\r\n"
+        "0\r\nX-Trailer: 1\r\n\r\n";
+    checkAllSplits(response, "hello 0123456789", true);
+
+    HttpResponseDecoder decoder;
+    decodeInPieces(decoder, response, 3);
+    TEST_ASSERT_TRUE(decoder.chunked());
+    TEST_ASSERT_EQUAL_INT(-1, decoder.contentLength());
+}
+
+void test_decoder_chunked_header_case_and_lf_only(void) {
+    // Header names and values are case-insensitive; bare LF line endings and
+    // uppercase hex sizes are accepted.
+    std::string response =
+        "HTTP/1.1 200 OK\nTRANSFER-ENCODING:Chunked\nConnection:  Close \n\n"
+        "1F\n0123456789abcdef0123456789abcde\n0\n\n";
+    checkAllSplits(response, "0123456789abcdef0123456789abcde", true);
+
+    HttpResponseDecoder decoder;
+    decodeInPieces(decoder, response, 64);
+    TEST_ASSERT_FALSE(decoder.keepAlive());
+}
+
+void test_decoder_until_close(void) {
+    std::string response = "HTTP/1.0 200 OK\r\nServer: x\r\n\r\nbody without length";
+    checkAllSplits(response, "body without length", false);
+
+    HttpResponseDecoder decoder;
+    decodeInPieces(decoder, response, 4);
+    TEST_ASSERT_FALSE(decoder.keepAlive());
+    decoder.endOfInput();
+    TEST_ASSERT_TRUE(decoder.done());
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_NONE, decoder.error());
+}
+
+void test_decoder_skips_interim_response(void) {
+    std::string response =
+        "HTTP/1.1 100 Continue\r\n\r\n"
+        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+    checkAllSplits(response, "ok", true);
+}
+
+void test_decoder_no_body_statuses(void) {
+    HttpResponseDecoder decoder;
+    decodeInPieces(decoder, "HTTP/1.1 204 No Content\r\nConnection: keep-alive\r\n\r\n", 7);
+    TEST_ASSERT_TRUE(decoder.done());
+    TEST_ASSERT_EQUAL_INT(204, decoder.statusCode());
+    decodeInPieces(decoder, "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n", 7);
+    TEST_ASSERT_TRUE(decoder.done());
+    TEST_ASSERT_EQUAL_INT(500, decoder.statusCode());
+}
+
+void test_decoder_long_header_line_is_truncated(void) {
+    std::string response = "HTTP/1.1 200 OK\r\nSet-Cookie: " + std::string(1000, 'c') +
+                           "\r\nContent-Length: 4\r\n\r\nbody";
+    checkAllSplits(response, "body", true);
+}
+
+void test_decoder_malformed(void) {
+    HttpResponseDecoder decoder;
+    decodeInPieces(decoder, "ICY 200 OK\r\n\r\n", 3);
+    TEST_ASSERT_TRUE(decoder.failed());
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_BAD_STATUS, decoder.error());
+    TEST_ASSERT_FALSE(decoder.headersDone());
+
+    decodeInPieces(decoder, "HTTP/1.1 2OO OK\r\n\r\n", 3);
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_BAD_STATUS, decoder.error());
+
+    decodeInPieces(decoder, "HTTP/1.1 200 OK\r\nContent-Length: 12x\r\n\r\n", 3);
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_BAD_HEADER, decoder.error());
+
+    decodeInPieces(decoder, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 3);
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_BAD_CHUNK, decoder.error());
+
+    decodeInPieces(decoder, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nabX\r\n", 3);
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_BAD_CHUNK, decoder.error());
+
+    decodeInPieces(decoder, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n123456789\r\n", 3);
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_BAD_CHUNK, decoder.error());
+
+    decodeInPieces(decoder, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort", 3);
+    TEST_ASSERT_FALSE(decoder.done());
+    decoder.endOfInput();
+    TEST_ASSERT_EQUAL_INT(HTTP_ERR_CLOSED_EARLY, decoder.error());
+}
+
+// ============================================================================
+// Tests for HttpGetClient against a local server
+// ============================================================================
+
+// Blocking POSIX socket transport; reads report -1 once the peer closed.
+class PosixTransport : public HttpTransport {
+ public:
+    PosixTransport() : _fd(-1), _reads(0), _maxRead(0) {}
+
+    bool connect(const char* host, uint16_t port) override {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, host, &addr.sin_addr);
+        return _fd >= 0 && ::connect(_fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        return ::send(_fd, data, length, 0) == (ssize_t)length;
+    }
+
+    int read(uint8_t* buffer, size_t capacity) override {
+        if (_maxRead > 0 && capacity > _maxRead) capacity = _maxRead;
+        ssize_t n = ::recv(_fd, buffer, capacity, 0);
+        _reads++;
+        return (n > 0) ? (int)n : -1;
+    }
+
+    void close() override {
+        if (_fd >= 0) ::close(_fd);
+        _fd = -1;
+    }
+
+    int _fd;
+    int _reads;
+    size_t _maxRead;  // 0 = whatever the caller offers
+};
+
+// One-connection server: accepts, reads the request up to the blank line,
+// sends `response` in `piece`-sized writes and closes.
+class LocalServer {
+ public:
+    LocalServer() : port(0), _listen(-1) {
+        _listen = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(_listen, (sockaddr*)&addr, sizeof(addr));
+        socklen_t length = sizeof(addr);
+        getsockname(_listen, (sockaddr*)&addr, &length);
+        port = ntohs(addr.sin_port);
+        listen(_listen, 1);
+    }
+
+    ~LocalServer() {
+        if (_thread.joinable()) _thread.join();
+        ::close(_listen);
+    }
+
+    void serve(const std::string& response, size_t piece) {
+        _thread = std::thread([this, response, piece]() {
+            int fd = accept(_listen, NULL, NULL);
+            char buffer[512];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) break;
+                request.append(buffer, (size_t)n);
+            }
+            for (size_t pos = 0; pos < response.size(); pos += piece) {
+                size_t n = std::min(piece, response.size() - pos);
+                if (send(fd, response.data() + pos, n, MSG_NOSIGNAL) != (ssize_t)n) break;
+            }
+            ::close(fd);
+        });
+    }
+
+    void join() { _thread.join(); }
+
+    uint16_t port;
+    std::string request;
+
+ private:
+    int _listen;
+    std::thread _thread;
+};
+
+// get() + receive() feeding a DeparturePushParser, as FetchCycle does.
+static int fetchAndParse(HttpGetClient& client, LocalServer& server, DeparturesResultN<64>& result) {
+    static char element[4096];
+    uint8_t buffer[1024];
+    DeparturePushParser parser(result.departures, result.kCapacity, element, sizeof(element));
+    if (!client.get("127.0.0.1", server.port, "de:08311:6508", 10)) return client.resultCode();
+    for (int n; !parser.finished() && (n = client.receive(buffer, sizeof(buffer))) != -1;) {
+        if (client.response().statusCode() == 200) parser.feed(buffer, (size_t)n);
+    }
+    parser.finish();
+    result.count = parser.count();
+    result.error = parser.error();
+    result.success = (parser.error() == PARSE_OK);
+    int code = client.resultCode();
+    client.close();
+    server.join();
+    return code;
+}
+
+void test_client_sends_efa_request(void) {
+    LocalServer server;
+    server.serve("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n", 64);
+    PosixTransport transport;
+    HttpGetClient client(transport);
+    static DeparturesResultN<64> result;
+    TEST_ASSERT_EQUAL_INT(404, fetchAndParse(client, server, result));
+
+    char expected[HttpGetClient::kRequestCapacity];
+    buildEfaRequest(expected, sizeof(expected), "de:08311:6508", 10, false);
+    TEST_ASSERT_EQUAL_STRING(expected, server.request.c_str());
+}
+
+void test_client_push_parse_matches_direct_parse(void) {
+    // Chunked and Content-Length bodies, delivered in awkward piece sizes,
+    // parse the same as the raw body.
+    std::string body = buildEfaFixture(30);
+    static DeparturesResultN<64> direct;
+    parseDeparturesJsonIncremental(body.c_str(), direct);
+    TEST_ASSERT_TRUE(direct.success);
+
+    char contentLength[64];
+    snprintf(contentLength, sizeof(contentLength), "Content-Length: %zu\r\n\r\n", body.size());
+    const std::string responses[] = {
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n" + std::string(contentLength) + body,
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" + chunkedBody(body, 1000),
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" + chunkedBody(body, 7),
+        "HTTP/1.0 200 OK\r\n\r\n" + body,
+    };
+    const size_t pieces[] = {1, 13, 1460};
+
+    for (const std::string& response : responses) {
+        for (size_t piece : pieces) {
+            LocalServer server;
+            server.serve(response, piece);
+            PosixTransport transport;
+            HttpGetClient client(transport);
+            static DeparturesResultN<64> viaClient;
+            TEST_ASSERT_EQUAL_INT(200, fetchAndParse(client, server, viaClient));
+            TEST_ASSERT_TRUE(viaClient.success);
+            TEST_ASSERT_EQUAL_INT(direct.count, viaClient.count);
+            for (int i = 0; i < direct.count; i++) {
+                TEST_ASSERT_EQUAL_STRING(direct.departures[i].direction, viaClient.departures[i].direction);
+                TEST_ASSERT_EQUAL_INT(direct.departures[i].countdown, viaClient.departures[i].countdown);
+            }
+        }
+    }
+}
+
+void test_client_errors(void) {
+    PosixTransport transport;
+    HttpGetClient client(transport);
+
+    // Nothing listening on the port of a server that is already gone.
+    uint16_t closedPort;
+    {
+        LocalServer server;
+        closedPort = server.port;
+    }
+    TEST_ASSERT_FALSE(client.get("127.0.0.1", closedPort, "de:08311:6508", 10));
+    TEST_ASSERT_EQUAL_INT(-HTTP_ERR_CONNECT, client.resultCode());
+
+    std::string longId(400, '9');
+    TEST_ASSERT_FALSE(client.get("127.0.0.1", closedPort, longId.c_str(), 10));
+    TEST_ASSERT_EQUAL_INT(-HTTP_ERR_REQUEST_TOO_LONG, client.resultCode());
+
+    // Server hangs up in the middle of the headers.
+    LocalServer server;
+    server.serve("HTTP/1.1 200 OK\r\nContent-Le", 8);
+    static DeparturesResultN<64> result;
+    TEST_ASSERT_EQUAL_INT(-HTTP_ERR_CLOSED_EARLY, fetchAndParse(client, server, result));
+}
+
+// In-memory server that answers every request written to it with the next
+// scripted response on the same connection; dropped makes it look like the
+// server timed out the idle connection.
+class ScriptedTransport : public HttpTransport {
+ public:
+    ScriptedTransport() : connects(0), dropped(false), _next(0), _pos(0) {}
+
+    bool connect(const char* host, uint16_t port) override {
+        (void)host;
+        (void)port;
+        connects++;
+        dropped = false;
+        return true;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        if (dropped) return false;
+        requests.push_back(std::string((const char*)data, length));
+        _pending += responses[_next++ % responses.size()];
+        return true;
+    }
+
+    int read(uint8_t* buffer, size_t capacity) override {
+        size_t n = std::min(capacity, _pending.size() - _pos);
+        if (n == 0) return 0;
+        memcpy(buffer, _pending.data() + _pos, n);
+        _pos += n;
+        return (int)n;
+    }
+
+    void close() override {}
+
+    std::vector<std::string> responses;
+    std::vector<std::string> requests;
+    int connects;
+    bool dropped;
+
+ private:
+    size_t _next;
+    std::string _pending;
+    size_t _pos;
+};
+
+static int readBody(HttpGetClient& client, std::string& body) {
+    uint8_t buffer[64];
+    body.clear();
+    for (int n; (n = client.receive(buffer, sizeof(buffer))) != -1;) body.append((const char*)buffer, n);
+    return client.resultCode();
+}
+
+void test_client_keep_alive_reuses_connection(void) {
+    ScriptedTransport transport;
+    transport.responses.push_back("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nfirst");
+    transport.responses.push_back("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n6\r\nsecond\r\n0\r\n\r\n");
+    transport.responses.push_back("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 5\r\n\r\nthird");
+    HttpGetClient client(transport);
+    std::string body;
+
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, true));
+    TEST_ASSERT_FALSE(client.reused());
+    TEST_ASSERT_EQUAL_INT(200, readBody(client, body));
+    TEST_ASSERT_EQUAL_STRING("first", body.c_str());
+    TEST_ASSERT_TRUE(client.reusable());
+    TEST_ASSERT_NOT_NULL(strstr(transport.requests[0].c_str(), "Connection: keep-alive\r\n"));
+
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, true));
+    TEST_ASSERT_TRUE(client.reused());
+    TEST_ASSERT_EQUAL_INT(200, readBody(client, body));
+    TEST_ASSERT_EQUAL_STRING("second", body.c_str());
+    TEST_ASSERT_EQUAL_INT(1, transport.connects);
+
+    // "Connection: close" ends reuse.
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, true));
+    TEST_ASSERT_EQUAL_INT(200, readBody(client, body));
+    TEST_ASSERT_FALSE(client.reusable());
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, true));
+    TEST_ASSERT_FALSE(client.reused());
+    TEST_ASSERT_EQUAL_INT(2, transport.connects);
+    readBody(client, body);
+
+    // An idle connection the server dropped is replaced transparently.
+    transport.dropped = true;
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, true));
+    TEST_ASSERT_FALSE(client.reused());
+    TEST_ASSERT_EQUAL_INT(3, transport.connects);
+    TEST_ASSERT_EQUAL_INT(200, readBody(client, body));
+
+    // A response not read to its end is never reused, nor without keepAlive.
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, true));
+    TEST_ASSERT_FALSE(client.reusable());
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, true));
+    TEST_ASSERT_FALSE(client.reused());
+    readBody(client, body);
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", 80, "6906508", 10, false));
+    TEST_ASSERT_FALSE(client.reused());
+    TEST_ASSERT_EQUAL_INT(5, transport.connects);
+}
+
+void test_client_throughput(void) {
+    // Not a pass/fail benchmark: prints what the client and decoder manage
+    // over loopback so regressions show up in the test log.
+    std::string body = buildEfaFixture(60);
+    body.append((1u << 20) - body.size(), ' ');
+    std::string response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" + chunkedBody(body, 1400);
+
+    LocalServer server;
+    server.serve(response, 1460);
+    PosixTransport transport;
+    HttpGetClient client(transport);
+
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(client.get("127.0.0.1", server.port, "de:08311:6508", 10));
+    uint8_t sink[1024];
+    size_t received = 0;
+    for (int n; (n = client.receive(sink, sizeof(sink))) != -1;) received += (size_t)n;
+    TEST_ASSERT_EQUAL_INT(200, client.resultCode());
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    client.close();
+    server.join();
+
+    TEST_ASSERT_EQUAL_INT(body.size(), received);
+    TEST_ASSERT_TRUE(client.response().done());
+    printf("http_client: %zu body bytes in %.1f ms (%.1f MB/s), %d socket reads\n", received, seconds * 1000,
+           received / seconds / 1e6, transport._reads);
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_decoder_content_length);
+    RUN_TEST(test_decoder_ignores_bytes_after_body);
+    RUN_TEST(test_decoder_chunked);
+    RUN_TEST(test_decoder_chunked_header_case_and_lf_only);
+    RUN_TEST(test_decoder_until_close);
+    RUN_TEST(test_decoder_skips_interim_response);
+    RUN_TEST(test_decoder_no_body_statuses);
+    RUN_TEST(test_decoder_long_header_line_is_truncated);
+    RUN_TEST(test_decoder_malformed);
+
+    RUN_TEST(test_client_sends_efa_request);
+    RUN_TEST(test_client_push_parse_matches_direct_parse);
+    RUN_TEST(test_client_errors);
+    RUN_TEST(test_client_keep_alive_reuses_connection);
+    RUN_TEST(test_client_throughput);
+
+    return UNITY_END();
+}
@@ -0,0 +1,119 @@
+#include <unity.h>
+#include "../../src/json_skip.h"
+#include <string.h>
+#include <random>
+#include <string>
+
+// Skip `value + tail` fed as two spans split at every offset; the skipper
+// must stop exactly after value and leave tail untouched.
+static void checkAllSplits(const std::string& value, const std::string& tail) {
+    std::string input = value + tail;
+    const uint8_t* data = (const uint8_t*)input.data();
+    for (size_t split = 0; split <= input.size(); split++) {
+        JsonSkipper skipper;
+        size_t consumed = skipper.scan(data, split);
+        if (!skipper.done()) consumed += skipper.scan(data + consumed, input.size() - consumed);
+        TEST_ASSERT_TRUE(skipper.done());
+        TEST_ASSERT_EQUAL_INT(value.size(), consumed);
+        TEST_ASSERT_EQUAL_INT(0, skipper.depth());
+        TEST_ASSERT_FALSE(skipper.inString());
+    }
+}
+
+// ============================================================================
+// Tests for JsonSkipper
+// ============================================================================
+
+void test_skip_plain_object_and_array(void) {
+    checkAllSplits("{\"a\": 1, \"b\": [1, 2, {\"c\": null}], \"d\": {}}", ", \"next\": 2}");
+    checkAllSplits("[[], [[]], {\"k\": [true, false]}]", "]");
+    checkAllSplits("{}", ",");
+}
+
+void test_skip_brackets_inside_strings(void) {
+    checkAllSplits("{\"name\": \"Line [x] {y}\", \"desc\": \"]]]}}}\"}", ", \"departureList\": []}");
+    checkAllSplits("[\"{\", \"[\", \"}}\", \"]\"]", "}");
+}
+
+void test_skip_escapes(void) {
+    // Escaped quotes do not end the string; an escaped backslash does not
+    // escape the quote after it.
+    checkAllSplits("{\"q\": \"say \\\"hi\\\" ]}\"}", ",");
+    checkAllSplits("{\"path\": \"C:\\\\\", \"x\": \"\\\\\\\"}\"}", ",");
+    checkAllSplits("[\"\\u005D\", \"\\/\", \"\\\\]\"]", ",");
+}
+
+void test_skip_bare_string(void) {
+    checkAllSplits("\"just a [string] with \\\" inside\"", ", \"k\": 1");
+    checkAllSplits("\"\"", ",");
+}
+
+void test_skip_long_runs_use_words(void) {
+    // Runs far longer than a word on both sides of every state change, and
+    // stops sitting at every alignment within a word.
+    std::string filler(200, 'x');
+    for (size_t pad = 0; pad < 16; pad++) {
+        std::string value = "{\"" + std::string(pad, 'k') + "\": \"" + filler + "\\\"" + filler + "\", \"l\": [" +
+                            std::string(pad, ' ') + filler.substr(0, 3) + "]}";
+        checkAllSplits(value, " ,\"tail\": \"}\"");
+    }
+}
+
+void test_skip_incomplete_value(void) {
+    JsonSkipper skipper;
+    const char* text = "{\"a\": [1, 2, \"open \\";
+    TEST_ASSERT_EQUAL_INT(strlen(text), skipper.scan((const uint8_t*)text, strlen(text)));
+    TEST_ASSERT_FALSE(skipper.done());
+    TEST_ASSERT_EQUAL_INT(2, skipper.depth());
+    TEST_ASSERT_TRUE(skipper.inString());
+
+    // The dangling escape swallows the quote at the start of the next span.
+    const char* rest = "\"\"]}x";
+    TEST_ASSERT_EQUAL_INT(4, skipper.scan((const uint8_t*)rest, strlen(rest)));
+    TEST_ASSERT_TRUE(skipper.done());
+}
+
+void test_skip_matches_bytewise_on_random_input(void) {
+    // Random soup dense in the bytes that matter, fed in random span sizes to
+    // both scan() and scanBytewise(): consumed counts and states must agree.
+    const char alphabet[] = "{}[]\"\\\\\"ab ,:{[";
+    std::mt19937 rng(1234);
+    for (int round = 0; round < 2000; round++) {
+        std::string input = "{";
+        size_t length = 1 + rng() % 300;
+        for (size_t i = 0; i < length; i++) input += alphabet[rng() % (sizeof(alphabet) - 1)];
+        const uint8_t* data = (const uint8_t*)input.data();
+
+        JsonSkipper fast, reference;
+        size_t fastPos = 0, referencePos = 0;
+        while (fastPos < input.size() && !fast.done()) {
+            size_t span = 1 + rng() % 40;
+            if (span > input.size() - fastPos) span = input.size() - fastPos;
+            fastPos += fast.scan(data + fastPos, span);
+        }
+        referencePos = reference.scanBytewise(data, input.size());
+
+        TEST_ASSERT_EQUAL_INT(referencePos, fastPos);
+        TEST_ASSERT_EQUAL_INT(reference.done(), fast.done());
+        TEST_ASSERT_EQUAL_INT(reference.depth(), fast.depth());
+        TEST_ASSERT_EQUAL_INT(reference.inString(), fast.inString());
+    }
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_skip_plain_object_and_array);
+    RUN_TEST(test_skip_brackets_inside_strings);
+    RUN_TEST(test_skip_escapes);
+    RUN_TEST(test_skip_bare_string);
+    RUN_TEST(test_skip_long_runs_use_words);
+    RUN_TEST(test_skip_incomplete_value);
+    RUN_TEST(test_skip_matches_bytewise_on_random_input);
+
+    return UNITY_END();
+}
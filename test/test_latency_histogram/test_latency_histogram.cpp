@@ -0,0 +1,259 @@
+#include <unity.h>
+#include "../../src/latency_histogram.h"
+#include <string.h>
+#include <string>
+
+// ============================================================================
+// Tests for the bucket layout
+// ============================================================================
+
+void test_latencyBucketFor_small_values(void) {
+    TEST_ASSERT_EQUAL_INT(0, latencyBucketFor(0));
+    TEST_ASSERT_EQUAL_INT(1, latencyBucketFor(1));
+    TEST_ASSERT_EQUAL_INT(2, latencyBucketFor(2));
+    TEST_ASSERT_EQUAL_INT(3, latencyBucketFor(3));
+    TEST_ASSERT_EQUAL_INT(4, latencyBucketFor(4));
+    TEST_ASSERT_EQUAL_INT(4, latencyBucketFor(5));
+    TEST_ASSERT_EQUAL_INT(5, latencyBucketFor(6));
+    TEST_ASSERT_EQUAL_INT(5, latencyBucketFor(7));
+    TEST_ASSERT_EQUAL_INT(6, latencyBucketFor(8));
+}
+
+void test_latencyBucketFor_saturates(void) {
+    TEST_ASSERT_EQUAL_INT(LATENCY_BUCKETS - 1, latencyBucketFor(49152));
+    TEST_ASSERT_EQUAL_INT(LATENCY_BUCKETS - 1, latencyBucketFor(600000));
+    TEST_ASSERT_EQUAL_INT(LATENCY_BUCKETS - 1, latencyBucketFor(UINT32_MAX));
+    TEST_ASSERT_EQUAL_INT(LATENCY_BUCKETS - 2, latencyBucketFor(49151));
+}
+
+void test_latencyBucket_bounds_are_contiguous(void) {
+    // Every bucket's bounds map back to it and the next bucket starts right
+    // after the previous one ends.
+    TEST_ASSERT_EQUAL_UINT32(0, latencyBucketLowerMs(0));
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        TEST_ASSERT_EQUAL_INT(b, latencyBucketFor(latencyBucketLowerMs(b)));
+        TEST_ASSERT_EQUAL_INT(b, latencyBucketFor(latencyBucketUpperMs(b)));
+        if (b + 1 < LATENCY_BUCKETS) {
+            TEST_ASSERT_EQUAL_UINT32(latencyBucketUpperMs(b) + 1, latencyBucketLowerMs(b + 1));
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, latencyBucketUpperMs(LATENCY_BUCKETS - 1));
+}
+
+// ============================================================================
+// Tests for latencyRecord / latencyPercentileMs
+// ============================================================================
+
+void test_latencyRecord_counts(void) {
+    LatencyHistograms hist;
+    latencyInit(&hist);
+    TEST_ASSERT_TRUE(latencyIsValid(&hist));
+    latencyRecord(&hist, LATENCY_PARSE, 40);
+    latencyRecord(&hist, LATENCY_PARSE, 41);
+    latencyRecord(&hist, LATENCY_TOTAL, 4000);
+    latencyRecord(&hist, LATENCY_METRIC_COUNT, 1);  // ignored
+    TEST_ASSERT_EQUAL_UINT32(2, latencySampleCount(&hist, LATENCY_PARSE));
+    TEST_ASSERT_EQUAL_UINT32(1, latencySampleCount(&hist, LATENCY_TOTAL));
+    TEST_ASSERT_EQUAL_UINT32(0, latencySampleCount(&hist, LATENCY_WIFI_CONNECT));
+    TEST_ASSERT_EQUAL_UINT32(2, hist.counts[LATENCY_PARSE][latencyBucketFor(40)]);
+}
+
+void test_latencyPercentileMs_empty(void) {
+    LatencyHistograms hist;
+    latencyInit(&hist);
+    TEST_ASSERT_EQUAL_UINT32(0, latencyPercentileMs(&hist, LATENCY_TOTAL, 50));
+}
+
+void test_latencyPercentileMs_p50_p99(void) {
+    // 98 fast connects around 1 s, two slow ones around 9 s.
+    LatencyHistograms hist;
+    latencyInit(&hist);
+    for (int i = 0; i < 98; i++) latencyRecord(&hist, LATENCY_WIFI_CONNECT, 1000 + i);
+    latencyRecord(&hist, LATENCY_WIFI_CONNECT, 9000);
+    latencyRecord(&hist, LATENCY_WIFI_CONNECT, 9100);
+
+    uint32_t p50 = latencyPercentileMs(&hist, LATENCY_WIFI_CONNECT, 50);
+    uint32_t p99 = latencyPercentileMs(&hist, LATENCY_WIFI_CONNECT, 99);
+    // Reported as the bucket's upper bound: never below, at most ~41% above.
+    TEST_ASSERT_TRUE(p50 >= 1097 && p50 <= 1097 * 1.42);
+    TEST_ASSERT_TRUE(p99 >= 9100 && p99 <= 9100 * 1.42);
+    TEST_ASSERT_EQUAL_UINT32(p99, latencyPercentileMs(&hist, LATENCY_WIFI_CONNECT, 100));
+    TEST_ASSERT_EQUAL_UINT32(latencyBucketUpperMs(latencyBucketFor(1000)),
+                             latencyPercentileMs(&hist, LATENCY_WIFI_CONNECT, 0));
+}
+
+// ============================================================================
+// Tests for latencyMerge
+// ============================================================================
+
+void test_latencyMerge_adds_counts_and_boots(void) {
+    LatencyHistograms a, b;
+    latencyInit(&a);
+    latencyInit(&b);
+    a.boots = 3;
+    b.boots = 4;
+    latencyRecord(&a, LATENCY_TOTAL, 5000);
+    latencyRecord(&b, LATENCY_TOTAL, 5000);
+    latencyRecord(&b, LATENCY_PARSE, 30);
+    latencyMerge(&a, &b);
+    TEST_ASSERT_EQUAL_UINT32(7, a.boots);
+    TEST_ASSERT_EQUAL_UINT32(2, a.counts[LATENCY_TOTAL][latencyBucketFor(5000)]);
+    TEST_ASSERT_EQUAL_UINT32(1, latencySampleCount(&a, LATENCY_PARSE));
+}
+
+void test_latencyMerge_saturates(void) {
+    LatencyHistograms a, b;
+    latencyInit(&a);
+    latencyInit(&b);
+    a.counts[LATENCY_PARSE][3] = UINT32_MAX - 1;
+    b.counts[LATENCY_PARSE][3] = 5;
+    latencyMerge(&a, &b);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, a.counts[LATENCY_PARSE][3]);
+}
+
+// ============================================================================
+// Tests for latencyFormatDump / latencyParseDump
+// ============================================================================
+
+static void fillSample(LatencyHistograms* hist) {
+    latencyInit(hist);
+    hist->boots = 12;
+    for (int i = 0; i < 12; i++) {
+        latencyRecord(hist, LATENCY_WIFI_CONNECT, 900 + 100 * i);
+        latencyRecord(hist, LATENCY_FIRST_BYTE, 300 + 7 * i);
+        latencyRecord(hist, LATENCY_TOTAL, 3000 + 250 * i);
+    }
+    latencyRecord(hist, LATENCY_PARSE, 0);
+    latencyRecord(hist, LATENCY_PARSE, 120000);
+}
+
+void test_latencyFormatDump_layout(void) {
+    LatencyHistograms hist;
+    latencyInit(&hist);
+    hist.boots = 2;
+    latencyRecord(&hist, LATENCY_PARSE, 3);
+    latencyRecord(&hist, LATENCY_PARSE, 3);
+    char buffer[512];
+    size_t n = latencyFormatDump(&hist, "a1b2", buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_INT(strlen(buffer), n);
+    TEST_ASSERT_EQUAL_STRING(
+        "LATENCY v1 unit=a1b2 boots=2\n"
+        "wifi-connect\n"
+        "first-byte\n"
+        "body-transfer\n"
+        "parse 3:2\n"
+        "total\n"
+        "END\n",
+        buffer);
+}
+
+void test_latencyFormatDump_too_small(void) {
+    LatencyHistograms hist;
+    fillSample(&hist);
+    char buffer[512];
+    size_t needed = latencyFormatDump(&hist, "unit", buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(needed > 0);
+    TEST_ASSERT_EQUAL_INT(needed, latencyFormatDump(&hist, "unit", buffer, needed + 1));
+    TEST_ASSERT_EQUAL_INT(0, latencyFormatDump(&hist, "unit", buffer, needed));
+    TEST_ASSERT_EQUAL_STRING("", buffer);
+}
+
+void test_latencyFormatDump_worst_case_fits_dump_capacity(void) {
+    LatencyHistograms hist;
+    latencyInit(&hist);
+    hist.boots = UINT32_MAX;
+    for (int m = 0; m < LATENCY_METRIC_COUNT; m++) {
+        for (int b = 0; b < LATENCY_BUCKETS; b++) hist.counts[m][b] = UINT32_MAX;
+    }
+    char unit[LATENCY_UNIT_ID_SIZE];
+    memset(unit, 'u', sizeof(unit) - 1);
+    unit[sizeof(unit) - 1] = '\0';
+    static char buffer[LATENCY_DUMP_CAPACITY];
+    TEST_ASSERT_TRUE(latencyFormatDump(&hist, unit, buffer, sizeof(buffer)) > 0);
+}
+
+void test_latencyParseDump_round_trip(void) {
+    LatencyHistograms hist, parsed;
+    fillSample(&hist);
+    char buffer[1024];
+    latencyFormatDump(&hist, "unit", buffer, sizeof(buffer));
+
+    char unit[LATENCY_UNIT_ID_SIZE];
+    const char* end = latencyParseDump(buffer, &parsed, unit);
+    TEST_ASSERT_NOT_NULL(end);
+    TEST_ASSERT_EQUAL_INT(0, *end);
+    TEST_ASSERT_EQUAL_STRING("unit", unit);
+    TEST_ASSERT_TRUE(latencyIsValid(&parsed));
+    TEST_ASSERT_EQUAL_UINT32(12, parsed.boots);
+    TEST_ASSERT_EQUAL_MEMORY(hist.counts, parsed.counts, sizeof(hist.counts));
+}
+
+void test_latencyParseDump_finds_dumps_in_serial_log(void) {
+    // A captured monitor session: boot noise, two dumps (one with CRLF line
+    // endings), a broken one and more noise.
+    LatencyHistograms one, two;
+    fillSample(&one);
+    latencyInit(&two);
+    latencyRecord(&two, LATENCY_TOTAL, 2500);
+    char dumpOne[1024], dumpTwo[1024];
+    latencyFormatDump(&one, "unit-1", dumpOne, sizeof(dumpOne));
+    latencyFormatDump(&two, "unit-2", dumpTwo, sizeof(dumpTwo));
+    std::string crlf;
+    for (const char* p = dumpTwo; *p; p++) crlf += (*p == '\n') ? std::string("\r\n") : std::string(1, *p);
+
+    std::string log = std::string("=== Starting VAG Departure Display ===\n   OK\n") + dumpOne +
+                      "   [power] shutdown\nLATENCY v1 unit=x boots=1\nwifi-connect 3:oops\nEND\n" + crlf +
+                      "LATENCY v9 unit=future boots=1\nEND\n";
+
+    LatencyHistograms merged, parsed;
+    latencyInit(&merged);
+    int dumps = 0;
+    char units[2][LATENCY_UNIT_ID_SIZE];
+    char unit[LATENCY_UNIT_ID_SIZE];
+    for (const char* p = log.c_str(); (p = latencyParseDump(p, &parsed, unit)) != NULL; dumps++) {
+        latencyMerge(&merged, &parsed);
+        if (dumps < 2) memcpy(units[dumps], unit, sizeof(unit));
+    }
+    TEST_ASSERT_EQUAL_INT(2, dumps);
+    TEST_ASSERT_EQUAL_STRING("unit-1", units[0]);
+    TEST_ASSERT_EQUAL_STRING("unit-2", units[1]);
+    TEST_ASSERT_EQUAL_UINT32(12 + 1, latencySampleCount(&merged, LATENCY_TOTAL));
+    TEST_ASSERT_EQUAL_UINT32(12, latencySampleCount(&merged, LATENCY_WIFI_CONNECT));
+}
+
+void test_latencyParseDump_incomplete(void) {
+    LatencyHistograms parsed;
+    TEST_ASSERT_NULL(latencyParseDump("no dump here", &parsed, NULL));
+    TEST_ASSERT_NULL(latencyParseDump("LATENCY v1 unit=x boots=1\nparse 3:2\n", &parsed, NULL));
+    TEST_ASSERT_NULL(latencyParseDump("LATENCY v1 unit=x boots=1\nparse 99:2\nEND\n", &parsed, NULL));
+
+    // A header without a unit id still parses, as unit "-".
+    char unit[LATENCY_UNIT_ID_SIZE];
+    TEST_ASSERT_NOT_NULL(latencyParseDump("LATENCY v1 boots=1\nparse 3:2\nEND\n", &parsed, unit));
+    TEST_ASSERT_EQUAL_STRING("-", unit);
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_latencyBucketFor_small_values);
+    RUN_TEST(test_latencyBucketFor_saturates);
+    RUN_TEST(test_latencyBucket_bounds_are_contiguous);
+    RUN_TEST(test_latencyRecord_counts);
+    RUN_TEST(test_latencyPercentileMs_empty);
+    RUN_TEST(test_latencyPercentileMs_p50_p99);
+    RUN_TEST(test_latencyMerge_adds_counts_and_boots);
+    RUN_TEST(test_latencyMerge_saturates);
+    RUN_TEST(test_latencyFormatDump_layout);
+    RUN_TEST(test_latencyFormatDump_too_small);
+    RUN_TEST(test_latencyFormatDump_worst_case_fits_dump_capacity);
+    RUN_TEST(test_latencyParseDump_round_trip);
+    RUN_TEST(test_latencyParseDump_finds_dumps_in_serial_log);
+    RUN_TEST(test_latencyParseDump_incomplete);
+
+    return UNITY_END();
+}
@@ -0,0 +1,185 @@
+#include <unity.h>
+#include "../../src/limit_estimator.h"
+#include <math.h>
+
+static const LimitPolicy kPolicy = {3, 90, 15, 30};
+
+// History of total entries with a pass fraction of passed/seen.
+static LimitEstimator history(int seen, int passed) {
+    LimitEstimator est;
+    limitEstimatorInit(&est);
+    est.seen = seen;
+    est.passed = passed;
+    est.fetches = 1;
+    return est;
+}
+
+// ============================================================================
+// Tests for recording
+// ============================================================================
+
+void test_limit_estimator_init_and_validity(void) {
+    LimitEstimator est;
+    limitEstimatorInit(&est);
+    TEST_ASSERT_TRUE(limitEstimatorIsValid(&est));
+    TEST_ASSERT_EQUAL_UINT32(0, est.seen);
+
+    est.version++;
+    TEST_ASSERT_FALSE(limitEstimatorIsValid(&est));
+    est = history(10, 11);  // corrupt: more passed than seen
+    TEST_ASSERT_FALSE(limitEstimatorIsValid(&est));
+}
+
+void test_limit_estimator_record_decays_and_keeps_fraction(void) {
+    LimitEstimator est;
+    limitEstimatorInit(&est);
+    for (int i = 0; i < 100; i++) limitEstimatorRecord(&est, 15, 5, i % 10 == 0);
+    TEST_ASSERT_TRUE(est.seen <= LIMIT_ESTIMATOR_WINDOW);
+    TEST_ASSERT_TRUE(est.seen > LIMIT_ESTIMATOR_WINDOW / 2);
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 1.0 / 3.0, (double)est.passed / est.seen);
+    TEST_ASSERT_EQUAL_UINT32(100, est.fetches);
+    TEST_ASSERT_EQUAL_UINT32(10, est.secondFetches);
+
+    // A changed filter takes over within a window's worth of entries.
+    for (int i = 0; i < 40; i++) limitEstimatorRecord(&est, 15, 15, false);
+    TEST_ASSERT_TRUE((double)est.passed / est.seen > 0.9);
+}
+
+void test_limit_estimator_record_clamps_bad_counts(void) {
+    LimitEstimator est;
+    limitEstimatorInit(&est);
+    limitEstimatorRecord(&est, 5, 9, false);
+    limitEstimatorRecord(&est, -1, -1, false);
+    TEST_ASSERT_EQUAL_UINT32(5, est.seen);
+    TEST_ASSERT_EQUAL_UINT32(5, est.passed);
+    TEST_ASSERT_TRUE(limitEstimatorIsValid(&est));
+}
+
+// ============================================================================
+// Tests for the fill probability
+// ============================================================================
+
+void test_limit_estimator_probability_edges(void) {
+    LimitEstimator est = history(100, 50);
+    TEST_ASSERT_EQUAL_FLOAT(1.0, limitEstimatorFillProbability(&est, 5, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.0, limitEstimatorFillProbability(&est, 2, 3));
+
+    // No history: uniform fraction, so P(at least 1 of 1) is 1/2 and
+    // P(at least 3 of n) is (n - 2) / (n + 1).
+    LimitEstimator empty;
+    limitEstimatorInit(&empty);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.5, limitEstimatorFillProbability(&empty, 1, 1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 8.0 / 11.0, limitEstimatorFillProbability(&empty, 10, 3));
+}
+
+void test_limit_estimator_probability_approaches_binomial(void) {
+    // With a long history the fraction is nearly certain: P(at least 3 of 6)
+    // at p = 1/2 is 42/64.
+    LimitEstimator est = history(200000, 100000);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 42.0 / 64.0, limitEstimatorFillProbability(&est, 6, 3));
+
+    // All-pass and all-fail histories, without underflow.
+    LimitEstimator all = history(200, 200);
+    TEST_ASSERT_TRUE(limitEstimatorFillProbability(&all, 3, 3) > 0.95);
+    LimitEstimator none = history(200, 0);
+    TEST_ASSERT_TRUE(limitEstimatorFillProbability(&none, 30, 3) < 0.01);
+}
+
+void test_limit_estimator_probability_monotonic(void) {
+    LimitEstimator est = history(60, 12);
+    double previous = 0.0;
+    for (int limit = 3; limit <= 60; limit++) {
+        double p = limitEstimatorFillProbability(&est, limit, 3);
+        TEST_ASSERT_TRUE(p >= previous);
+        TEST_ASSERT_TRUE(p <= 1.0);
+        previous = p;
+    }
+}
+
+// ============================================================================
+// Tests for choosing limits
+// ============================================================================
+
+void test_limit_estimator_choose_cold_start_uses_default(void) {
+    LimitEstimator est;
+    limitEstimatorInit(&est);
+    TEST_ASSERT_EQUAL_INT(15, limitEstimatorChoose(&est, &kPolicy));
+    LimitPolicy small = {3, 90, 50, 30};
+    TEST_ASSERT_EQUAL_INT(30, limitEstimatorChoose(&est, &small));
+}
+
+void test_limit_estimator_choose_is_smallest_confident_limit(void) {
+    const int fractions[][2] = {{200, 200}, {200, 150}, {200, 100}, {200, 50}, {30, 10}};
+    for (size_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++) {
+        LimitEstimator est = history(fractions[i][0], fractions[i][1]);
+        int limit = limitEstimatorChoose(&est, &kPolicy);
+        TEST_ASSERT_TRUE(limit >= kPolicy.rows && limit <= kPolicy.maxLimit);
+        TEST_ASSERT_TRUE(limitEstimatorFillProbability(&est, limit, 3) >= 0.9);
+        if (limit > kPolicy.rows) TEST_ASSERT_TRUE(limitEstimatorFillProbability(&est, limit - 1, 3) < 0.9);
+    }
+
+    // Everything passes: three entries fill three rows.
+    LimitEstimator all = history(200, 200);
+    TEST_ASSERT_EQUAL_INT(3, limitEstimatorChoose(&all, &kPolicy));
+}
+
+void test_limit_estimator_choose_orders(void) {
+    // Rarer passes, higher confidence and a shorter history all ask for more.
+    LimitEstimator common = history(200, 100);
+    LimitEstimator rare = history(200, 40);
+    LimitEstimator shortHistory = history(10, 5);
+    LimitPolicy sure = kPolicy;
+    sure.confidencePercent = 99;
+    int base = limitEstimatorChoose(&common, &kPolicy);
+    TEST_ASSERT_TRUE(limitEstimatorChoose(&rare, &kPolicy) > base);
+    TEST_ASSERT_TRUE(limitEstimatorChoose(&common, &sure) > base);
+    TEST_ASSERT_TRUE(limitEstimatorChoose(&shortHistory, &kPolicy) > base);
+}
+
+void test_limit_estimator_choose_caps_at_max(void) {
+    LimitEstimator none = history(200, 1);
+    TEST_ASSERT_EQUAL_INT(kPolicy.maxLimit, limitEstimatorChoose(&none, &kPolicy));
+}
+
+void test_limit_estimator_second_limit(void) {
+    LimitEstimator est = history(200, 50);
+
+    // Filled, or nothing more to ask for: no second request.
+    TEST_ASSERT_EQUAL_INT(0, limitEstimatorSecondLimit(&est, &kPolicy, 10, 3));
+    TEST_ASSERT_EQUAL_INT(0, limitEstimatorSecondLimit(&est, &kPolicy, 30, 1));
+
+    // One row short needs fewer extra entries than three rows short, and the
+    // extra entries reach the confidence for the rows still missing.
+    int oneShort = limitEstimatorSecondLimit(&est, &kPolicy, 10, 2);
+    int allShort = limitEstimatorSecondLimit(&est, &kPolicy, 10, 0);
+    TEST_ASSERT_TRUE(oneShort > 10);
+    TEST_ASSERT_TRUE(allShort > oneShort);
+    TEST_ASSERT_TRUE(limitEstimatorFillProbability(&est, oneShort - 10, 1) >= 0.9);
+    TEST_ASSERT_TRUE(limitEstimatorFillProbability(&est, oneShort - 11, 1) < 0.9);
+
+    // Bounded by maxLimit.
+    LimitEstimator rare = history(200, 2);
+    TEST_ASSERT_EQUAL_INT(kPolicy.maxLimit, limitEstimatorSecondLimit(&rare, &kPolicy, 20, 0));
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_limit_estimator_init_and_validity);
+    RUN_TEST(test_limit_estimator_record_decays_and_keeps_fraction);
+    RUN_TEST(test_limit_estimator_record_clamps_bad_counts);
+    RUN_TEST(test_limit_estimator_probability_edges);
+    RUN_TEST(test_limit_estimator_probability_approaches_binomial);
+    RUN_TEST(test_limit_estimator_probability_monotonic);
+    RUN_TEST(test_limit_estimator_choose_cold_start_uses_default);
+    RUN_TEST(test_limit_estimator_choose_is_smallest_confident_limit);
+    RUN_TEST(test_limit_estimator_choose_orders);
+    RUN_TEST(test_limit_estimator_choose_caps_at_max);
+    RUN_TEST(test_limit_estimator_second_limit);
+
+    return UNITY_END();
+}
@@ -0,0 +1,155 @@
+#include <unity.h>
+#include "../../src/power_governor.h"
+
+// ============================================================================
+// Tests for powerPolicyFor
+// ============================================================================
+
+void test_powerPolicyFor_clock_steps(void) {
+    // Every phase uses a valid ESP32 step that still supports WiFi.
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        uint16_t mhz = powerPolicyFor((BootPhase)p)->cpuMhz;
+        TEST_ASSERT_TRUE(mhz == 80 || mhz == 160 || mhz == 240);
+    }
+}
+
+void test_powerPolicyFor_full_clock_for_bursts(void) {
+    TEST_ASSERT_EQUAL_INT(240, powerPolicyFor(PHASE_RECEIVE)->cpuMhz);
+    TEST_ASSERT_EQUAL_INT(240, powerPolicyFor(PHASE_RENDER)->cpuMhz);
+}
+
+void test_powerPolicyFor_low_clock_while_waiting(void) {
+    TEST_ASSERT_EQUAL_INT(80, powerPolicyFor(PHASE_WIFI_CONNECT)->cpuMhz);
+    TEST_ASSERT_EQUAL_INT(80, powerPolicyFor(PHASE_HTTP_WAIT)->cpuMhz);
+    TEST_ASSERT_EQUAL_INT(80, powerPolicyFor(PHASE_DISPLAY_HOLD)->cpuMhz);
+}
+
+void test_powerPolicyFor_sleep_modes(void) {
+    // No modem sleep while the body streams in; light sleep only once the
+    // radio is off and the panel is just holding its image.
+    TEST_ASSERT_FALSE(powerPolicyFor(PHASE_RECEIVE)->modemSleep);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        TEST_ASSERT_EQUAL(p == PHASE_DISPLAY_HOLD, powerPolicyFor((BootPhase)p)->lightSleep);
+    }
+}
+
+void test_powerPolicyFor_out_of_range(void) {
+    TEST_ASSERT_EQUAL_PTR(powerPolicyFor(PHASE_BOOT), powerPolicyFor(PHASE_COUNT));
+    TEST_ASSERT_EQUAL_PTR(powerPolicyFor(PHASE_BOOT), powerPolicyFor((BootPhase)-1));
+    TEST_ASSERT_EQUAL_STRING("?", bootPhaseName(PHASE_COUNT));
+    TEST_ASSERT_EQUAL_STRING("wifi-connect", bootPhaseName(PHASE_WIFI_CONNECT));
+}
+
+// ============================================================================
+// Tests for powerGovernorEnter
+// ============================================================================
+
+void test_powerGovernorEnter_first_phase_applies_all(void) {
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    TEST_ASSERT_EQUAL_HEX8(POWER_CHANGE_ALL, powerGovernorEnter(&gov, PHASE_BOOT, 5));
+    TEST_ASSERT_EQUAL_INT(1, gov.logCount);
+    TEST_ASSERT_EQUAL_INT(PHASE_BOOT, gov.log[0].phase);
+    TEST_ASSERT_EQUAL_UINT32(5, gov.log[0].atMs);
+}
+
+void test_powerGovernorEnter_reports_only_differences(void) {
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    powerGovernorEnter(&gov, PHASE_BOOT, 0);
+    TEST_ASSERT_EQUAL_HEX8(0, powerGovernorEnter(&gov, PHASE_WIFI_CONNECT, 10));
+    TEST_ASSERT_EQUAL_HEX8(0, powerGovernorEnter(&gov, PHASE_HTTP_WAIT, 20));
+    TEST_ASSERT_EQUAL_HEX8(POWER_CHANGE_CPU | POWER_CHANGE_MODEM_SLEEP, powerGovernorEnter(&gov, PHASE_RECEIVE, 30));
+    TEST_ASSERT_EQUAL_HEX8(POWER_CHANGE_MODEM_SLEEP, powerGovernorEnter(&gov, PHASE_RENDER, 40));
+    TEST_ASSERT_EQUAL_HEX8(POWER_CHANGE_CPU | POWER_CHANGE_LIGHT_SLEEP, powerGovernorEnter(&gov, PHASE_DISPLAY_HOLD, 50));
+    TEST_ASSERT_EQUAL_HEX8(POWER_CHANGE_LIGHT_SLEEP, powerGovernorEnter(&gov, PHASE_SHUTDOWN, 60));
+    TEST_ASSERT_EQUAL_INT(7, gov.logCount);
+}
+
+void test_powerGovernorEnter_same_phase_not_logged(void) {
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    powerGovernorEnter(&gov, PHASE_HTTP_WAIT, 0);
+    TEST_ASSERT_EQUAL_HEX8(0, powerGovernorEnter(&gov, PHASE_HTTP_WAIT, 100));
+    TEST_ASSERT_EQUAL_INT(1, gov.logCount);
+}
+
+void test_powerGovernorEnter_retry_goes_back(void) {
+    // A failed attempt drops from receive back to waiting on the server.
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    powerGovernorEnter(&gov, PHASE_HTTP_WAIT, 0);
+    powerGovernorEnter(&gov, PHASE_RECEIVE, 10);
+    TEST_ASSERT_EQUAL_HEX8(POWER_CHANGE_CPU | POWER_CHANGE_MODEM_SLEEP, powerGovernorEnter(&gov, PHASE_HTTP_WAIT, 20));
+    TEST_ASSERT_EQUAL_INT(PHASE_HTTP_WAIT, gov.phase);
+    TEST_ASSERT_EQUAL_INT(3, gov.logCount);
+}
+
+void test_powerGovernorEnter_log_overflow(void) {
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    for (int i = 0; i < POWER_LOG_CAPACITY + 5; i++) {
+        powerGovernorEnter(&gov, (i % 2) ? PHASE_RECEIVE : PHASE_HTTP_WAIT, (uint32_t)i);
+    }
+    TEST_ASSERT_EQUAL_INT(POWER_LOG_CAPACITY, gov.logCount);
+    TEST_ASSERT_EQUAL_INT(5, gov.dropped);
+    // The governor keeps tracking the phase even when the log is full.
+    TEST_ASSERT_EQUAL_INT(PHASE_HTTP_WAIT, gov.phase);
+}
+
+// ============================================================================
+// Tests for powerPhaseDurationMs / powerCpuMhzMs
+// ============================================================================
+
+void test_powerPhaseDurationMs(void) {
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    powerGovernorEnter(&gov, PHASE_WIFI_CONNECT, 100);
+    powerGovernorEnter(&gov, PHASE_RECEIVE, 1100);
+    TEST_ASSERT_EQUAL_UINT32(1000, powerPhaseDurationMs(&gov, 0, 1500));
+    TEST_ASSERT_EQUAL_UINT32(400, powerPhaseDurationMs(&gov, 1, 1500));
+    TEST_ASSERT_EQUAL_UINT32(0, powerPhaseDurationMs(&gov, 2, 1500));
+    TEST_ASSERT_EQUAL_UINT32(0, powerPhaseDurationMs(&gov, -1, 1500));
+}
+
+void test_powerPhaseDurationMs_millis_wrap(void) {
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    powerGovernorEnter(&gov, PHASE_HTTP_WAIT, 0xFFFFFF00u);
+    TEST_ASSERT_EQUAL_UINT32(0x200, powerPhaseDurationMs(&gov, 0, 0x100));
+}
+
+void test_powerCpuMhzMs(void) {
+    PowerGovernor gov;
+    powerGovernorInit(&gov);
+    powerGovernorEnter(&gov, PHASE_HTTP_WAIT, 0);     // 80 MHz for 1000 ms
+    powerGovernorEnter(&gov, PHASE_RECEIVE, 1000);    // 240 MHz for 500 ms
+    powerGovernorEnter(&gov, PHASE_DISPLAY_HOLD, 1500);  // 80 MHz for 2000 ms
+    TEST_ASSERT_EQUAL_UINT32(80 * 1000 + 240 * 500 + 80 * 2000, powerCpuMhzMs(&gov, 3500));
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_powerPolicyFor_clock_steps);
+    RUN_TEST(test_powerPolicyFor_full_clock_for_bursts);
+    RUN_TEST(test_powerPolicyFor_low_clock_while_waiting);
+    RUN_TEST(test_powerPolicyFor_sleep_modes);
+    RUN_TEST(test_powerPolicyFor_out_of_range);
+
+    RUN_TEST(test_powerGovernorEnter_first_phase_applies_all);
+    RUN_TEST(test_powerGovernorEnter_reports_only_differences);
+    RUN_TEST(test_powerGovernorEnter_same_phase_not_logged);
+    RUN_TEST(test_powerGovernorEnter_retry_goes_back);
+    RUN_TEST(test_powerGovernorEnter_log_overflow);
+
+    RUN_TEST(test_powerPhaseDurationMs);
+    RUN_TEST(test_powerPhaseDurationMs_millis_wrap);
+    RUN_TEST(test_powerCpuMhzMs);
+
+    return UNITY_END();
+}
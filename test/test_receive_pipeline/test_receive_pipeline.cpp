@@ -0,0 +1,329 @@
+#include <unity.h>
+#include "../../src/receive_pipeline.h"
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Deterministic byte pattern so the consumer can verify order and content.
+static uint8_t patternByte(size_t i) { return (uint8_t)((i * 2654435761u) >> 13); }
+
+// EFA-shaped response with a bulky preamble and `entries` departures.
+static std::string buildEfaFixture(int entries) {
+    std::string json = "{ \"servingLines\": { \"lines\": [";
+    for (int i = 0; i < 40; i++) {
+        if (i > 0) json += ",";
+        json += "{ \"name\": \"Line [x] {y}\", \"desc\": \"quoted \\\"]}\\\" text\" }";
+    }
+    json += "] }, \"departureList\": [";
+    for (int i = 0; i < entries; i++) {
+        char entry[320];
+        snprintf(entry, sizeof(entry),
+                 "%s{ \"countdown\": \"%d\", \"dateTime\": { \"hour\": \"17\", \"minute\": \"%d\" },"
+                 "\"realDateTime\": { \"hour\": \"17\", \"minute\": \"%d\" },"
+                 "\"servingLine\": { \"number\": \"3\", \"direction\": \"Dir%d\", \"realtime\": \"1\" } }",
+                 i > 0 ? "," : "", i, i % 60, (i + 2) % 60, i);
+        json += entry;
+    }
+    json += "] }";
+    return json;
+}
+
+// ReceiveFn over an in-memory body that hands out randomly sized chunks and
+// sometimes reports "nothing available yet", like a socket between segments.
+struct ChunkedSource {
+    const std::string* body;
+    size_t pos;
+    std::mt19937 rng;
+    size_t maxChunk;
+};
+
+static int receiveChunk(void* context, uint8_t* buffer, size_t capacity) {
+    ChunkedSource* src = (ChunkedSource*)context;
+    if (src->pos >= src->body->size()) return -1;
+    if (src->rng() % 4 == 0) return 0;
+    size_t n = 1 + src->rng() % src->maxChunk;
+    if (n > capacity) n = capacity;
+    if (n > src->body->size() - src->pos) n = src->body->size() - src->pos;
+    memcpy(buffer, src->body->data() + src->pos, n);
+    src->pos += n;
+    return (int)n;
+}
+
+static int receiveForever(void* context, uint8_t* buffer, size_t capacity) {
+    (void)context;
+    memset(buffer, ' ', capacity);
+    return (int)capacity;
+}
+
+// ============================================================================
+// Tests for ByteRing
+// ============================================================================
+
+void test_ByteRing_write_read(void) {
+    StaticByteRing<8> ring;
+    const uint8_t in[5] = {1, 2, 3, 4, 5};
+    uint8_t out[8];
+    TEST_ASSERT_EQUAL_INT(5, ring.write(in, 5));
+    TEST_ASSERT_EQUAL_INT(3, ring.read(out, 3));
+    TEST_ASSERT_EQUAL_UINT8(1, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(3, out[2]);
+
+    // Wraps around the end of storage.
+    TEST_ASSERT_EQUAL_INT(5, ring.write(in, 5));
+    TEST_ASSERT_EQUAL_INT(7, ring.read(out, 8));
+    const uint8_t expected[7] = {4, 5, 1, 2, 3, 4, 5};
+    TEST_ASSERT_EQUAL_MEMORY(expected, out, 7);
+}
+
+void test_ByteRing_full_and_empty(void) {
+    StaticByteRing<4> ring;
+    const uint8_t in[6] = {1, 2, 3, 4, 5, 6};
+    uint8_t out[6];
+    TEST_ASSERT_EQUAL_INT(4, ring.write(in, 6));
+    TEST_ASSERT_EQUAL_INT(0, ring.write(in, 1));
+    TEST_ASSERT_EQUAL_INT(4, ring.read(out, 6));
+    TEST_ASSERT_EQUAL_INT(0, ring.read(out, 1));
+}
+
+void test_ByteRing_spans_stop_at_wrap(void) {
+    StaticByteRing<8> ring;
+    uint8_t tmp[8] = {0};
+    ring.write(tmp, 6);
+    ring.read(tmp, 6);
+
+    uint8_t* wspan;
+    TEST_ASSERT_EQUAL_INT(2, ring.writableSpan(&wspan));  // up to the wrap point
+    wspan[0] = 0xA;
+    wspan[1] = 0xB;
+    ring.commitWrite(2);
+    TEST_ASSERT_EQUAL_INT(6, ring.writableSpan(&wspan));  // then from the start
+
+    const uint8_t* rspan;
+    TEST_ASSERT_EQUAL_INT(2, ring.readableSpan(&rspan));
+    TEST_ASSERT_EQUAL_UINT8(0xA, rspan[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xB, rspan[1]);
+}
+
+void test_ByteRing_flags_and_reset(void) {
+    StaticByteRing<4> ring;
+    TEST_ASSERT_FALSE(ring.closed());
+    TEST_ASSERT_FALSE(ring.cancelled());
+    ring.close();
+    ring.cancel();
+    TEST_ASSERT_TRUE(ring.closed());
+    TEST_ASSERT_TRUE(ring.cancelled());
+    ring.reset();
+    TEST_ASSERT_FALSE(ring.closed());
+    TEST_ASSERT_FALSE(ring.cancelled());
+}
+
+// Producer and consumer threads move `total` pattern bytes with random chunk
+// sizes on both sides; every byte must arrive once and in order.
+static void stressRing(ByteRing& ring, size_t total, unsigned seed) {
+    std::thread producer([&ring, total, seed]() {
+        std::mt19937 rng(seed);
+        uint8_t chunk[512];
+        size_t sent = 0;
+        while (sent < total) {
+            size_t n = 1 + rng() % sizeof(chunk);
+            if (n > total - sent) n = total - sent;
+            for (size_t i = 0; i < n; i++) chunk[i] = patternByte(sent + i);
+            size_t done = 0;
+            while (done < n) {
+                size_t w = ring.write(chunk + done, n - done);
+                if (w == 0) std::this_thread::yield();
+                done += w;
+            }
+            sent += n;
+        }
+        ring.close();
+    });
+
+    std::mt19937 rng(seed ^ 0x5bd1e995u);
+    uint8_t chunk[512];
+    size_t received = 0;
+    size_t mismatches = 0;
+    for (;;) {
+        bool closed = ring.closed();
+        size_t n = ring.read(chunk, 1 + rng() % sizeof(chunk));
+        for (size_t i = 0; i < n; i++) {
+            if (chunk[i] != patternByte(received + i)) mismatches++;
+        }
+        received += n;
+        if (n == 0) {
+            if (closed) break;
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_INT(total, received);
+    TEST_ASSERT_EQUAL_INT(0, mismatches);
+}
+
+void test_ByteRing_stress_threads(void) {
+    static StaticByteRing<2> tiny;
+    static StaticByteRing<64> small;
+    static StaticByteRing<4096> large;
+    for (unsigned seed = 1; seed <= 4; seed++) {
+        tiny.reset();
+        small.reset();
+        large.reset();
+        stressRing(tiny, 20000, seed);
+        stressRing(small, 1 << 20, seed);
+        stressRing(large, 1 << 22, seed);
+    }
+}
+
+// ============================================================================
+// Tests for the receive/parse pipeline
+// ============================================================================
+
+// Receive `body` on a producer thread through pumpToRing while this thread
+// parses from the ring, then check the result matches a direct parse.
+static void runPipeline(ByteRing& ring, const std::string& body, unsigned seed, size_t maxChunk) {
+    ring.reset();
+    ChunkedSource src = {&body, 0, std::mt19937(seed), maxChunk};
+    size_t pumped = 0;
+    std::thread receiver([&]() { pumped = pumpToRing(ring, receiveChunk, &src, pipelineYield); });
+
+    static DeparturesResultN<64> viaRing;
+    {
+        RingSource source(ring, pipelineYield);
+        parseDeparturesJsonIncremental(source, viaRing);
+    }
+    ring.cancel();
+    receiver.join();
+
+    static DeparturesResultN<64> direct;
+    parseDeparturesJsonIncremental(body.c_str(), direct);
+
+    TEST_ASSERT_TRUE(direct.success);
+    TEST_ASSERT_EQUAL_INT(direct.error, viaRing.error);
+    TEST_ASSERT_EQUAL_INT(direct.count, viaRing.count);
+    for (int i = 0; i < direct.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(direct.departures[i].direction, viaRing.departures[i].direction);
+        TEST_ASSERT_EQUAL_INT(direct.departures[i].countdown, viaRing.departures[i].countdown);
+        TEST_ASSERT_EQUAL_INT(direct.departures[i].delayMin, viaRing.departures[i].delayMin);
+    }
+    TEST_ASSERT_TRUE(pumped <= body.size());
+}
+
+void test_pipeline_matches_direct_parse(void) {
+    static StaticByteRing<4096> ring;
+    std::string body = buildEfaFixture(40);
+    for (unsigned seed = 1; seed <= 20; seed++) {
+        runPipeline(ring, body, seed, 1 + seed * 97);
+    }
+}
+
+void test_pipeline_tiny_ring_and_chunks(void) {
+    // A ring much smaller than one departure forces constant hand-off.
+    static StaticByteRing<16> ring;
+    std::string body = buildEfaFixture(20);
+    for (unsigned seed = 1; seed <= 5; seed++) {
+        runPipeline(ring, body, seed, 7);
+    }
+}
+
+void test_pipeline_truncated_body_ends_parse(void) {
+    // The receiver closing early must end the parse, not hang it, and keep
+    // the departures that arrived complete.
+    static StaticByteRing<256> ring;
+    ring.reset();
+    std::string body = buildEfaFixture(20);
+    body.resize(body.size() / 2);
+    ChunkedSource src = {&body, 0, std::mt19937(7), 300};
+    std::thread receiver([&]() { pumpToRing(ring, receiveChunk, &src, pipelineYield); });
+
+    static DeparturesResultN<64> result;
+    {
+        RingSource source(ring, pipelineYield);
+        parseDeparturesJsonIncremental(source, result);
+    }
+    ring.cancel();
+    receiver.join();
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL_INT(PARSE_PARTIAL, result.error);
+    TEST_ASSERT_TRUE(result.count > 0);
+    TEST_ASSERT_EQUAL_STRING("Dir0", result.departures[0].direction);
+}
+
+void test_pipeline_cancel_stops_receiver(void) {
+    // Once the parser is done, cancel() releases a receiver that would
+    // otherwise keep reading (or wait on a full ring) forever.
+    static StaticByteRing<64> ring;
+    ring.reset();
+    std::thread receiver([&]() { pumpToRing(ring, receiveForever, NULL, pipelineYield); });
+    uint8_t out[8];
+    while (ring.read(out, sizeof(out)) == 0) std::this_thread::yield();
+    ring.cancel();
+    receiver.join();
+    TEST_ASSERT_TRUE(ring.closed());
+}
+
+void test_pipeline_feeds_push_parser(void) {
+    // parseFromRing hands ring spans straight to the push parser; the result
+    // matches a direct parse, and once departureList closes the ring is
+    // cancelled so the receiver stops before the trailing members.
+    std::string body = buildEfaFixture(40);
+    body.insert(body.size() - 1, ", \"trailer\": \"" + std::string(200000, 't') + "\" ");
+    static DeparturesResultN<64> direct;
+    parseDeparturesJsonIncremental(body.c_str(), direct);
+    TEST_ASSERT_TRUE(direct.success);
+
+    static StaticByteRing<512> ring;
+    static Departure out[64];
+    static char element[1024];
+    for (unsigned seed = 1; seed <= 10; seed++) {
+        ring.reset();
+        ChunkedSource src = {&body, 0, std::mt19937(seed), 1 + seed * 61};
+        size_t pumped = 0;
+        std::thread receiver([&]() { pumped = pumpToRing(ring, receiveChunk, &src, pipelineYield); });
+        DeparturePushParser parser(out, 64, element, sizeof(element));
+        TEST_ASSERT_EQUAL_INT(PARSE_OK, parseFromRing(ring, parser, pipelineYield));
+        receiver.join();
+
+        TEST_ASSERT_EQUAL_INT(direct.count, parser.count());
+        for (int i = 0; i < direct.count; i++) {
+            TEST_ASSERT_EQUAL_STRING(direct.departures[i].direction, out[i].direction);
+            TEST_ASSERT_EQUAL_INT(direct.departures[i].countdown, out[i].countdown);
+        }
+        TEST_ASSERT_TRUE(pumped < body.size());
+    }
+
+    // A body cut off mid-list settles as PARSE_PARTIAL when the ring closes.
+    std::string cut = body.substr(0, body.find("Dir20"));
+    ring.reset();
+    ChunkedSource src = {&cut, 0, std::mt19937(3), 200};
+    std::thread receiver([&]() { pumpToRing(ring, receiveChunk, &src, pipelineYield); });
+    DeparturePushParser parser(out, 64, element, sizeof(element));
+    TEST_ASSERT_EQUAL_INT(PARSE_PARTIAL, parseFromRing(ring, parser, pipelineYield));
+    receiver.join();
+    TEST_ASSERT_EQUAL_INT(20, parser.count());
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ByteRing_write_read);
+    RUN_TEST(test_ByteRing_full_and_empty);
+    RUN_TEST(test_ByteRing_spans_stop_at_wrap);
+    RUN_TEST(test_ByteRing_flags_and_reset);
+    RUN_TEST(test_ByteRing_stress_threads);
+
+    RUN_TEST(test_pipeline_matches_direct_parse);
+    RUN_TEST(test_pipeline_tiny_ring_and_chunks);
+    RUN_TEST(test_pipeline_truncated_body_ends_parse);
+    RUN_TEST(test_pipeline_cancel_stops_receiver);
+    RUN_TEST(test_pipeline_feeds_push_parser);
+
+    return UNITY_END();
+}
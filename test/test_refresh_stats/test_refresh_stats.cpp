@@ -0,0 +1,96 @@
+#include <unity.h>
+#include "../../src/refresh_stats.h"
+#include <string.h>
+
+static RefreshSample sample(uint32_t cycleMs, bool ok, bool reused, uint8_t rows, uint32_t heapUsed) {
+    RefreshSample s;
+    s.cycleMs = cycleMs;
+    s.ok = ok;
+    s.reusedConnection = reused;
+    s.rowsRedrawn = rows;
+    s.heapUsed = heapUsed;
+    return s;
+}
+
+// ============================================================================
+// Tests for recording
+// ============================================================================
+
+void test_refresh_stats_counts_cycles(void) {
+    RefreshStats stats;
+    refreshStatsInit(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, refreshStatsMeanCycleMs(&stats));
+
+    RefreshSample a = sample(500, true, false, 0x7, 1000);
+    RefreshSample b = sample(300, false, true, 0, 1000);
+    RefreshSample c = sample(400, true, true, 0x4, 1000);
+    refreshStatsRecord(&stats, &a);
+    refreshStatsRecord(&stats, &b);
+    refreshStatsRecord(&stats, &c);
+
+    TEST_ASSERT_EQUAL_UINT32(3, stats.cycles);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.failures);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.reusedConnections);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.rowsRedrawn);  // bits set, not mask values
+    TEST_ASSERT_EQUAL_UINT32(1, stats.unchangedFrames);
+    TEST_ASSERT_EQUAL_UINT32(400, stats.lastCycleMs);
+    TEST_ASSERT_EQUAL_UINT32(300, stats.minCycleMs);
+    TEST_ASSERT_EQUAL_UINT32(500, stats.maxCycleMs);
+    TEST_ASSERT_EQUAL_UINT32(400, refreshStatsMeanCycleMs(&stats));
+}
+
+void test_refresh_stats_heap_drift_after_warmup(void) {
+    RefreshStats stats;
+    refreshStatsInit(&stats);
+    // Warm-up allocations are not drift.
+    for (int i = 0; i < REFRESH_WARMUP_CYCLES; i++) {
+        RefreshSample s = sample(100, true, true, 0, 1000 + 500 * i);
+        refreshStatsRecord(&stats, &s);
+        TEST_ASSERT_EQUAL_INT(0, refreshStatsHeapDrift(&stats));
+    }
+    uint32_t baseline = stats.baselineHeapUsed;
+    TEST_ASSERT_EQUAL_UINT32(1000 + 500 * (REFRESH_WARMUP_CYCLES - 1), baseline);
+
+    RefreshSample grown = sample(100, true, true, 0, baseline + 64);
+    refreshStatsRecord(&stats, &grown);
+    TEST_ASSERT_EQUAL_INT(64, refreshStatsHeapDrift(&stats));
+    RefreshSample shrunk = sample(100, true, true, 0, baseline - 32);
+    refreshStatsRecord(&stats, &shrunk);
+    TEST_ASSERT_EQUAL_INT(-32, refreshStatsHeapDrift(&stats));
+    TEST_ASSERT_EQUAL_UINT32(baseline + 64, stats.peakHeapUsed);
+}
+
+// ============================================================================
+// Tests for formatting
+// ============================================================================
+
+void test_refresh_stats_format(void) {
+    RefreshStats stats;
+    refreshStatsInit(&stats);
+    for (int i = 0; i < REFRESH_WARMUP_CYCLES + 1; i++) {
+        RefreshSample s = sample(200 + 100 * i, i != 1, i > 0, 0, (i == REFRESH_WARMUP_CYCLES) ? 4008 : 4000);
+        refreshStatsRecord(&stats, &s);
+    }
+    char line[128];
+    size_t n = refreshStatsFormat(&stats, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("cycles 4 (1 failed, 3 reused) cycle 500/350/500 ms heap drift +8 peak 4008", line);
+    TEST_ASSERT_EQUAL_size_t(strlen(line), n);
+
+    char small[16];
+    TEST_ASSERT_EQUAL_size_t(0, refreshStatsFormat(&stats, small, sizeof(small)));
+    TEST_ASSERT_EQUAL_STRING("", small);
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_refresh_stats_counts_cycles);
+    RUN_TEST(test_refresh_stats_heap_drift_after_warmup);
+    RUN_TEST(test_refresh_stats_format);
+
+    return UNITY_END();
+}
@@ -0,0 +1,289 @@
+#include <unity.h>
+#include "../../src/row_renderer.h"
+#include "../../src/row_glyphs.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_BYTES (ROW_BUFFER_WIDTH * ROW_BUFFER_HEIGHT / 8)
+
+// ============================================================================
+// Reference: the Adafruit GFX text path the row renderer replaces
+// ============================================================================
+
+// Model of Adafruit_GFX::write()/drawChar() with the classic 5x7 font, as
+// used by the firmware: setTextColor(WHITE) (transparent background), text
+// wrap on, and Adafruit_SSD1306's per-pixel clipping. Glyphs are drawn pixel
+// by pixel (fillRect per pixel at size > 1) from the raw font columns.
+struct GfxModel {
+    uint8_t buffer[FRAME_BYTES];
+    int cursorX;
+    int cursorY;
+    int textSize;
+
+    GfxModel() : cursorX(0), cursorY(0), textSize(1) { memset(buffer, 0, sizeof(buffer)); }
+
+    void setCursor(int x, int y) { cursorX = x; cursorY = y; }
+    void setTextSize(int s) { textSize = s; }
+
+    void drawPixel(int x, int y) {
+        if (x < 0 || x >= ROW_BUFFER_WIDTH || y < 0 || y >= ROW_BUFFER_HEIGHT) return;
+        buffer[x + (y / 8) * ROW_BUFFER_WIDTH] |= (uint8_t)(1 << (y & 7));
+    }
+
+    void fillRect(int x, int y, int w, int h) {
+        for (int i = 0; i < w; i++)
+            for (int j = 0; j < h; j++) drawPixel(x + i, y + j);
+    }
+
+    void drawChar(int x, int y, char c, int size) {
+        if ((x >= ROW_BUFFER_WIDTH) || (y >= ROW_BUFFER_HEIGHT) || ((x + 6 * size - 1) < 0) ||
+            ((y + 8 * size - 1) < 0))
+            return;
+        const char* p = strchr(kRowGlyphChars, c);
+        TEST_ASSERT_NOT_NULL(p);
+        const uint8_t* font = kRowGlyphs1[p - kRowGlyphChars];
+        for (int i = 0; i < 5; i++) {
+            uint8_t line = font[i];
+            for (int j = 0; j < 8; j++, line >>= 1) {
+                if (line & 1) {
+                    if (size == 1)
+                        drawPixel(x + i, y + j);
+                    else
+                        fillRect(x + i * size, y + j * size, size, size);
+                }
+            }
+        }
+    }
+
+    void write(char c) {
+        if ((cursorX + textSize * 6) > ROW_BUFFER_WIDTH) {
+            cursorX = 0;
+            cursorY += textSize * 8;
+        }
+        drawChar(cursorX, cursorY, c, textSize);
+        cursorX += textSize * 6;
+    }
+
+    void print(const char* s) { while (*s) write(*s++); }
+
+    void print(int n) {
+        char buf[12];
+        snprintf(buf, sizeof(buf), "%d", n);
+        print(buf);
+    }
+};
+
+// The row drawing sequence from fetchDepartures before the glyph renderer.
+static void referenceRow(GfxModel& display, int y, const Departure* dep) {
+    display.setTextSize(2);
+    display.setCursor(0, y);
+    char hrBuf[3], mnBuf[3];
+    snprintf(hrBuf, sizeof(hrBuf), "%02d", dep->realHour);
+    snprintf(mnBuf, sizeof(mnBuf), "%02d", dep->realMinute);
+    display.print(hrBuf);
+    display.print(":");
+    display.setCursor(36, y);
+    display.print(mnBuf);
+
+    if (dep->delayMin != 0) {
+        display.setTextSize(1);
+        display.setCursor(62, y);
+        int displayDelay = dep->delayMin;
+        bool delayOverflow = (displayDelay > 99 || displayDelay < -99);
+        if (delayOverflow) {
+            display.print("!");
+        } else {
+            if (displayDelay > 0) display.print("+");
+            display.print(displayDelay);
+        }
+    }
+
+    display.setTextSize(1);
+    display.setCursor(83, y + 4);
+    display.print("in");
+
+    display.setTextSize(2);
+    int xPos = 110;
+    if (dep->countdown >= 10) xPos = 98;
+
+    display.setCursor(xPos, y);
+    display.print(dep->countdown);
+    display.setTextSize(1);
+    display.print("'");
+}
+
+static Departure makeDeparture(int hour, int minute, int delayMin, int countdown) {
+    Departure dep;
+    memset(&dep, 0, sizeof(dep));
+    dep.realHour = hour;
+    dep.realMinute = minute;
+    dep.delayMin = delayMin;
+    dep.countdown = countdown;
+    dep.valid = true;
+    return dep;
+}
+
+static void assertRowMatches(int y, const Departure& dep) {
+    GfxModel expected;
+    referenceRow(expected, y, &dep);
+
+    uint8_t actual[FRAME_BYTES];
+    memset(actual, 0, sizeof(actual));
+    renderDepartureRow(actual, y, &dep);
+
+    char message[96];
+    snprintf(message, sizeof(message), "y=%d %02d:%02d delay=%d countdown=%d", y, dep.realHour, dep.realMinute,
+             dep.delayMin, dep.countdown);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected.buffer, actual, FRAME_BYTES, message);
+}
+
+static const int kRowY[3] = {0, 24, 48};
+
+// ============================================================================
+// Tests for renderDepartureRow
+// ============================================================================
+
+void test_renderDepartureRow_typical_row(void) {
+    // "17:26+3   in 4'"
+    Departure dep = makeDeparture(17, 29, 3, 4);
+    for (int r = 0; r < 3; r++) assertRowMatches(kRowY[r], dep);
+}
+
+void test_renderDepartureRow_every_time_of_day(void) {
+    for (int hour = 0; hour < 24; hour++) {
+        for (int minute = 0; minute < 60; minute++) {
+            Departure dep = makeDeparture(hour, minute, 0, 2 + (hour * 60 + minute) % 60);
+            assertRowMatches(kRowY[minute % 3], dep);
+        }
+    }
+}
+
+void test_renderDepartureRow_delays(void) {
+    // Covers no delay, early, late, and the "!" overflow marker.
+    for (int delay = -130; delay <= 130; delay++) {
+        Departure dep = makeDeparture(8, 15, delay, 7);
+        for (int r = 0; r < 3; r++) assertRowMatches(kRowY[r], dep);
+    }
+}
+
+void test_renderDepartureRow_countdowns(void) {
+    // One and two digits, plus three digits, where the last digit and the tick
+    // wrap onto the next text line exactly as GFX does.
+    for (int countdown = -5; countdown <= 1200; countdown++) {
+        Departure dep = makeDeparture(23, 59, 1, countdown);
+        for (int r = 0; r < 3; r++) assertRowMatches(kRowY[r], dep);
+    }
+}
+
+void test_renderDepartureRow_out_of_range_times(void) {
+    // Values that do not fit "%02d" in three bytes are cut the same way.
+    const int values[] = {-12, -5, -1, 24, 99, 100, 123, 2026};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        assertRowMatches(0, makeDeparture(values[i], 5, 0, 3));
+        assertRowMatches(24, makeDeparture(12, values[i], 0, 3));
+    }
+}
+
+void test_renderDepartureRow_full_frame(void) {
+    // Three rows composed into one frame, as fetchDepartures does.
+    GfxModel expected;
+    uint8_t actual[FRAME_BYTES];
+    memset(actual, 0, sizeof(actual));
+
+    Departure deps[3] = {makeDeparture(17, 29, 3, 4), makeDeparture(17, 34, 0, 12), makeDeparture(17, 43, -1, 19)};
+    for (int r = 0; r < 3; r++) {
+        referenceRow(expected, kRowY[r], &deps[r]);
+        renderDepartureRow(actual, kRowY[r], &deps[r]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(expected.buffer, actual, FRAME_BYTES);
+}
+
+void test_renderDepartureRow_only_sets_pixels(void) {
+    // Transparent text: existing pixels are preserved.
+    uint8_t frame[FRAME_BYTES];
+    memset(frame, 0xFF, sizeof(frame));
+    Departure dep = makeDeparture(17, 29, 3, 4);
+    renderDepartureRow(frame, 24, &dep);
+    for (int i = 0; i < FRAME_BYTES; i++) TEST_ASSERT_EQUAL_UINT8(0xFF, frame[i]);
+}
+
+// ============================================================================
+// Tests for updateDepartureRows
+// ============================================================================
+
+// The frame a full redraw of rows[0..count) produces.
+static void fullFrame(const Departure* rows, int count, uint8_t* frame) {
+    memset(frame, 0, FRAME_BYTES);
+    for (int r = 0; r < count && r < ROW_SLOTS; r++) renderDepartureRow(frame, departureRowY(r), &rows[r]);
+}
+
+void test_updateDepartureRows_redraws_only_changes(void) {
+    uint8_t frame[FRAME_BYTES], expected[FRAME_BYTES];
+    memset(frame, 0xAA, sizeof(frame));  // spinner leftovers
+    RowCache cache;
+    rowCacheInvalidate(&cache);
+
+    Departure rows[3] = {makeDeparture(17, 29, 3, 4), makeDeparture(17, 34, 0, 12), makeDeparture(17, 43, -1, 19)};
+    TEST_ASSERT_EQUAL_UINT8(0x7, updateDepartureRows(frame, &cache, rows, 3));
+    fullFrame(rows, 3, expected);
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, FRAME_BYTES);
+
+    // Same rows (direction is not drawn): nothing to do.
+    strcpy(rows[1].direction, "elsewhere");
+    TEST_ASSERT_EQUAL_UINT8(0, updateDepartureRows(frame, &cache, rows, 3));
+
+    // A minute later only the countdowns move; one row keeps its value.
+    rows[0].countdown = 3;
+    rows[2].countdown = 18;
+    TEST_ASSERT_EQUAL_UINT8(0x5, updateDepartureRows(frame, &cache, rows, 3));
+    fullFrame(rows, 3, expected);
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, FRAME_BYTES);
+
+    // Fewer rows: the emptied slot is cleared.
+    TEST_ASSERT_EQUAL_UINT8(0x4, updateDepartureRows(frame, &cache, rows, 2));
+    fullFrame(rows, 2, expected);
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, FRAME_BYTES);
+}
+
+void test_updateDepartureRows_matches_full_redraw(void) {
+    // Random sequences of updates, including countdowns that wrap onto the
+    // next text line, always leave the frame a full redraw would produce.
+    const int countdowns[] = {2, 5, 9, 10, 45, 99, 100, 123, -3};
+    const int delays[] = {0, 0, 1, 5, -2, 120};
+    uint8_t frame[FRAME_BYTES], expected[FRAME_BYTES];
+    RowCache cache;
+    rowCacheInvalidate(&cache);
+    unsigned seed = 7;
+    for (int round = 0; round < 2000; round++) {
+        Departure rows[ROW_SLOTS];
+        int count = (int)((seed >> 4) % (ROW_SLOTS + 1));
+        for (int r = 0; r < ROW_SLOTS; r++) {
+            seed = seed * 1103515245u + 12345u;
+            rows[r] = makeDeparture(17, (int)(seed >> 8) % 60, delays[(seed >> 16) % 6], countdowns[(seed >> 20) % 9]);
+            if ((seed >> 24) % 3 == 0 && cache.count > r) rows[r] = cache.rows[r];  // often unchanged
+        }
+        updateDepartureRows(frame, &cache, rows, count);
+        fullFrame(rows, count, expected);
+        TEST_ASSERT_EQUAL_MEMORY(expected, frame, FRAME_BYTES);
+    }
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_renderDepartureRow_typical_row);
+    RUN_TEST(test_renderDepartureRow_every_time_of_day);
+    RUN_TEST(test_renderDepartureRow_delays);
+    RUN_TEST(test_renderDepartureRow_countdowns);
+    RUN_TEST(test_renderDepartureRow_out_of_range_times);
+    RUN_TEST(test_renderDepartureRow_full_frame);
+    RUN_TEST(test_renderDepartureRow_only_sets_pixels);
+    RUN_TEST(test_updateDepartureRows_redraws_only_changes);
+    RUN_TEST(test_updateDepartureRows_matches_full_redraw);
+
+    return UNITY_END();
+}
@@ -0,0 +1,138 @@
+#include <unity.h>
+#include "../../src/task_profiler.h"
+#include <string.h>
+
+// ============================================================================
+// Tests for taskProfilerRegister
+// ============================================================================
+
+void test_taskProfilerRegister_assigns_slots(void) {
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    TEST_ASSERT_EQUAL_INT(0, taskProfilerRegister(&profiler, "loop", 8192));
+    TEST_ASSERT_EQUAL_INT(1, taskProfilerRegister(&profiler, "spinner", 4096));
+    TEST_ASSERT_EQUAL_INT(2, profiler.count);
+    TEST_ASSERT_EQUAL_UINT32(4096, profiler.tasks[1].stackBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, taskProfilerPeakBytes(&profiler, 1));
+}
+
+void test_taskProfilerRegister_same_name_reuses_slot(void) {
+    // The receive task is created once per HTTP attempt.
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    taskProfilerRegister(&profiler, "loop", 8192);
+    int first = taskProfilerRegister(&profiler, "receive", 4096);
+    taskProfilerSampleStack(&profiler, first, PHASE_RECEIVE, 3000);
+    TEST_ASSERT_EQUAL_INT(first, taskProfilerRegister(&profiler, "receive", 4096));
+    TEST_ASSERT_EQUAL_INT(2, profiler.count);
+    TEST_ASSERT_EQUAL_UINT32(1096, taskProfilerPeakBytes(&profiler, first));
+}
+
+void test_taskProfilerRegister_full_table(void) {
+    static const char* names[PROFILER_MAX_TASKS] = {"a", "b", "c", "d"};
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    for (int i = 0; i < PROFILER_MAX_TASKS; i++) {
+        TEST_ASSERT_EQUAL_INT(i, taskProfilerRegister(&profiler, names[i], 1024));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, taskProfilerRegister(&profiler, "extra", 1024));
+
+    // Calls with the failed slot are ignored.
+    taskProfilerSampleStack(&profiler, -1, PHASE_BOOT, 10);
+    taskProfilerAddCpu(&profiler, -1, 10);
+    TEST_ASSERT_EQUAL_UINT32(0, taskProfilerPeakBytes(&profiler, -1));
+}
+
+// ============================================================================
+// Tests for taskProfilerSampleStack
+// ============================================================================
+
+void test_taskProfilerSampleStack_tracks_peak_phase(void) {
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    int loop = taskProfilerRegister(&profiler, "loop", 8192);
+
+    taskProfilerSampleStack(&profiler, loop, PHASE_BOOT, 7000);
+    taskProfilerSampleStack(&profiler, loop, PHASE_WIFI_CONNECT, 6500);
+    taskProfilerSampleStack(&profiler, loop, PHASE_RECEIVE, 4200);
+    taskProfilerSampleStack(&profiler, loop, PHASE_RENDER, 4200);  // mark never rises
+
+    TEST_ASSERT_EQUAL_UINT32(8192 - 4200, taskProfilerPeakBytes(&profiler, loop));
+    TEST_ASSERT_EQUAL_INT(PHASE_RECEIVE, profiler.tasks[loop].peakPhase);
+    TEST_ASSERT_EQUAL_UINT32(6500, profiler.tasks[loop].phaseFreeBytes[PHASE_WIFI_CONNECT]);
+    TEST_ASSERT_EQUAL_UINT32(0, profiler.tasks[loop].phaseFreeBytes[PHASE_HTTP_WAIT]);
+}
+
+void test_taskProfilerSampleStack_keeps_lowest_per_phase(void) {
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    int spinner = taskProfilerRegister(&profiler, "spinner", 4096);
+    taskProfilerSampleStack(&profiler, spinner, PHASE_BOOT, 3000);
+    taskProfilerSampleStack(&profiler, spinner, PHASE_BOOT, 2800);
+    taskProfilerSampleStack(&profiler, spinner, PHASE_BOOT, 2900);
+    TEST_ASSERT_EQUAL_UINT32(2800, profiler.tasks[spinner].phaseFreeBytes[PHASE_BOOT]);
+    TEST_ASSERT_EQUAL_UINT32(2800, profiler.tasks[spinner].minFreeBytes);
+}
+
+void test_taskProfilerSampleStack_ignores_bad_phase(void) {
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    int loop = taskProfilerRegister(&profiler, "loop", 8192);
+    taskProfilerSampleStack(&profiler, loop, PHASE_COUNT, 100);
+    TEST_ASSERT_EQUAL_UINT32(0, taskProfilerPeakBytes(&profiler, loop));
+}
+
+// ============================================================================
+// Tests for taskProfilerAddCpu / taskProfilerFormat
+// ============================================================================
+
+void test_taskProfilerAddCpu_accumulates(void) {
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    int receive = taskProfilerRegister(&profiler, "receive", 4096);
+    for (int i = 0; i < 5000; i++) taskProfilerAddCpu(&profiler, receive, 1000000);
+    TEST_ASSERT_TRUE(profiler.tasks[receive].cpuUs == 5000ULL * 1000000ULL);
+}
+
+void test_taskProfilerFormat(void) {
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    int spinner = taskProfilerRegister(&profiler, "spinner", 4096);
+    taskProfilerSampleStack(&profiler, spinner, PHASE_WIFI_CONNECT, 2048);
+    taskProfilerAddCpu(&profiler, spinner, 212400);
+
+    char line[128];
+    size_t n = taskProfilerFormat(&profiler, spinner, line, sizeof(line));
+    TEST_ASSERT_EQUAL_INT(strlen(line), n);
+    TEST_ASSERT_EQUAL_STRING("spinner  stack  4096  peak  2048 (50%) in wifi-connect cpu 212 ms", line);
+}
+
+void test_taskProfilerFormat_truncates(void) {
+    TaskProfiler profiler;
+    taskProfilerInit(&profiler);
+    int loop = taskProfilerRegister(&profiler, "loop", 8192);
+    char line[8];
+    TEST_ASSERT_EQUAL_INT(7, taskProfilerFormat(&profiler, loop, line, sizeof(line)));
+    TEST_ASSERT_EQUAL_STRING("loop   ", line);
+    TEST_ASSERT_EQUAL_INT(0, taskProfilerFormat(&profiler, 3, line, sizeof(line)));
+}
+
+// ============================================================================
+// Test runner
+// ============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_taskProfilerRegister_assigns_slots);
+    RUN_TEST(test_taskProfilerRegister_same_name_reuses_slot);
+    RUN_TEST(test_taskProfilerRegister_full_table);
+    RUN_TEST(test_taskProfilerSampleStack_tracks_peak_phase);
+    RUN_TEST(test_taskProfilerSampleStack_keeps_lowest_per_phase);
+    RUN_TEST(test_taskProfilerSampleStack_ignores_bad_phase);
+    RUN_TEST(test_taskProfilerAddCpu_accumulates);
+    RUN_TEST(test_taskProfilerFormat);
+    RUN_TEST(test_taskProfilerFormat_truncates);
+
+    return UNITY_END();
+}
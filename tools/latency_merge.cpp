@@ -0,0 +1,97 @@
+// Merge latency histogram dumps from many units and print fleet percentiles.
+//
+// Usage: latency_merge [file...]   (reads stdin when no file is given)
+//
+// Each input may be a raw serial capture: every "LATENCY v1 ... END" block in
+// it is parsed, everything else is ignored. A unit's dump holds all its
+// samples since it was last cleared, so only the last dump of each unit= (in
+// argument order, then file order) counts; earlier ones are reported and
+// dropped rather than counted twice. Prints the merged dump followed by
+// p50/p90/p99 per metric. The merged dump is labelled unit=merged and can be
+// fed in again, as one unit, together with captures of other units.
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+
+#include "../src/latency_histogram.h"
+
+static bool readAll(FILE* file, std::string* text) {
+  char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) text->append(chunk, n);
+  return !ferror(file);
+}
+
+typedef std::map<std::string, LatencyHistograms> LatestByUnit;
+
+static int collectText(const std::string& text, LatestByUnit* latest) {
+  int dumps = 0;
+  LatencyHistograms parsed;
+  char unit[LATENCY_UNIT_ID_SIZE];
+  for (const char* p = text.c_str(); (p = latencyParseDump(p, &parsed, unit)) != NULL; dumps++) {
+    (*latest)[unit] = parsed;
+  }
+  return dumps;
+}
+
+int main(int argc, char** argv) {
+  LatestByUnit latest;
+  int dumps = 0;
+
+  if (argc < 2) {
+    std::string text;
+    if (!readAll(stdin, &text)) {
+      fprintf(stderr, "latency_merge: error reading stdin\n");
+      return 1;
+    }
+    dumps += collectText(text, &latest);
+  }
+  for (int i = 1; i < argc; i++) {
+    FILE* file = fopen(argv[i], "rb");
+    if (file == NULL) {
+      fprintf(stderr, "latency_merge: cannot open %s\n", argv[i]);
+      return 1;
+    }
+    std::string text;
+    bool ok = readAll(file, &text);
+    fclose(file);
+    if (!ok) {
+      fprintf(stderr, "latency_merge: error reading %s\n", argv[i]);
+      return 1;
+    }
+    dumps += collectText(text, &latest);
+  }
+
+  if (dumps == 0) {
+    fprintf(stderr, "latency_merge: no LATENCY dumps found\n");
+    return 1;
+  }
+
+  if ((size_t)dumps > latest.size()) {
+    fprintf(stderr, "latency_merge: %d dumps from %zu units; only the last dump of each unit counts\n", dumps,
+            latest.size());
+  }
+  LatencyHistograms merged;
+  latencyInit(&merged);
+  for (LatestByUnit::const_iterator it = latest.begin(); it != latest.end(); ++it) latencyMerge(&merged, &it->second);
+
+  static char dump[LATENCY_DUMP_CAPACITY];
+  if (latencyFormatDump(&merged, "merged", dump, sizeof(dump)) == 0) {
+    fprintf(stderr, "latency_merge: merged dump does not fit %d bytes\n", LATENCY_DUMP_CAPACITY);
+    return 1;
+  }
+  fputs(dump, stdout);
+
+  printf("\n%zu units, %lu boots\n", latest.size(), (unsigned long)merged.boots);
+  printf("%-14s %8s %8s %8s %8s\n", "metric", "samples", "p50 ms", "p90 ms", "p99 ms");
+  for (int m = 0; m < LATENCY_METRIC_COUNT; m++) {
+    LatencyMetric metric = (LatencyMetric)m;
+    printf("%-14s %8lu %8lu %8lu %8lu\n", latencyMetricName(metric), (unsigned long)latencySampleCount(&merged, metric),
+           (unsigned long)latencyPercentileMs(&merged, metric, 50),
+           (unsigned long)latencyPercentileMs(&merged, metric, 90),
+           (unsigned long)latencyPercentileMs(&merged, metric, 99));
+  }
+  return 0;
+}
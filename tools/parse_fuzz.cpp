@@ -0,0 +1,69 @@
+// libFuzzer target for the departure parsers and the direction filter.
+//
+// Usage: make fuzz [FUZZ_SECONDS=300]
+//
+// Every input goes through parse_probe: the push parser (fed in pieces, as
+// the fetch cycle does), the pull parser, the whole-document deserialize and
+// the filter. A disagreement between the incremental parsers or a malformed
+// entry aborts, so libFuzzer keeps the input as a crash. Beyond correctness
+// the target keeps the most expensive inputs seen so far, one file per
+// measure, in $PARSE_FUZZ_WORST (default: the current directory):
+//   time  slowest parse (any of the three parsers)
+//   heap  most heap in use at once
+//   pool  largest element pool use in the push parser
+// `make fuzz` then minimizes them into the regression corpus (parse_replay).
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "parse_probe.h"
+
+static std::string worstDir;
+static double worstUs = 0;
+static size_t worstHeap = 0;
+static size_t worstPool = 0;
+
+static void saveWorst(const char* measure, const uint8_t* data, size_t size, double value) {
+  std::string path = worstDir + "/" + measure;
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == NULL) return;
+  fwrite(data, 1, size, file);
+  fclose(file);
+  fprintf(stderr, "parse_fuzz: new worst %s %.0f (%zu bytes) -> %s\n", measure, value, size, path.c_str());
+}
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) {
+  (void)argc;
+  (void)argv;
+  const char* dir = getenv("PARSE_FUZZ_WORST");
+  worstDir = (dir != NULL && dir[0] != '\0') ? dir : ".";
+  if (!probeHeapTracking()) fprintf(stderr, "parse_fuzz: heap peak not measured in this build\n");
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  ParseCost cost;
+  const char* why = probeParse(data, size, 1, &cost);
+  if (why != NULL) {
+    fprintf(stderr, "parse_fuzz: %s\n", why);
+    abort();
+  }
+
+  // A single timed run is noisy; only a clear new worst is worth a file.
+  double us = probeParseUs(cost);
+  if (us > worstUs * 1.25 + 50) {
+    worstUs = us;
+    saveWorst("time", data, size, us);
+  }
+  if (cost.heapPeak > worstHeap) {
+    worstHeap = cost.heapPeak;
+    saveWorst("heap", data, size, (double)cost.heapPeak);
+  }
+  if (cost.poolPeak > worstPool) {
+    worstPool = cost.poolPeak;
+    saveWorst("pool", data, size, (double)cost.poolPeak);
+  }
+  return 0;
+}
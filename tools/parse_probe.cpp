@@ -0,0 +1,257 @@
+// See parse_probe.h.
+
+#include "parse_probe.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+// --- Heap accounting --------------------------------------------------------
+//
+// Only allocations made while a parse runs are counted. Under AddressSanitizer
+// its allocator hooks report them; a plain glibc build replaces malloc and
+// friends with counting wrappers around the libc ones.
+
+static bool heapCounting = false;
+static size_t heapLive = 0;
+static size_t heapPeak = 0;
+
+static void heapAdd(size_t bytes) {
+  if (!heapCounting) return;
+  heapLive += bytes;
+  if (heapLive > heapPeak) heapPeak = heapLive;
+}
+
+static void heapSub(size_t bytes) {
+  if (!heapCounting) return;
+  heapLive = (bytes < heapLive) ? heapLive - bytes : 0;
+}
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define PROBE_SANITIZER_HEAP 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define PROBE_SANITIZER_HEAP 1
+#endif
+
+#if defined(PROBE_SANITIZER_HEAP)
+// From <sanitizer/allocator_interface.h>, which GCC does not install.
+extern "C" {
+size_t __sanitizer_get_allocated_size(const volatile void* pointer);
+int __sanitizer_install_malloc_and_free_hooks(void (*mallocHook)(const volatile void*, size_t),
+                                              void (*freeHook)(const volatile void*));
+}
+
+static void mallocHook(const volatile void* pointer, size_t size) {
+  (void)pointer;
+  heapAdd(size);
+}
+
+static void freeHook(const volatile void* pointer) {
+  if (pointer != NULL) heapSub(__sanitizer_get_allocated_size(pointer));
+}
+
+static void installHeapHooks() {
+  static bool installed = false;
+  if (installed) return;
+  __sanitizer_install_malloc_and_free_hooks(mallocHook, freeHook);
+  installed = true;
+}
+
+bool probeHeapTracking() { return true; }
+
+#elif defined(__GLIBC__)
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) {
+  void* pointer = __libc_malloc(size);
+  if (pointer != NULL) heapAdd(malloc_usable_size(pointer));
+  return pointer;
+}
+
+void* calloc(size_t count, size_t size) {
+  void* pointer = __libc_calloc(count, size);
+  if (pointer != NULL) heapAdd(malloc_usable_size(pointer));
+  return pointer;
+}
+
+void* realloc(void* pointer, size_t size) {
+  size_t before = (pointer != NULL) ? malloc_usable_size(pointer) : 0;
+  void* moved = __libc_realloc(pointer, size);
+  if (moved != NULL || size == 0) heapSub(before);
+  if (moved != NULL) heapAdd(malloc_usable_size(moved));
+  return moved;
+}
+
+void free(void* pointer) {
+  if (pointer != NULL) heapSub(malloc_usable_size(pointer));
+  __libc_free(pointer);
+}
+}
+
+static void installHeapHooks() {}
+
+bool probeHeapTracking() { return true; }
+
+#else
+static void installHeapHooks() {}
+
+bool probeHeapTracking() { return false; }
+#endif
+
+static void heapStart() {
+  installHeapHooks();
+  heapLive = 0;
+  heapPeak = 0;
+  heapCounting = true;
+}
+
+static size_t heapStop() {
+  heapCounting = false;
+  return heapPeak;
+}
+
+// --- Checks -----------------------------------------------------------------
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedUs(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static bool sameDeparture(const Departure& a, const Departure& b) {
+  return strcmp(a.direction, b.direction) == 0 && a.schedHour == b.schedHour && a.schedMinute == b.schedMinute &&
+         a.realHour == b.realHour && a.realMinute == b.realMinute && a.delayMin == b.delayMin &&
+         a.countdown == b.countdown && a.valid == b.valid;
+}
+
+static bool wellFormed(const Departure* departures, int count, int maxResults) {
+  if (count < 0 || count > maxResults) return false;
+  for (int i = 0; i < count; i++) {
+    if (memchr(departures[i].direction, '\0', sizeof(departures[i].direction)) == NULL) return false;
+  }
+  return true;
+}
+
+// Filter identities that hold for any direction: a trailing empty keyword
+// changes nothing, and excluding the direction itself rejects it.
+static const char* checkFilter(const char* direction, const std::string& filter) {
+  bool matches = matchesDirectionFilter(direction, filter.c_str());
+  if (!filter.empty() && matchesDirectionFilter(direction, (filter + ",").c_str()) != matches) {
+    return "trailing empty keyword changed the filter result";
+  }
+  size_t length = strlen(direction);
+  bool plainTerm = length > 0 && strchr(direction, ',') == NULL && direction[length - 1] != ' ' &&
+                   direction[length - 1] != '\t';
+  if (plainTerm && matchesDirectionFilter(direction, (filter + ",!" + direction).c_str())) {
+    return "excluding the direction itself did not reject it";
+  }
+  return NULL;
+}
+
+double probeParseUs(const ParseCost& cost) {
+  double slowest = cost.pushUs;
+  if (cost.pullUs > slowest) slowest = cost.pullUs;
+  if (cost.domUs > slowest) slowest = cost.domUs;
+  return slowest;
+}
+
+const char* probeParse(const uint8_t* data, size_t size, int runs, ParseCost* cost) {
+  const char* newline = (const char*)memchr(data, '\n', size);
+  std::string filter = newline ? std::string((const char*)data, newline - (const char*)data) : std::string();
+  size_t bodyStart = newline ? (size_t)(newline - (const char*)data) + 1 : 0;
+  std::string body((const char*)data + bodyStart, size - bodyStart);
+  body.resize(strlen(body.c_str()));  // up to the first NUL
+  filter.resize(strlen(filter.c_str()));
+
+  static Departure pushed[PROBE_MAX_RESULTS];
+  static Departure pulled[PROBE_MAX_RESULTS];
+  static Departure whole[PROBE_MAX_RESULTS];
+  static char element[4096];  // FetchCycle::kElementBufferSize
+  // Vary how the body is cut into pieces with the input, like socket reads.
+  size_t piece = 1 + size % 97;
+
+  memset(cost, 0, sizeof(*cost));
+  cost->pushUs = cost->pullUs = cost->domUs = cost->filterUs = 1e30;
+  if (runs < 1) runs = 1;
+
+  int pulledCount = 0, wholeCount = 0, displayable = 0;
+  ParseError pulledError = PARSE_OK;
+  for (int run = 0; run < runs; run++) {
+    DeparturePushParser parser(pushed, PROBE_MAX_RESULTS, element, sizeof(element));
+    heapStart();
+    Clock::time_point start = Clock::now();
+    for (size_t pos = 0; pos < body.size() && !parser.finished(); pos += piece) {
+      size_t n = (piece < body.size() - pos) ? piece : body.size() - pos;
+      parser.feed((const uint8_t*)body.data() + pos, n);
+    }
+    parser.finish();
+    double us = elapsedUs(start);
+    size_t heap = heapStop();
+    if (us < cost->pushUs) cost->pushUs = us;
+    if (heap > cost->heapPeak) cost->heapPeak = heap;
+    cost->poolPeak = parser.poolPeak();
+    cost->elementPeak = parser.elementPeak();
+    cost->count = parser.count();
+    cost->error = parser.error();
+
+    heapStart();
+    start = Clock::now();
+    pulledError = parseDeparturesJsonIncrementalInto(body.c_str(), pulled, PROBE_MAX_RESULTS, &pulledCount);
+    us = elapsedUs(start);
+    heap = heapStop();
+    if (us < cost->pullUs) cost->pullUs = us;
+    if (heap > cost->heapPeak) cost->heapPeak = heap;
+
+    heapStart();
+    start = Clock::now();
+    parseDeparturesJsonInto(body.c_str(), whole, PROBE_MAX_RESULTS, &wholeCount);
+    us = elapsedUs(start);
+    heap = heapStop();
+    if (us < cost->domUs) cost->domUs = us;
+    if (heap > cost->heapPeak) cost->heapPeak = heap;
+
+    start = Clock::now();
+    displayable = countDisplayableDepartures(pushed, cost->count, filter.c_str());
+    us = elapsedUs(start);
+    if (us < cost->filterUs) cost->filterUs = us;
+  }
+
+  if (!wellFormed(pushed, cost->count, PROBE_MAX_RESULTS)) return "push parser entry out of bounds";
+  if (!wellFormed(pulled, pulledCount, PROBE_MAX_RESULTS)) return "pull parser entry out of bounds";
+  // The whole-document parse is only held to bounds: with one pool for the
+  // whole body it legitimately fails where the incremental parsers do not.
+  if (!wellFormed(whole, wholeCount, PROBE_MAX_RESULTS)) return "whole-document entry out of bounds";
+
+  // The push parser is the pull parser fed in pieces, so they agree exactly:
+  // both copy kept strings into the same element pool, so both run out of
+  // pool on the same elements. The exception is the push parser's element
+  // buffer, which can run out on an element whose kept members would still
+  // fit the pool: then only the entries before it count.
+  if (cost->error == PARSE_ERR_NO_MEMORY) {
+    if (pulledCount < cost->count) return "pull parser stopped before the push parser's NO_MEMORY";
+  } else {
+    if (pulledError != cost->error) return "push and pull outcomes differ";
+    if (pulledCount != cost->count) return "push and pull counts differ";
+  }
+  for (int i = 0; i < cost->count; i++) {
+    if (!sameDeparture(pushed[i], pulled[i])) return "push and pull entries differ";
+  }
+
+  if (displayable < 0 || displayable > cost->count) return "displayable count out of range";
+  for (int i = 0; i < cost->count; i++) {
+    const char* why = checkFilter(pushed[i].direction, filter);
+    if (why != NULL) return why;
+  }
+  return NULL;
+}
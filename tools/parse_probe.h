@@ -0,0 +1,45 @@
+// One input through every departure parser and the direction filter: checks
+// that the parsers agree and measures what the input cost. Shared by the
+// libFuzzer target (parse_fuzz) and the corpus replay (parse_replay).
+//
+// Input layout: the direction filter up to the first '\n', then the response
+// body. An input without '\n' is all body, with an empty filter. The body
+// ends at its first NUL byte, as it would for the C-string parsers.
+
+#ifndef PARSE_PROBE_H
+#define PARSE_PROBE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../src/departure_logic.h"
+
+// Departures asked of every parser: the firmware's largest request limit.
+#define PROBE_MAX_RESULTS 30
+
+// What one input cost. Times are the best of the probe's runs.
+struct ParseCost {
+  double pushUs;       // DeparturePushParser, fed in pieces (the firmware path)
+  double pullUs;       // parseDeparturesJsonIncremental
+  double domUs;        // parseDeparturesJson (filtered whole-document deserialize)
+  double filterUs;     // countDisplayableDepartures over the push parser's entries
+  size_t poolPeak;     // largest element pool use, strings copied (same for push and pull)
+  size_t elementPeak;  // largest trimmed element the push parser copied
+  size_t heapPeak;     // most heap in use at once during the parses; 0 if not measured
+  int count;           // entries from the push parser
+  ParseError error;    // outcome of the push parser
+};
+
+// Slowest of the parsers on this input.
+double probeParseUs(const ParseCost& cost);
+
+// Whether this build measures heapPeak (sanitizer hooks or glibc malloc).
+bool probeHeapTracking();
+
+// Run data through the parsers runs times (at least once).
+//
+// Returns NULL if the parsers agree and every result is well-formed, else a
+// static description of the first check that failed.
+const char* probeParse(const uint8_t* data, size_t size, int runs, ParseCost* cost);
+
+#endif  // PARSE_PROBE_H
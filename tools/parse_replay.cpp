@@ -0,0 +1,205 @@
+// Replays the parser regression corpus against time and memory budgets, and
+// minimizes new worst-case inputs from the fuzzer into it.
+//
+// Usage: parse_replay [--runs N] [--max-us N] [--us-per-kb N] [--max-heap N]
+//                     [--max-pool N] FILE|DIR...
+//        parse_replay --minimize time|heap|pool INPUT CORPUS_DIR
+//
+// Replay runs every input through parse_probe (best of --runs runs) and fails
+// if the parsers disagree or an input exceeds a budget: parse time above
+// max-us + us-per-kb per KiB of input, heap peak above max-heap, or element
+// pool use above max-pool. Times are host times, for catching regressions;
+// the ESP32 at 240 MHz is roughly ten times slower.
+//
+// Minimize drops byte ranges from INPUT for as long as the parsers still
+// agree and the chosen measure stays within 10% of the original, then writes
+// the result to CORPUS_DIR/<measure>-<hash>.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "parse_probe.h"
+
+struct Budget {
+  int runs;
+  double maxUs;
+  double usPerKb;
+  size_t maxHeap;
+  size_t maxPool;
+};
+
+static bool readFile(const std::string& path, std::string* data) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL) return false;
+  char buffer[4096];
+  size_t n;
+  data->clear();
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) data->append(buffer, n);
+  fclose(file);
+  return true;
+}
+
+// Files given directly, and the regular files of given directories, sorted
+// per directory so the report is stable.
+static void collectInputs(const char* path, std::vector<std::string>* inputs) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    fprintf(stderr, "parse_replay: cannot open %s\n", path);
+    exit(2);
+  }
+  if (!S_ISDIR(info.st_mode)) {
+    inputs->push_back(path);
+    return;
+  }
+  DIR* dir = opendir(path);
+  if (dir == NULL) return;
+  std::vector<std::string> names;
+  for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+    if (entry->d_name[0] == '.') continue;  // ., .. and hidden files (.gitkeep)
+    names.push_back(std::string(path) + "/" + entry->d_name);
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  inputs->insert(inputs->end(), names.begin(), names.end());
+}
+
+static const char* baseName(const std::string& path) {
+  size_t slash = path.rfind('/');
+  return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+static int replay(const std::vector<std::string>& inputs, const Budget& budget) {
+  printf("%-28s %8s %9s %9s %9s %6s %7s  %s\n", "input", "bytes", "push us", "pull us", "whole us", "pool",
+         "heap", "result");
+  int failures = 0;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    std::string data;
+    if (!readFile(inputs[i], &data)) {
+      fprintf(stderr, "parse_replay: cannot read %s\n", inputs[i].c_str());
+      failures++;
+      continue;
+    }
+    ParseCost cost;
+    const char* why = probeParse((const uint8_t*)data.data(), data.size(), budget.runs, &cost);
+    double limitUs = budget.maxUs + budget.usPerKb * (double)data.size() / 1024;
+    std::string verdict = "ok";
+    if (why != NULL) {
+      verdict = why;
+    } else if (probeParseUs(cost) > limitUs) {
+      char text[64];
+      snprintf(text, sizeof(text), "over time budget (%.0f us)", limitUs);
+      verdict = text;
+    } else if (cost.heapPeak > budget.maxHeap) {
+      verdict = "over heap budget";
+    } else if (cost.poolPeak > budget.maxPool) {
+      verdict = "over pool budget";
+    }
+    if (verdict != "ok") failures++;
+    printf("%-28.28s %8zu %9.1f %9.1f %9.1f %6zu %7zu  %s\n", baseName(inputs[i]), data.size(), cost.pushUs,
+           cost.pullUs, cost.domUs, cost.poolPeak, cost.heapPeak, verdict.c_str());
+  }
+  if (!probeHeapTracking()) printf("(heap peak not measured in this build)\n");
+  printf("\n%zu inputs, %d failed\n", inputs.size(), failures);
+  return failures ? 1 : 0;
+}
+
+// The measure a minimization keeps; < 0 if the parsers disagree on data.
+static double measure(const std::string& data, const std::string& name) {
+  ParseCost cost;
+  if (probeParse((const uint8_t*)data.data(), data.size(), 5, &cost) != NULL) return -1;
+  if (name == "heap") return (double)cost.heapPeak;
+  if (name == "pool") return (double)cost.poolPeak;
+  return probeParseUs(cost);
+}
+
+static uint32_t fnv1a(const std::string& data) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < data.size(); i++) hash = (hash ^ (uint8_t)data[i]) * 16777619u;
+  return hash;
+}
+
+static int minimize(const std::string& name, const char* inputPath, const char* corpusDir) {
+  if (name != "time" && name != "heap" && name != "pool") {
+    fprintf(stderr, "parse_replay: unknown measure %s (time, heap or pool)\n", name.c_str());
+    return 2;
+  }
+  std::string data;
+  if (!readFile(inputPath, &data)) {
+    fprintf(stderr, "parse_replay: cannot read %s\n", inputPath);
+    return 2;
+  }
+  double original = measure(data, name);
+  if (original < 0) {
+    fprintf(stderr, "parse_replay: %s makes the parsers disagree; keep it as a crash, not a benchmark\n", inputPath);
+    return 1;
+  }
+
+  // Halve the chunk size each pass; drop any chunk whose removal keeps the
+  // measure. Bounded so a large input does not take hours.
+  const int kMaxProbes = 20000;
+  int probes = 0;
+  for (size_t chunk = data.size() / 2; chunk > 0 && probes < kMaxProbes; chunk /= 2) {
+    for (size_t at = 0; at + chunk <= data.size() && probes < kMaxProbes;) {
+      std::string candidate = data.substr(0, at) + data.substr(at + chunk);
+      probes++;
+      if (measure(candidate, name) >= original * 0.9) {
+        data = candidate;
+      } else {
+        at += chunk;
+      }
+    }
+  }
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s-%08x", corpusDir, name.c_str(), (unsigned)fnv1a(data));
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "parse_replay: cannot write %s\n", path);
+    return 2;
+  }
+  fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+  printf("%s: %s %.0f -> %.0f, %zu bytes -> %s\n", inputPath, name.c_str(), original, measure(data, name),
+         data.size(), path);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc == 5 && strcmp(argv[1], "--minimize") == 0) return minimize(argv[2], argv[3], argv[4]);
+
+  Budget budget = {5, 5000, 100, 20 * 1024, 1024};
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (strcmp(arg, "--runs") == 0 && hasValue) {
+      budget.runs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--max-us") == 0 && hasValue) {
+      budget.maxUs = atof(argv[++i]);
+    } else if (strcmp(arg, "--us-per-kb") == 0 && hasValue) {
+      budget.usPerKb = atof(argv[++i]);
+    } else if (strcmp(arg, "--max-heap") == 0 && hasValue) {
+      budget.maxHeap = (size_t)atol(argv[++i]);
+    } else if (strcmp(arg, "--max-pool") == 0 && hasValue) {
+      budget.maxPool = (size_t)atol(argv[++i]);
+    } else if (arg[0] == '-') {
+      fprintf(stderr, "usage: parse_replay [--runs N] [--max-us N] [--us-per-kb N] [--max-heap N] [--max-pool N]"
+                      " FILE|DIR...\n       parse_replay --minimize time|heap|pool INPUT CORPUS_DIR\n");
+      return 2;
+    } else {
+      collectInputs(arg, &inputs);
+    }
+  }
+  if (inputs.empty()) {
+    fprintf(stderr, "parse_replay: no inputs\n");
+    return 2;
+  }
+  return replay(inputs, budget);
+}
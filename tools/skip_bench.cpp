@@ -0,0 +1,114 @@
+// Host benchmark for reaching departureList in an EFA-sized response.
+//
+// Usage: skip_bench [iterations]
+//
+// Builds a ~167 KB body shaped like the EFA departure monitor response (a
+// large servingLines/parameters preamble, then departureList) and times:
+//   - the filtered whole-document deserialize (parseDeparturesJson)
+//   - the incremental parse, whose preamble skip goes through JsonSkipper
+//   - JsonSkipper::scan against scanBytewise on the preamble alone
+// Each figure is the best of the given number of runs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include "../src/departure_logic.h"
+#include "../src/json_skip.h"
+
+static std::string buildPreamble(size_t targetBytes) {
+  std::string json = "\"servingLines\": { \"lines\": [";
+  char entry[512];
+  for (int i = 0; json.size() < targetBytes; i++) {
+    snprintf(entry, sizeof(entry),
+             "%s{ \"mode\": { \"name\": \"Stra\\u00dfenbahn\", \"number\": \"%d\", \"desc\": \"[Freiburg] {Linie %d}\","
+             " \"diva\": { \"branch\": \"%d\", \"line\": \"%05d\", \"stateless\": \"vag:%d:\\\"H\\\":j24\" } },"
+             " \"index\": \"%d:0\", \"attrs\": [ { \"name\": \"x\", \"value\": \"]}\" } ] }",
+             i > 0 ? ", " : "", i % 9, i % 9, i, i, i, i);
+    json += entry;
+  }
+  return json + "] }";
+}
+
+static std::string buildBody(const std::string& preamble, int entries) {
+  std::string json = "{ \"parameters\": [ { \"name\": \"serverID\", \"value\": \"EFA10_04\" } ], " + preamble +
+                     ", \"departureList\": [";
+  char entry[320];
+  for (int i = 0; i < entries; i++) {
+    snprintf(entry, sizeof(entry),
+             "%s{ \"countdown\": \"%d\", \"dateTime\": { \"hour\": \"17\", \"minute\": \"%d\" },"
+             "\"realDateTime\": { \"hour\": \"17\", \"minute\": \"%d\" },"
+             "\"servingLine\": { \"number\": \"3\", \"direction\": \"Dir%d\", \"realtime\": \"1\" } }",
+             i > 0 ? "," : "", i, i % 60, (i + 2) % 60, i);
+    json += entry;
+  }
+  return json + "] }";
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedUs(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static void report(const char* name, size_t bytes, double bestUs) {
+  printf("%-28s %9.1f us  %8.1f MB/s\n", name, bestUs, bytes / bestUs);
+}
+
+int main(int argc, char** argv) {
+  int iterations = (argc > 1) ? atoi(argv[1]) : 50;
+  if (iterations < 1) iterations = 1;
+
+  std::string preamble = "{" + buildPreamble(160 * 1024) + "}";
+  std::string body = buildBody(buildPreamble(160 * 1024), 40);
+  printf("body %zu bytes, preamble %zu bytes, best of %d\n\n", body.size(), preamble.size(), iterations);
+
+  double domUs = 1e30, incrementalUs = 1e30, swarUs = 1e30, bytewiseUs = 1e30;
+  int domCount = 0, incrementalCount = 0;
+  for (int i = 0; i < iterations; i++) {
+    Clock::time_point start = Clock::now();
+    DeparturesResult dom = parseDeparturesJson(body.c_str(), 10);
+    double us = elapsedUs(start);
+    if (us < domUs) domUs = us;
+    domCount = dom.count;
+
+    start = Clock::now();
+    DeparturesResult incremental = parseDeparturesJsonIncremental(body.c_str(), 10);
+    us = elapsedUs(start);
+    if (us < incrementalUs) incrementalUs = us;
+    incrementalCount = incremental.count;
+
+    JsonSkipper skipper;
+    start = Clock::now();
+    size_t swarBytes = skipper.scan((const uint8_t*)preamble.data(), preamble.size());
+    us = elapsedUs(start);
+    if (us < swarUs) swarUs = us;
+
+    skipper.reset();
+    start = Clock::now();
+    size_t bytewiseBytes = skipper.scanBytewise((const uint8_t*)preamble.data(), preamble.size());
+    us = elapsedUs(start);
+    if (us < bytewiseUs) bytewiseUs = us;
+
+    if (swarBytes != preamble.size() || bytewiseBytes != preamble.size()) {
+      fprintf(stderr, "skip_bench: skipper stopped at %zu/%zu of %zu bytes\n", swarBytes, bytewiseBytes,
+              preamble.size());
+      return 1;
+    }
+  }
+
+  if (domCount != incrementalCount) {
+    fprintf(stderr, "skip_bench: parsers disagree (%d vs %d departures)\n", domCount, incrementalCount);
+    return 1;
+  }
+
+  report("filtered deserialize", body.size(), domUs);
+  report("incremental + JsonSkipper", body.size(), incrementalUs);
+  report("preamble, scan()", preamble.size(), swarUs);
+  report("preamble, scanBytewise()", preamble.size(), bytewiseUs);
+  printf("\nincremental speedup %.1fx, skip speedup %.1fx\n", domUs / incrementalUs, bytewiseUs / swarUs);
+  return 0;
+}